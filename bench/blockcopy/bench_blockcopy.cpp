@@ -0,0 +1,189 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+/* About bench_blockcopy:
+ *
+ * Copy data with QP_BlockCopy inside an image file and print the MB/s for
+ * every queue depth and block size of BLOCKCOPY_DEPTHS x BLOCKCOPY_SIZES:
+ *
+ *   forward  the source to a place after it, without overlap
+ *   overlap  the source moved right by BLOCKCOPY_SHIFT (copied backward)
+ *
+ * Before every copy the source is written again with a pattern (the first
+ * 8 bytes of every sector tell the sector and the run), and after it the
+ * destination is checked: a wrong sector fail the benchmark.
+ *
+ * The image must be on the disk to measure, not on a tmpfs (no O_DIRECT).
+ *
+ *   bench_blockcopy [image, default BLOCKCOPY_IMAGE] [MB to copy, default BLOCKCOPY_MB]
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <QElapsedTimer>
+#include <QVector>
+#include "qp_blockcopy.h"
+#include "qp_devlist.h"
+
+#define BLOCKCOPY_IMAGE "/var/tmp/qparted-bench.img"
+#define BLOCKCOPY_MB    512
+#define BLOCKCOPY_SHIFT (1024 * 1024)	/*---bytes of the overlapping move---*/
+#define BLOCKCOPY_CHUNK (4 * 1024 * 1024)	/*---bytes of the pattern writes---*/
+#define BLOCKCOPY_SECTOR 512
+
+static const int depths[] = { 1, 4, 8, 16 };
+static const int sizes[] = { 256 * 1024, 1024 * 1024, 4 * 1024 * 1024 };
+
+static uint64_t tag(int run, PedSector sector) {
+	return ((uint64_t)run << 40) | (uint64_t)sector;
+}
+
+/*---the pattern in the sectors [start, start + count)---*/
+static bool pattern(int fd, PedSector start, PedSector count, int run) {
+	QVector<char> chunk(BLOCKCOPY_CHUNK, 0);
+	PedSector perChunk = BLOCKCOPY_CHUNK / BLOCKCOPY_SECTOR;
+
+	for (PedSector s = 0; s < count; s += perChunk) {
+		PedSector n = qMin(perChunk, count - s);
+
+		for (PedSector i = 0; i < n; i++) {
+			uint64_t t = tag(run, s + i);
+			memcpy(chunk.data() + i * BLOCKCOPY_SECTOR, &t, sizeof(t));
+		}
+
+		if (pwrite(fd, chunk.constData(), n * BLOCKCOPY_SECTOR, (start + s) * BLOCKCOPY_SECTOR)
+		    != n * BLOCKCOPY_SECTOR)
+			return false;
+	}
+
+	return fsync(fd) == 0;
+}
+
+/*---the sectors [start, start + count) must have the pattern of the source---*/
+static bool check(int fd, PedSector start, PedSector count, int run) {
+	QVector<char> chunk(BLOCKCOPY_CHUNK, 0);
+	PedSector perChunk = BLOCKCOPY_CHUNK / BLOCKCOPY_SECTOR;
+
+	for (PedSector s = 0; s < count; s += perChunk) {
+		PedSector n = qMin(perChunk, count - s);
+
+		if (pread(fd, chunk.data(), n * BLOCKCOPY_SECTOR, (start + s) * BLOCKCOPY_SECTOR)
+		    != n * BLOCKCOPY_SECTOR)
+			return false;
+
+		for (PedSector i = 0; i < n; i++) {
+			uint64_t t;
+			memcpy(&t, chunk.constData() + i * BLOCKCOPY_SECTOR, sizeof(t));
+			if (t != tag(run, s + i)) {
+				printf("sector %lld: found %llx, expected %llx\n", start + s + i,
+				       (unsigned long long)t, (unsigned long long)tag(run, s + i));
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/*---copy count sectors from 0 to "to", return the MB/s (-1 on error)---*/
+static double run(PedDevice *dev, int fd, int depth, int size, PedSector to, PedSector count, int id) {
+	if (!pattern(fd, 0, count, id)) {
+		printf("cannot write the pattern: %s\n", strerror(errno));
+		return -1;
+	}
+
+	QP_BlockCopy blockcopy(dev, depth, size);
+	QElapsedTimer timer;
+	timer.start();
+
+	if (!blockcopy.copy(0, to, count, NULL)) {
+		printf("copy failed: %s\n", blockcopy.message().toLatin1().data());
+		return -1;
+	}
+
+	qint64 nsecs = timer.nsecsElapsed();
+
+	if (!check(fd, to, count, id))
+		return -1;
+
+	return (count * (double)BLOCKCOPY_SECTOR / (1024 * 1024)) / (nsecs / 1e9);
+}
+
+int main(int argc, char *argv[]) {
+	QString image = (argc > 1) ? argv[1] : BLOCKCOPY_IMAGE;
+	long long mb = (argc > 2) ? atoll(argv[2]) : BLOCKCOPY_MB;
+	if (mb < 1)
+		mb = BLOCKCOPY_MB;
+
+	PedSector count = mb * 1024 * 1024 / BLOCKCOPY_SECTOR;
+	PedSector shift = BLOCKCOPY_SHIFT / BLOCKCOPY_SECTOR;
+
+	/*---the source, then the forward destination---*/
+	int fd = open(image.toLatin1().constData(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if ((fd < 0) || (ftruncate(fd, 2 * count * BLOCKCOPY_SECTOR) != 0)) {
+		printf("cannot make %s: %s\n", image.toLatin1().data(), strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	QP_DevList::pedListMutex()->lock();
+	PedDevice *dev = ped_device_get(image.toLatin1().constData());
+	QP_DevList::pedListMutex()->unlock();
+
+	if (!dev) {
+		printf("libparted cannot open %s\n", image.toLatin1().data());
+		close(fd);
+		unlink(image.toLatin1().constData());
+		return EXIT_FAILURE;
+	}
+
+	printf("%s, %lld MB, backend %s\n\n", image.toLatin1().data(), mb,
+	       QP_BlockCopy(dev).backend());
+	printf("depth  block KB   forward MB/s   overlap MB/s\n");
+
+	bool ok = true;
+	int id = 1;
+
+	for (int depth : depths) {
+		for (int size : sizes) {
+			double forward = run(dev, fd, depth, size, count, count, id++);
+			double overlap = run(dev, fd, depth, size, shift, count, id++);
+
+			printf("%5d  %8d  %13.1f  %13.1f\n", depth, size / 1024, forward, overlap);
+
+			if ((forward < 0) || (overlap < 0))
+				ok = false;
+		}
+	}
+
+	QP_DevList::pedListMutex()->lock();
+	ped_device_destroy(dev);
+	QP_DevList::pedListMutex()->unlock();
+
+	close(fd);
+	unlink(image.toLatin1().constData());
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
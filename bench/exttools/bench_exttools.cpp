@@ -0,0 +1,132 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+
+/* About bench_exttools:
+ *
+ * Build the filesystem wrappers the way QP_LibParted::get_filesystem does
+ * at startup, every time with a new QP_ListExternalTools (so every tool is
+ * looked for again), and print how long it takes. Next to it, the time of
+ * what the wrappers did before the registry: one "which" process for every
+ * tool they check.
+ *
+ *   bench_exttools [runs, default EXTTOOLS_RUNS]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QVector>
+#include "qp_common.h"
+#include "qp_exttools.h"
+#include "qp_fswrap.h"
+#include "qp_process.h"
+
+#define EXTTOOLS_RUNS 20
+
+/*---the filesystems of get_filesystem, and ntfs---*/
+static const char *filesystems[] = {
+	"ext2", "ext3", "ext4", "btrfs", "jfs", "xfs", "reiserfs", "swap",
+	"fat", "fat16", "fat32", "ntfs"
+};
+
+/*---the tools every wrapper check, in the order of the filesystems---*/
+static const char *checks[] = {
+	"mkfs.ext2", "mkfs.ext3", "mkfs.ext4", "mkfs.btrfs", "mkfs.jfs",
+	"mkfs.xfs", "xfs_growfs", "mkswap", "mkdosfs", "mkdosfs", "mkdosfs",
+	"mkntfs", "ntfsresize"
+};
+
+/*---a registry like the one of QP_Settings without a configured path---*/
+static void newRegistry() {
+	static const char *tools[] = {
+		"mkntfs", "ntfsresize", "mkfs.ext3", "mkfs.jfs", "mkfs.xfs", "mount",
+		"umount", "xfs_growfs", "mkswap", "mkfs.ext2", "mkfs.ext4",
+		"mkfs.btrfs", "mkdosfs"
+	};
+
+	delete lstExternalTools;
+	lstExternalTools = new QP_ListExternalTools();
+	for (const char *tool : tools)
+		lstExternalTools->add(tool, QString(), QString());
+}
+
+static qint64 wrappers() {
+	QElapsedTimer timer;
+	timer.start();
+
+	newRegistry();
+	for (const char *fs : filesystems)
+		delete QP_FSWrap::fswrap(fs);
+
+	return timer.nsecsElapsed();
+}
+
+static qint64 which() {
+	QElapsedTimer timer;
+	timer.start();
+
+	for (const char *tool : checks) {
+		QP_Process process;
+		QByteArray line;
+
+		if (!process.start(QStringList() << "which" << tool))
+			continue;
+		while (process.getLine(&line))
+			;
+		process.wait();
+	}
+
+	return timer.nsecsElapsed();
+}
+
+/*---median and best of the runs, in msecs---*/
+static void print(const char *name, QVector<qint64> nsecs) {
+	std::sort(nsecs.begin(), nsecs.end());
+	printf("%-9s median %8.3f msecs  best %8.3f msecs\n", name,
+	       nsecs[nsecs.size() / 2] / 1e6, nsecs[0] / 1e6);
+}
+
+int main(int argc, char **argv) {
+	int runs = (argc > 1) ? atoi(argv[1]) : EXTTOOLS_RUNS;
+	QVector<qint64> registry, processes;
+
+	if (runs < 1) {
+		fprintf(stderr, "usage: %s [runs]\n", argv[0]);
+		return 1;
+	}
+
+	for (int run = 0; run < runs; run++) {
+		registry << wrappers();
+		processes << which();
+	}
+
+	printf("%d wrappers, %d tools checked, %d runs\n",
+	       (int)(sizeof(filesystems) / sizeof(filesystems[0])),
+	       (int)(sizeof(checks) / sizeof(checks[0])), runs);
+	print("registry", registry);
+	print("which", processes);
+
+	return 0;
+}
@@ -0,0 +1,131 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+/* About bench_fatcount:
+ *
+ * Count the free clusters of a FAT16 and a FAT32 table in memory with every
+ * implementation of QP_FSFat::count_free_clusters the cpu has, and print the
+ * speed of each (the best of FATCOUNT_RUNS runs) next to the scalar loop.
+ * All of them must find the same count, or the benchmark fail.
+ *
+ *   bench_fatcount [MB of table, default FATCOUNT_MB]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <QElapsedTimer>
+#include <QVector>
+#include "qp_fswrap.h"
+
+#define FATCOUNT_MB   256	/*---the FAT32 table of a ~2TB volume---*/
+#define FATCOUNT_RUNS 5
+#define FATCOUNT_FREE 30	/*---percent of free clusters---*/
+
+static const char *impls[] = { "scalar", "sse2", "avx2" };
+
+/*---a table with FATCOUNT_FREE% zero entries, in runs like a used volume---*/
+static void fill(QVector<uint8_t> &table, int bits) {
+	const int bytes = bits / 8;
+	uint64_t entries = table.size() / bytes;
+	uint32_t seed = 1;
+
+	for (uint64_t i = 0; i < entries; ) {
+		seed = seed * 1103515245 + 12345;
+		uint64_t run = 1 + (seed >> 16) % 64;
+		bool free = ((seed >> 8) % 100) < FATCOUNT_FREE;
+
+		for (; run && (i < entries); run--, i++) {
+			uint32_t value = free ? 0 : (uint32_t)(i + 1);
+			if ((bits == 32) && !free)
+				value |= 0xF0000000;	/*---the high 4 bits are not part of the entry---*/
+			for (int b = 0; b < bytes; b++)
+				table[i * bytes + b] = (value >> (8 * b)) & 0xFF;
+			if (!free && (value & ((bits == 16) ? 0xFFFF : 0x0FFFFFFF)) == 0)
+				table[i * bytes] = 1;
+		}
+	}
+}
+
+static bool bench(int bits, uint64_t bytes) {
+	QVector<uint8_t> table(bytes);
+	uint64_t entries = bytes / (bits / 8);
+	uint64_t expected = 0;
+	double scalar = 0;
+	bool ok = true;
+
+	fill(table, bits);
+
+	for (const char *impl : impls) {
+		uint64_t count = 0;
+		qint64 best = -1;
+
+		for (int run = 0; run < FATCOUNT_RUNS; run++) {
+			QElapsedTimer timer;
+			timer.start();
+
+			if (!QP_FSFat::count_free_clusters(table.constData(), entries, bits, impl, &count)) {
+				printf("FAT%d  %-7s not supported by this cpu\n", bits, impl);
+				break;
+			}
+
+			qint64 nsecs = timer.nsecsElapsed();
+			if ((best < 0) || (nsecs < best))
+				best = nsecs;
+		}
+
+		if (best < 0)
+			continue;
+
+		double rate = (bytes / (1024.0 * 1024.0)) / (best / 1e9);
+		if (!strcmp(impl, "scalar")) {
+			expected = count;
+			scalar = rate;
+		}
+
+		printf("FAT%d  %-7s %10.1f MB/s  x%-5.2f %llu free of %llu%s\n",
+		       bits, impl, rate, rate / scalar,
+		       (unsigned long long)count, (unsigned long long)entries,
+		       (count == expected) ? "" : "  WRONG");
+
+		if (count != expected)
+			ok = false;
+	}
+
+	return ok;
+}
+
+int main(int argc, char *argv[]) {
+	uint64_t mb = (argc > 1) ? strtoull(argv[1], NULL, 10) : FATCOUNT_MB;
+	if (!mb)
+		mb = FATCOUNT_MB;
+
+	printf("%llu MB table, best of %d runs, selected: %s\n",
+	       (unsigned long long)mb, FATCOUNT_RUNS, QP_FSFat::count_free_clusters_impl());
+
+	/*---not a multiple of the vector size: the scalar tail is used too---*/
+	uint64_t bytes = mb * 1024 * 1024 - 4;
+	bool ok = bench(16, bytes);
+	ok = bench(32, bytes) && ok;
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
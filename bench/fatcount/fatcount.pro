@@ -0,0 +1,34 @@
+#    qparted - a frontend to libparted for manipulating disk partitions
+#    Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+#
+#    Vanni Brutto <zanac (-at-) libero dot it>
+#
+#    This program is free software; you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation; either version 2 of the License, or
+#    (at your option) any later version.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program; if not, write to the Free Software
+#    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#
+# Free cluster counting of a FAT table: scalar, SSE2 and AVX2
+#
+
+
+TEMPLATE     = app
+
+include(../../qparted.pri)
+
+CONFIG      += console release
+CONFIG      -= app_bundle
+
+TARGET       = bench_fatcount
+
+SOURCES     += bench_fatcount.cpp
@@ -0,0 +1,123 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+
+/* About bench_listchart:
+ *
+ * Lay out synthetic tables of LISTCHART_PARTS partitions (a GPT disk full
+ * of them) for every width from LISTCHART_FROM to LISTCHART_TO pixels, like
+ * dragging the border of the window on a 4K screen, and print the time of
+ * a layout with QP_ListChart::proportional and with the loop it replaced
+ * (a pixel at a time to every partition in turn, until the chart is full).
+ *
+ *   bench_listchart [tables, default LISTCHART_TABLES]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <QElapsedTimer>
+#include <QVector>
+#include "qp_listchart.h"
+
+#define LISTCHART_PARTS    128
+#define LISTCHART_TABLES   10
+#define LISTCHART_FROM     2560
+#define LISTCHART_TO       3840
+#define LISTCHART_MINWIDTH 16
+
+/*---the old QP_ListChart::draw: every partition start at the minimum, and
+ *   take one more pixel per round while it is under its share + 1---*/
+static QVector<int> pixelLoop(const QVector<double> &sizes, int width) {
+	int n = sizes.count();
+	QVector<int> widths(n, LISTCHART_MINWIDTH);
+	double total = 0;
+	int totwidth = n * LISTCHART_MINWIDTH;
+
+	for (int i = 0; i < n; i++)
+		total += sizes.at(i);
+
+	for (int i = 0; totwidth < width; i = (i + 1) % n) {
+		int newwidth = (int)(sizes.at(i) * width / total + 1);
+		if (widths.at(i) < newwidth) {
+			widths[i]++;
+			totwidth++;
+		}
+	}
+
+	return widths;
+}
+
+/*---sizes in sectors: a few big partitions and many small ones---*/
+static QVector<double> table(uint32_t *seed) {
+	QVector<double> sizes;
+
+	for (int i = 0; i < LISTCHART_PARTS; i++) {
+		*seed = *seed * 1103515245 + 12345;
+		double size = 2048 + (*seed >> 8) % (1 << 20);
+		if ((*seed >> 4) % 16 == 0)
+			size *= 1024;
+		sizes.append(size);
+	}
+
+	return sizes;
+}
+
+int main(int argc, char **argv) {
+	int tables = (argc > 1) ? atoi(argv[1]) : LISTCHART_TABLES;
+	QVector<int> minimum(LISTCHART_PARTS, LISTCHART_MINWIDTH);
+	uint32_t seed = 1;
+	qint64 onePass = 0;
+	qint64 loop = 0;
+	long layouts = 0;
+	long checksum = 0;
+
+	if (tables < 1) {
+		fprintf(stderr, "usage: %s [tables]\n", argv[0]);
+		return 1;
+	}
+
+	for (int t = 0; t < tables; t++) {
+		QVector<double> sizes = table(&seed);
+
+		for (int width = LISTCHART_FROM; width <= LISTCHART_TO; width++) {
+			QElapsedTimer timer;
+
+			timer.start();
+			QVector<int> widths = QP_ListChart::proportional(sizes, minimum, width);
+			onePass += timer.nsecsElapsed();
+
+			timer.start();
+			QVector<int> old = pixelLoop(sizes, width);
+			loop += timer.nsecsElapsed();
+
+			checksum += widths.last() + old.last();
+			layouts++;
+		}
+	}
+
+	printf("%d partitions, %ld layouts (widths %d..%d), checksum %ld\n",
+	       LISTCHART_PARTS, layouts, LISTCHART_FROM, LISTCHART_TO, checksum);
+	printf("proportional %10.2f usecs/layout\n", onePass / 1e3 / layouts);
+	printf("pixel loop   %10.2f usecs/layout  x%.1f\n", loop / 1e3 / layouts, (double)loop / onePass);
+
+	return 0;
+}
@@ -0,0 +1,35 @@
+#    qparted - a frontend to libparted for manipulating disk partitions
+#    Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+#
+#    Vanni Brutto <zanac (-at-) libero dot it>
+#
+#    This program is free software; you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation; either version 2 of the License, or
+#    (at your option) any later version.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program; if not, write to the Free Software
+#    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#
+# Layout of a 128-partition chart while the window is resized: one
+# proportional pass against the old pixel by pixel loop
+#
+
+
+TEMPLATE     = app
+
+include(../../qparted.pri)
+
+CONFIG      += console release
+CONFIG      -= app_bundle
+
+TARGET       = bench_listchart
+
+SOURCES     += bench_listchart.cpp
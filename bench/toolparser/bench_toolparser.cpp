@@ -0,0 +1,255 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+
+/* About bench_toolparser:
+ *
+ * Every transcript of tests/toolparser is cut in lines once (by QP_Process
+ * running "cat", like a tool run by a wrapper), then its lines are given
+ * TOOLPARSER_ROUNDS times to a QP_ToolParser of its grammar and to the loop
+ * the wrapper had before it: new QRegExp objects for every line, and the
+ * line copied to replace \r and \b. The time of a line is printed for both.
+ *
+ *   bench_toolparser [rounds, default TOOLPARSER_ROUNDS]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QList>
+#include <QRegExp>
+#include "qp_process.h"
+#include "qp_toolparser.h"
+
+#define TOOLPARSER_ROUNDS 2000
+
+/*---the lines of a transcript, as QP_Process cut them---*/
+static QList<QByteArray> readLines(QString path) {
+	QList<QByteArray> lines;
+	QP_Process process;
+	QByteArray line;
+
+	if (!process.start(QStringList() << "cat" << path))
+		return lines;
+	while (process.getLine(&line))
+		lines << line;
+	process.wait();
+
+	return lines;
+}
+
+/*---the old loops of QP_FSExt2::mkpartfs, QP_FSNtfs::resize, min_size and
+ *   mkpartfs and QP_FSWrap::qpMount, without the signals: the result is
+ *   how many lines meant something---*/
+static int oldMke2fs(const QList<QByteArray> &lines) {
+	int events = 0;
+	bool writenode = false;
+
+	for (const QByteArray &cline : lines) {
+		QString line = QString(cline);
+
+		QRegExp rx;
+		rx = QRegExp("^Writing inode tables");
+		if (rx.indexIn(line) == 0)
+			writenode = true;
+
+		rx = QRegExp("^Creating journal");
+		if (rx.indexIn(line) == 0) {
+			writenode = false;
+			events++;
+		}
+
+		if (writenode) {
+			QString linesub = line;
+			linesub.replace(QChar('\b'), " ");
+			rx = QRegExp("^.* (\\d*)/(\\d*) .*$");
+			if (rx.indexIn(linesub) == 0) {
+				int iActual = rx.cap(1).toInt();
+				int iTotal = rx.cap(2).toInt();
+				if (iTotal)
+					events += (iActual * 80 / iTotal >= 0);
+			}
+		}
+
+		rx = QRegExp("^Writing superblocks and filesystem accounting information: done");
+		if (rx.indexIn(line) == 0)
+			events++;
+	}
+
+	return events;
+}
+
+static int oldNtfsresize(const QList<QByteArray> &lines) {
+	int events = 0;
+
+	for (const QByteArray &cline : lines) {
+		QString line = QString(cline);
+		QRegExp rx;
+
+		QString linesub = line;
+		linesub.replace(QChar('\r'), " ");
+		rx = QRegExp("^.* (\\d*),(\\d*) percent completed.*$");
+		if (rx.indexIn(linesub) == 0)
+			events += (rx.cap(1).toInt() >= 0);
+
+		rx = QRegExp("^.*[Ss]uccessfully.*");
+		if (rx.indexIn(line) == 0)
+			events++;
+		rx = QRegExp("^Nothing to do: NTFS volume size is already OK.");
+		if (rx.indexIn(line) == 0)
+			events++;
+
+		rx = QRegExp("^Syncing device.*");
+		if (rx.indexIn(line) == 0)
+			events++;
+
+		rx = QRegExp("^ERROR.*: (.*)");
+		if (rx.indexIn(line) == 0)
+			events += !rx.cap(1).isEmpty();
+	}
+
+	return events;
+}
+
+static int oldNtfsresizeInfo(const QList<QByteArray> &lines) {
+	int events = 0;
+
+	for (const QByteArray &cline : lines) {
+		QString line = QString(cline);
+
+		QRegExp rx;
+		rx = QRegExp("^.*You ..... resize at (\\d*) bytes or (\\d*) .*");
+		if (rx.indexIn(line) == 0)
+			events += (rx.cap(1).toLongLong() >= 0);
+	}
+
+	return events;
+}
+
+static int oldMkntfs(const QList<QByteArray> &lines) {
+	int events = 0;
+
+	for (const QByteArray &cline : lines) {
+		QString line = QString(cline);
+
+		QRegExp rx;
+		rx = QRegExp("^mkntfs completed successfully. Have a nice day.");
+		if (rx.indexIn(line) == 0)
+			events++;
+
+		rx = QRegExp("^ERROR.*: (.*)");
+		if (rx.indexIn(line) == 0)
+			events += !rx.cap(1).isEmpty();
+	}
+
+	return events;
+}
+
+static int oldMount(const QList<QByteArray> &lines) {
+	int events = 0;
+
+	for (const QByteArray &cline : lines) {
+		QString line = QString(cline);
+
+		QRegExp rx = QRegExp("^mount: (.*)$");
+		if (rx.indexIn(line) == 0)
+			events += !rx.cap(1).isEmpty();
+	}
+
+	return events;
+}
+
+static int oldParse(QString grammar, const QList<QByteArray> &lines) {
+	if (grammar == "mke2fs")
+		return oldMke2fs(lines);
+	if (grammar == "ntfsresize")
+		return oldNtfsresize(lines);
+	if (grammar == "ntfsresize-info")
+		return oldNtfsresizeInfo(lines);
+	if (grammar == "mkntfs")
+		return oldMkntfs(lines);
+	if (grammar == "mount")
+		return oldMount(lines);
+	return 0;
+}
+
+static int newParse(QString grammar, QList<QByteArray> &lines) {
+	QP_ToolParser parser(grammar.toLatin1().data());
+	QP_ToolMatch match;
+	int events = 0;
+
+	for (QByteArray &line : lines)
+		events += parser.parse(line.data(), &match);
+
+	return events;
+}
+
+int main(int argc, char **argv) {
+	int rounds = (argc > 1) ? atoi(argv[1]) : TOOLPARSER_ROUNDS;
+	QDir dir(TRANSCRIPTS);
+	QStringList files = dir.entryList(QStringList() << "*.txt", QDir::Files, QDir::Name);
+
+	if ((rounds < 1) || files.isEmpty()) {
+		fprintf(stderr, "usage: %s [rounds] (transcripts in %s)\n", argv[0], TRANSCRIPTS);
+		return 1;
+	}
+
+	printf("%-28s %6s %15s %15s %7s\n", "transcript", "lines", "parser ns/line", "QRegExp ns/line", "speedup");
+
+	qint64 newTotal = 0;
+	qint64 oldTotal = 0;
+	long linesTotal = 0;
+
+	for (const QString &file : files) {
+		QString grammar = file.section('.', 0, 0);
+		QList<QByteArray> lines = readLines(dir.filePath(file));
+		if (lines.isEmpty())
+			continue;
+
+		QElapsedTimer timer;
+		long events = 0;
+
+		timer.start();
+		for (int r = 0; r < rounds; r++)
+			events += newParse(grammar, lines);
+		qint64 newNsecs = timer.nsecsElapsed();
+
+		timer.start();
+		for (int r = 0; r < rounds; r++)
+			events += oldParse(grammar, lines);
+		qint64 oldNsecs = timer.nsecsElapsed();
+
+		long count = (long)lines.count() * rounds;
+		printf("%-28s %6d %15.1f %15.1f %6.1fx  (%ld events)\n", file.toLatin1().data(), lines.count(),
+		       (double)newNsecs / count, (double)oldNsecs / count, (double)oldNsecs / newNsecs, events);
+
+		newTotal += newNsecs;
+		oldTotal += oldNsecs;
+		linesTotal += count;
+	}
+
+	printf("%-28s %6s %15.1f %15.1f %6.1fx\n", "all", "",
+	       (double)newTotal / linesTotal, (double)oldTotal / linesTotal, (double)oldTotal / newTotal);
+
+	return 0;
+}
@@ -0,0 +1,142 @@
+#    qparted - a frontend to libparted for manipulating disk partitions
+#    Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+#
+#    Vanni Brutto <zanac (-at-) libero dot it>
+#
+#    This program is free software; you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation; either version 2 of the License, or
+#    (at your option) any later version.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program; if not, write to the Free Software
+#    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#
+# QParted sources, shared by qparted.pro and the targets in tests/ and bench/
+#
+
+
+DEFINES     += DATADIR='"\\"/usr/share/\\""'
+DEFINES     += VERSION='"\\"0.6.1\\""'
+
+
+INCLUDEPATH += $$PWD $$PWD/ui $$PWD/src $$PWD/ts
+
+# Configuration.  Remove the word 'thread' to build against non-threaded Qt.
+CONFIG      += qt thread
+
+#LIBS
+unix:LIBS   += -ldl -lparted
+QT += widgets
+
+# Header files
+HEADERS      = $$PWD/src/qparted.h              \
+               $$PWD/src/qp_common.h            \
+               $$PWD/src/qp_settings.h          \
+               $$PWD/src/qp_exttools.h          \
+               $$PWD/src/qp_libparted.h         \
+               $$PWD/src/qp_filesystem.h        \
+               $$PWD/src/qp_fswrap.h            \
+               $$PWD/src/qp_window.h            \
+               $$PWD/src/qp_dlgcreate.h         \
+               $$PWD/src/qp_dlgresize.h         \
+               $$PWD/src/qp_dlgprogress.h       \
+               $$PWD/src/qp_dlgformat.h         \
+               $$PWD/src/qp_dlgconfig.h         \
+               $$PWD/src/qp_partlist.h          \
+               $$PWD/src/qp_listview.h          \
+               $$PWD/src/qp_listchart.h         \
+               $$PWD/src/qp_partition.h         \
+               $$PWD/src/qp_partwidget.h        \
+               $$PWD/src/qp_extended.h          \
+               $$PWD/src/qp_drivelist.h         \
+               $$PWD/src/qp_navview.h           \
+               $$PWD/src/qp_diskview.h          \
+               $$PWD/src/qp_sizepart.h          \
+               $$PWD/src/qp_actlist.h           \
+               $$PWD/src/qp_scanpool.h          \
+               $$PWD/src/qp_probecache.h        \
+               $$PWD/src/qp_blockreader.h       \
+               $$PWD/src/qp_blockcopy.h         \
+               $$PWD/src/qp_batch.h             \
+               $$PWD/src/qp_commitscheduler.h   \
+               $$PWD/src/qp_process.h           \
+               $$PWD/src/qp_toolparser.h        \
+               $$PWD/src/qp_startupscan.h       \
+               $$PWD/src/qp_hotplug.h           \
+               $$PWD/src/qp_mounttable.h        \
+               $$PWD/src/qp_pedlock.h           \
+               $$PWD/src/qp_partmap.h           \
+               $$PWD/src/qp_progress.h          \
+               $$PWD/src/qp_combospin.h         \
+               $$PWD/src/qp_devlist.h           \
+               $$PWD/src/qp_spinbox.h           \
+               $$PWD/src/qp_dlgdevprop.h        \
+               $$PWD/src/qp_debug.h             \
+               $$PWD/src/statistics.h           \
+               $$PWD/src/qp_fsstats.h
+
+
+# Source files
+SOURCES      = $$PWD/src/qp_common.cpp          \
+               $$PWD/src/qp_settings.cpp        \
+               $$PWD/src/qp_exttools.cpp        \
+               $$PWD/src/qp_libparted.cpp       \
+               $$PWD/src/qp_filesystem.cpp      \
+               $$PWD/src/qp_fswrap.cpp          \
+               $$PWD/src/qp_window.cpp          \
+               $$PWD/src/qp_dlgcreate.cpp       \
+               $$PWD/src/qp_dlgresize.cpp       \
+               $$PWD/src/qp_dlgprogress.cpp     \
+               $$PWD/src/qp_dlgformat.cpp       \
+               $$PWD/src/qp_dlgconfig.cpp       \
+               $$PWD/src/qp_partlist.cpp        \
+               $$PWD/src/qp_listview.cpp        \
+               $$PWD/src/qp_listchart.cpp       \
+               $$PWD/src/qp_partition.cpp       \
+               $$PWD/src/qp_partwidget.cpp      \
+               $$PWD/src/qp_extended.cpp        \
+               $$PWD/src/qp_drivelist.cpp       \
+               $$PWD/src/qp_navview.cpp         \
+               $$PWD/src/qp_diskview.cpp        \
+               $$PWD/src/qp_sizepart.cpp        \
+               $$PWD/src/qp_actlist.cpp         \
+               $$PWD/src/qp_scanpool.cpp        \
+               $$PWD/src/qp_probecache.cpp      \
+               $$PWD/src/qp_blockreader.cpp     \
+               $$PWD/src/qp_blockcopy.cpp       \
+               $$PWD/src/qp_batch.cpp           \
+               $$PWD/src/qp_commitscheduler.cpp \
+               $$PWD/src/qp_process.cpp         \
+               $$PWD/src/qp_toolparser.cpp      \
+               $$PWD/src/qp_startupscan.cpp     \
+               $$PWD/src/qp_hotplug.cpp         \
+               $$PWD/src/qp_mounttable.cpp      \
+               $$PWD/src/qp_pedlock.cpp         \
+               $$PWD/src/qp_partmap.cpp         \
+               $$PWD/src/qp_progress.cpp        \
+               $$PWD/src/qp_combospin.cpp       \
+               $$PWD/src/qp_spinbox.cpp         \
+               $$PWD/src/qp_devlist.cpp         \
+               $$PWD/src/qp_dlgdevprop.cpp      \
+               $$PWD/src/qp_debug.cpp           \
+               $$PWD/src/statistics.cpp         \
+               $$PWD/src/qp_fsstats.cpp
+
+
+# Qt Designer interfaces
+FORMS        = $$PWD/ui/qp_ui_create.ui         \
+               $$PWD/ui/qp_ui_format.ui         \
+               $$PWD/ui/qp_ui_resize.ui         \
+               $$PWD/ui/qp_ui_progress.ui       \
+               $$PWD/ui/qp_ui_devprop.ui
+
+
+# Flags
+QMAKE_CXXFLAGS += "-pipe -Ofast -fno-sized-deallocation"
@@ -25,94 +25,15 @@
 TEMPLATE     = app
 
 
-DEFINES     += DATADIR='"\\"/usr/share/\\""'
-DEFINES     += VERSION='"\\"0.6.1\\""'
+# Sources, libraries and flags (see qparted.pri)
+include(qparted.pri)
 
-
-INCLUDEPATH += . ui src ts
-
-# Configuration.  Remove the word 'thread' to build against non-threaded Qt.
-CONFIG      += qt thread release 
-
-#LIBS
-unix:LIBS   += -ldl -lparted
-QT += widgets
+CONFIG      += release
 
 # Executable name
 TARGET       = qparted
 
-# Header files
-HEADERS      = src/qparted.h           \
-               src/qp_common.h         \
-               src/qp_settings.h       \
-               src/qp_exttools.h       \
-               src/qp_libparted.h      \
-               src/qp_filesystem.h     \
-               src/qp_fswrap.h         \
-               src/qp_window.h         \
-               src/qp_dlgcreate.h      \
-               src/qp_dlgresize.h      \
-               src/qp_dlgprogress.h    \
-               src/qp_dlgformat.h      \
-               src/qp_dlgconfig.h      \
-               src/qp_partlist.h       \
-               src/qp_listview.h       \
-               src/qp_listchart.h      \
-               src/qp_partition.h      \
-               src/qp_partwidget.h     \
-               src/qp_extended.h       \
-               src/qp_drivelist.h      \
-               src/qp_navview.h        \
-               src/qp_diskview.h       \
-               src/qp_sizepart.h       \
-               src/qp_actlist.h        \
-               src/qp_combospin.h      \
-               src/qp_devlist.h        \
-               src/qp_spinbox.h        \
-               src/qp_dlgdevprop.h     \
-               src/qp_debug.h          \
-               src/statistics.h
-
-
-# Source files
-SOURCES      = src/main.cpp            \
-               src/qp_common.cpp       \
-               src/qp_settings.cpp     \
-               src/qp_exttools.cpp     \
-               src/qp_libparted.cpp    \
-               src/qp_filesystem.cpp   \
-               src/qp_fswrap.cpp       \
-               src/qp_window.cpp       \
-               src/qp_dlgcreate.cpp    \
-               src/qp_dlgresize.cpp    \
-               src/qp_dlgprogress.cpp  \
-               src/qp_dlgformat.cpp    \
-               src/qp_dlgconfig.cpp    \
-               src/qp_partlist.cpp     \
-               src/qp_listview.cpp     \
-               src/qp_listchart.cpp    \
-               src/qp_partition.cpp    \
-               src/qp_partwidget.cpp   \
-               src/qp_extended.cpp     \
-               src/qp_drivelist.cpp    \
-               src/qp_navview.cpp      \
-               src/qp_diskview.cpp     \
-               src/qp_sizepart.cpp     \
-               src/qp_actlist.cpp      \
-               src/qp_combospin.cpp    \
-               src/qp_spinbox.cpp      \
-               src/qp_devlist.cpp      \
-               src/qp_dlgdevprop.cpp   \
-               src/qp_debug.cpp        \
-               src/statistics.cpp
-
-
-# Qt Designer interfaces
-FORMS        = ui/qp_ui_create.ui       \
-               ui/qp_ui_format.ui       \
-               ui/qp_ui_resize.ui       \
-               ui/qp_ui_progress.ui     \
-               ui/qp_ui_devprop.ui
+SOURCES     += src/main.cpp
 
 
 # Translations
@@ -128,9 +49,6 @@ TRANSLATIONS = ts/qparted_ca.ts        \
                ts/qparted_sv.ts        \
                ts/qparted_ua.ts
 
-# Flags
-QMAKE_CXXFLAGS += "-pipe -Ofast -fno-sized-deallocation"
-
 # Tidy
 QMAKE_CLEAN += $(TARGET) $(QMAKE_TARGET)
 
@@ -20,6 +20,7 @@
 */
 
 #include <getopt.h>
+#include <string.h>
 #include <QApplication>
 #include <QDebug>
 #include <QTranslator>
@@ -28,6 +29,7 @@
 #include <QSplashScreen>
 #include <QTimer>
 #include "qp_libparted.h"
+#include "qp_batch.h"
 #include "qp_window.h"
 #include "qp_settings.h"
 #include "qp_common.h"
@@ -45,6 +47,8 @@ void print_usage(const char *program_name) {
             << "Options used by qparted:" << endl
             << "  -l, --log=value	   use 1 to enable log, 0 for disable it." << endl
             << "						[default = 1])" << endl
+            << "  -b, --batch=plan.json   run the operations of a plan without the GUI" << endl
+            << "  -f, --fast-start		show the window at once, read the disks later" << endl
             << "  -h, --help			Show this usage message" << endl
             << endl << endl
             << program_name << " by Zanac copyright 2003, (C) 2005 Ark Linux" << endl
@@ -52,17 +56,60 @@ void print_usage(const char *program_name) {
     exit(EXIT_SUCCESS);
 }
 
+/*---valid short options---*/
+static const char *const short_options = "hl:b:f";
+
+/*---valid long options---*/
+static const option long_options[] = {
+    { "help",	0, nullptr, 'h' },
+    { "log",	 1, nullptr, 'l' },
+    { "batch",	 1, nullptr, 'b' },
+    { "fast-start",	 0, nullptr, 'f' },
+    { nullptr,	  0, nullptr, 0   } // end of getopt array
+};
+
+/*---a first getopt pass, quiet, that only look for -b/--batch (so "-bplan.json"
+ *   and "--bat=plan.json" are seen like the real pass will see them). It works
+ *   on a copy of argv: getopt permute it, and the Qt options must stay in place
+ *   for the application---*/
+static bool wantsBatch(int argc, char *argv[]) {
+    char **args = new char *[argc + 1];
+    bool batch = false;
+    int next_option;
+
+    memcpy(args, argv, (argc + 1) * sizeof(char *));
+
+    opterr = 0;
+    while ((next_option = getopt_long(argc, args, short_options, long_options, nullptr)) != -1)
+        if (next_option == 'b')
+            batch = true;
+
+    /*---optind 0 make glibc start over for the real pass---*/
+    optind = 0;
+    opterr = 1;
+
+    delete[] args;
+    return batch;
+}
 
 int main(int argc, char *argv[]) {
+    /*---batch mode has no GUI: look for it before making the application---*/
+    bool batch = wantsBatch(argc, argv);
+
+    QCoreApplication *app;
+
     // This allows to run QParted with QtEmbedded without having
     // to pass parameters "-qws".
     // This is, however, potentially harmful, for example if we're being launched
     // from another QWS application (OPIE, Ark Linux installer, .....) - so we
     // add a configure option to turn it off...
+    if (batch)
+        app = new QCoreApplication(argc, argv);
+    else
 #if defined(Q_WS_QWS) && !defined(QWS_CLIENT) // Frame Buffer
-    QApplication app(argc, argv, QApplication::GuiServer);
+        app = new QApplication(argc, argv, QApplication::GuiServer);
 #else // X11
-    QApplication app(argc, argv);
+        app = new QApplication(argc, argv);
 #endif // Q_WS_QWS
 
     /*---program name ;)---*/
@@ -73,15 +120,11 @@ int main(int argc, char *argv[]) {
     /*---Flag log on/off, default 1 = on---*/
     int iLog = 1;
 
-    /*---valid short options---*/
-    const char *const short_options = "hl:";
+    /*---the plan of --batch---*/
+    QString batchPlan;
 
-    /*---valid long options---*/
-    const option long_options[] = {
-        { "help",	0, nullptr, 'h' },
-        { "log",	 1, nullptr, 'l' },
-        { nullptr,	  0, nullptr, 0   } // end of getopt array
-    };
+    /*---show the window before scanning the disks---*/
+    bool fastStart = false;
 
     do {
         next_option = getopt_long(argc,
@@ -109,6 +152,14 @@ int main(int argc, char *argv[]) {
 			}
 			break;
 
+		case 'b': // -b ... --batch
+			batchPlan = optarg;
+			break;
+
+		case 'f': // -f ... --fast-start
+			fastStart = true;
+			break;
+
 		case '?': // opzione invalida :(
 			print_usage(program_name);
 
@@ -119,25 +170,42 @@ int main(int argc, char *argv[]) {
 			abort();
 		}
 	} while (next_option != -1);
-/*---install translation file for application strings---*/
-	QTranslator *translator = new QTranslator();
-	translator->load("qparted_"+QLocale::system().name(), ":/locale");
-	app.installTranslator(translator);
+	/*---install translation file for application strings (the batch output is for scripts)---*/
+	if (!batch) {
+		QTranslator *translator = new QTranslator();
+		translator->load("qparted_"+QLocale::system().name(), ":/locale");
+		app->installTranslator(translator);
+	}
 
 	/*---initialize the debug system---*/
 	if (iLog) g_debug.open();
 	showDebug("QParted debug logfile (https://github.com/ZZYZX/qparted) version %s\n---------\n", VERSION);
+	showTrace("%s", "main, start\n");
 
 	/*---check the Parted version---*/
 	if (!QP_LibParted::checkForParted())
 		return EXIT_FAILURE;
+	showTrace("%s", "main, checkForParted\n");
 
 	/*---check if the kernel support devfs---*/
 	isDevfsEnabled();
 
 	QP_Settings settings;
+	showTrace("%s", "main, settings\n");
+
+	/*---no window, splash or pixmap: just run the plan---*/
+	if (batch) {
+		QP_Batch qpbatch(&settings);
+		int rc = qpbatch.run(batchPlan);
+
+		if (iLog) g_debug.close();
+		delete app;
+
+		return rc;
+	}
 	
 	QP_MainWindow mainwindow(&settings, nullptr);
+	showTrace("%s", "main, window built\n");
 
 	QSplashScreen *splash = new QSplashScreen(QPixmap(DATADIR "/pixmaps/qtp_splash.png"));
 	splash->connect(&mainwindow, SIGNAL(sigSplashInfo(const QString &)),
@@ -145,7 +213,7 @@ int main(int argc, char *argv[]) {
 	splash->finish(&mainwindow);
 	splash->show();
 
-	mainwindow.init();
+	mainwindow.init(fastStart);
 
 #ifdef Q_WS_QWS // Frame Buffer
 	mainwindow.showMaximized();
@@ -153,7 +221,10 @@ int main(int argc, char *argv[]) {
 
 	mainwindow.show();
 
-	bool rc = app.exec();
+	/*---the first event processed: the window is on the screen---*/
+	QTimer::singleShot(0, []() { showTrace("%s", "main, event loop\n"); });
+
+	bool rc = app->exec();
 
 	delete splash;
 	delete &mainwindow;
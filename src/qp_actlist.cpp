@@ -18,11 +18,16 @@
     along with this program; if not, write to the Free Software
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
+#include <algorithm>
 #include <QApplication>
-#include <QMessageBox>
+#include <QDebug>
+#include "qp_common.h"
 #include "qp_filesystem.h"
 #include "qp_actlist.h"
 #include "qp_debug.h"
+#include "qp_scanpool.h"
+#include "qp_probecache.h"
+#include "qp_blockreader.h"
 #include "statistics.h"
 
 /*---type (move+resize), num, start, end---*/
@@ -77,6 +82,127 @@ QP_ActListItem::QP_ActListItem(QTParted::actType action,
     showDebug("%s", "actlistitem::actlistitem, mkpartfs\n");
 }
 
+/*---type, num of the source, logical/primary, start, end, fsspec of the source---*/
+QP_ActListItem::QP_ActListItem(QTParted::actType action,
+                               int num,
+                               QTParted::partType type,
+                               PedSector start,
+                               PedSector end,
+                               QP_FileSystemSpec *fsspec,
+                               PedGeometry geom,
+                               PedPartitionType part_type)
+    : _action(action), _start(start), _end(end)
+    , _num(num), _type(type), _fsspec(fsspec)
+    , _geom(geom), _part_type(part_type)
+{
+    showDebug("%s", "actlistitem::actlistitem, copy\n");
+}
+
+bool QP_PartState::sameGeometry(const QP_PartState &state) const
+{
+    return (start == state.start) && (end == state.end) && (type == state.type);
+}
+
+bool QP_PartState::operator==(const QP_PartState &state) const
+{
+    return sameGeometry(state)
+        && (num == state.num)
+        && (fs_type == state.fs_type)
+        && (flags == state.flags)
+        && (name == state.name);
+}
+
+static bool has_names(PedPartition *part)
+{
+    return ped_disk_type_check_feature(part->disk->type, PED_DISK_TYPE_PARTITION_NAME);
+}
+
+static QP_PartState part_state(PedPartition *part)
+{
+    QP_PartState state;
+
+    state.num = part->num;
+    state.type = part->type;
+    state.start = part->geom.start;
+    state.end = part->geom.end;
+    state.fs_type = part->fs_type;
+    state.flags = 0;
+
+    for (PedPartitionFlag flag = ped_partition_flag_next((PedPartitionFlag)0); flag;
+         flag = ped_partition_flag_next(flag))
+    {
+        if (ped_partition_is_flag_available(part, flag)
+         && ped_partition_get_flag(part, flag))
+            state.flags |= 1ULL << flag;
+    }
+
+    if (has_names(part))
+        state.name = QString::fromUtf8(ped_partition_get_name(part));
+
+    return state;
+}
+
+/*---set the filesystem type, the flags and the name of a partition---*/
+static bool set_part_state(PedPartition *part, const QP_PartState &state)
+{
+    if (!(part->type & PED_PARTITION_EXTENDED) && (part->fs_type != state.fs_type))
+    {
+        if (!ped_partition_set_system(part, state.fs_type))
+            return false;
+    }
+
+    for (PedPartitionFlag flag = ped_partition_flag_next((PedPartitionFlag)0); flag;
+         flag = ped_partition_flag_next(flag))
+    {
+        if (!ped_partition_is_flag_available(part, flag))
+            continue;
+
+        bool on = state.flags & (1ULL << flag);
+        if (bool(ped_partition_get_flag(part, flag)) != on)
+        {
+            if (!ped_partition_set_flag(part, flag, on))
+                return false;
+        }
+    }
+
+    if (has_names(part) && (state.name != QString::fromUtf8(ped_partition_get_name(part))))
+    {
+        if (!ped_partition_set_name(part, state.name.toUtf8().constData()))
+            return false;
+    }
+
+    return true;
+}
+
+static PedPartition *find_partition(PedDisk *disk, const QP_PartState &state)
+{
+    for (PedPartition *part = ped_disk_next_partition(disk, nullptr); part;
+         part = ped_disk_next_partition(disk, part))
+    {
+        if (ped_partition_is_active(part)
+         && (part->geom.start == state.start)
+         && (part->geom.end == state.end)
+         && (part->type == state.type))
+            return part;
+    }
+
+    return nullptr;
+}
+
+/*---logical partitions before the others: remove them before their extended---*/
+static bool logical_first(const QP_PartState &a, const QP_PartState &b)
+{
+    return (a.type & PED_PARTITION_LOGICAL) && !(b.type & PED_PARTITION_LOGICAL);
+}
+
+/*---extended partition before the others: add it before its logicals---*/
+static bool extended_first(const QP_PartState &a, const QP_PartState &b)
+{
+    int ra = (a.type & PED_PARTITION_EXTENDED) ? 0 : (a.type & PED_PARTITION_LOGICAL) ? 2 : 1;
+    int rb = (b.type & PED_PARTITION_EXTENDED) ? 0 : (b.type & PED_PARTITION_LOGICAL) ? 2 : 1;
+    return ra < rb;
+}
+
 QP_ActionList::QP_ActionList(QP_LibParted *libparted) : _libparted(libparted)
 {
     showDebug("%s", "actionlist::actionlist\n");
@@ -84,18 +210,18 @@ QP_ActionList::QP_ActionList(QP_LibParted *libparted) : _libparted(libparted)
     PedDisk *disk;
 
     /*---save of the original device state---*/
-    disk = ped_disk_new(_libparted->dev);
+    disk = open_disk();
 
     if (!disk)
     {
         showDebug("%s", "actionlist::actionlist, ped_disk_new ko\n");
 
         QString label = QString(tr("Critical error during ped_disk_new!"));
-        QMessageBox::information(NULL, "QtParted", label);
+        showMessage(label);
 
         return;
     }
-listdisk.append(disk);
+_origDisk = disk;
 
 /*---make a backup of the disk (we will use this)---*/
 _disk = ped_disk_duplicate(disk);
@@ -104,15 +230,17 @@ if (!_disk)
 {
     showDebug("%s", "actionlist::actionlist, ped_disk_duplicate ko\n");
     ped_disk_destroy(disk);
-    listdisk.removeLast();
+    _origDisk = nullptr;
     disk = nullptr;
 
     QString label = QString(tr("Critical error during ped_disk_duplicate!"));
-    QMessageBox::information(nullptr, "QtParted", label);
+    showMessage(label);
 
     return;
 }
 
+_state = disk_state();
+
 /*---make the partlist of the disk---*/
 scan_partitions();
 }
@@ -121,6 +249,8 @@ QP_ActionList::~QP_ActionList()
 {
     showDebug("%s", "actionlist::~actionlist\n");
 
+    clear_redo();
+    qDeleteAll(actlist);
     actlist.clear();
     orig_logilist.clear();
     orig_partlist.clear();
@@ -298,13 +428,16 @@ void QP_ActionList::update_listpartitions()
     }
 }
 
-void QP_ActionList::scan_partitions()
+void QP_ActionList::scan_partitions(bool full)
 {
-    showDebug("%s", "actionlist::scan_partitions\n");
+    showDebug("actionlist::scan_partitions, %s\n", full ? "full" : "touched partitions only");
 
     /*---initialize active partition---*/
     _partActive = nullptr;
 
+    /*---the partitions as they were at the last scan---*/
+    QList<QP_PartInfo*> lastlist = orig_partlist + orig_logilist;
+
     orig_logilist.clear();
     orig_partlist.clear();
 
@@ -384,86 +517,149 @@ void QP_ActionList::scan_partitions()
             orig_logilist.append(partinfo);
         else
             orig_partlist.append(partinfo);
-        }
+    }
 
-        /*---count how partition are in the disk---*/
-        int totPart = orig_partlist.count() + orig_logilist.count();
+    /*---count how partition are in the disk---*/
+    int totPart = orig_partlist.count() + orig_logilist.count();
 
-        showDebug("%s", "actionlist::scan_partitions, loop into orig_partlist\n");
+    showDebug("%s", "actionlist::scan_partitions, loop into orig_partlist\n");
 
-        /*---loop for all partition of the disk---*/
-        int i = 0;
+    /*---the used space of every partition is probed by a pool of threads---*/
+    QP_ScanPool pool(_libparted->_qpdevice->settings()->scanJobs());
+
+    /*---keep the device open: labels and superblocks are read from one cache---*/
+    QP_BlockReader reader(_libparted->dev);
+
+    /*---what was probed the last time, if nothing changed since then---*/
+    QP_ProbeCache cache(_libparted->dev);
+
+    /*---put primary and logical partitions in the same list, in disk order---*/
+    QList<QP_PartInfo*> scanlist;
+
+    for (QP_PartInfo* p : orig_partlist)
+    {
+        if (p->type != QTParted::extended)
+            scanlist.append(p);
+        else
+            scanlist.append(orig_logilist);
+    }
+
+    /*---loop for all partition of the disk---*/
+    int i = totPart - scanlist.count();
+    int queued = 0;
+    int reused = 0;
 
-        for (QP_PartInfo* p : orig_partlist)
+    for (QP_PartInfo* p : scanlist)
+    {
+        if (p->isFree())
         {
-            if (p->type != QTParted::extended)
-            {
-                i++;
+            i++;
+            continue;
+        }
 
-                if (!p->isFree())
-                {
-                    /*---emit a signal for update the progressbar---*/
-                    _libparted->_message = QString(tr("Getting info about partition %1.")).arg(p->partname());
-                    _libparted->emitSigTimer(i * 100 / totPart, _libparted->message(), QString());
-
-                    /*---get info about this primary partition---*/
-                    part = ped_disk_get_partition(disk(), p->num);
-
-                    if (part)
-                        get_partfilesystem_info(part, p);
-                    else
-                        showDebug("%s", "actionlist::scan_partitions, get_partfilesystem_info ko\n");
-
-                    /*---get the label of this primary partition---*/
-                    if (part)
-                        get_partfilesystem_label(part, p);
-                    else
-                        showDebug("%s", "actionlist::scan_partitions, get_partfilesystem_label ko\n");
-                }
-            }
-            else
-            {
-                for (QP_PartInfo* logi : orig_logilist)
-                {
-                    /*---loop for every logical partitions---*/
-                    i++;
+        part = ped_disk_get_partition(disk(), p->num);
 
-                    if (!logi->isFree())
-                    {
-                    /*---emit a signal for update the progressbar---*/
-                    _libparted->_message = QString(tr("Getting info about partition %1.")).arg(p->partname());
-                    _libparted->emitSigTimer(i * 100 / totPart, _libparted->message(), QString());
+        if (!part)
+        {
+            i++;
+            showDebug("%s", "actionlist::scan_partitions, ped_disk_get_partition ko\n");
+            continue;
+        }
 
-                    /*---get info about this primary partition---*/
-                    part = ped_disk_get_partition(disk(), p->num);
+        bool known = !full && reuse_partinfo(p, lastlist);
+        if (known)
+            reused++;
 
-                    if (part) 
-                        {
-                            get_partfilesystem_info(part, p);
-                        }
-                    else 
-                        {
-                            showDebug("%s", "actionlist::scan_partitions, get_partfilesystem_info ko\n");
-                        }
+        /*---label and used space already known? skip the probe---*/
+        if (!known && !cache.lookup(part, p))
+        {
+            /*---get the label of this partition (a few sectors, not worth a thread)---*/
+            get_partfilesystem_label(part, p);
 
-                    /*---get the label of this primary partition---*/
-                    if (part) 
-                        {
-                            get_partfilesystem_label(part, p);
-                        }
-                    else 
-                        {
-                            showDebug("%s", "actionlist::scan_partitions, get_partfilesystem_label ko\n");
-                        }
-                    }
+            /*---get info about this partition, queued in the pool if it is slow---*/
+            if (get_partfilesystem_info(part, p, &pool))
+            {
+                queued++;
+                continue;
             }
+
+            cache.store(part, p);
         }
+
+        /*---emit a signal for update the progressbar---*/
+        i++;
+        _libparted->_message = QString(tr("Getting info about partition %1.")).arg(p->partname());
+        _libparted->emitSigTimer(i * 100 / totPart, _libparted->message(), QString());
+    }
+
+    showDebug("actionlist::scan_partitions, %d partitions reused, %d queued\n", reused, queued);
+
+    /*---collect the partitions as soon as the pool finish them---*/
+    QP_PartInfo* p;
+
+    while ((p = pool.next()))
+    {
+        i++;
+
+        if (!pool.error().isEmpty())
+            showMessage(pool.error());
+        else if ((part = ped_disk_get_partition(disk(), p->num)))
+            cache.store(part, p);
+
+        /*---emit a signal for update the progressbar---*/
+        _libparted->_message = QString(tr("Getting info about partition %1.")).arg(p->partname());
+        _libparted->emitSigTimer(i * 100 / totPart, _libparted->message(), QString());
     }
 
+    _touched.clear();
+
     _libparted->emitSigTimer(100, _libparted->message(), QString());
 }
 
-bool QP_ActionList::get_partfilesystem_info(PedPartition *part, QP_PartInfo *partinfo)
+/*---take label and used space from the last scan, if commit didn't touch the
+ *   partition since then---*/
+bool QP_ActionList::reuse_partinfo(QP_PartInfo *partinfo, const QList<QP_PartInfo*> &lastlist)
+{
+    for (const QP_PartState &state : _touched)
+    {
+        if ((state.start == partinfo->start) && (state.end == partinfo->end))
+            return false;
+    }
+
+    for (QP_PartInfo *last : lastlist)
+    {
+        if ((last->start == partinfo->start)
+         && (last->end == partinfo->end)
+         && (last->type == partinfo->type)
+         && (last->fsspec == partinfo->fsspec)
+         && !last->isFree())
+        {
+            partinfo->_label = last->_label;
+            partinfo->min_size = last->min_size;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*---remember what a commit step changed: the partitions in a new state, and
+ *   the one the step worked on (a format doesn't change the partition table)---*/
+void QP_ActionList::touch_partitions(const QList<QP_PartState> &before, QP_ActListItem *pl)
+{
+    bool byNum = (pl->_action != QTParted::create)
+              && (pl->_action != QTParted::rm)
+              && (pl->_action != QTParted::copy);
+
+    for (const QP_PartState &state : disk_state())
+    {
+        if (!before.contains(state) || (byNum && (state.num == pl->_num)))
+            _touched.append(state);
+    }
+}
+
+/*---return true if the probe was queued in the pool (ie min_size is not ready yet)---*/
+bool QP_ActionList::get_partfilesystem_info(PedPartition *part, QP_PartInfo *partinfo, QP_ScanPool *pool)
 {
     showDebug("%s", "actionlist::get_partfilesystem_info");
 
@@ -473,7 +669,7 @@ bool QP_ActionList::get_partfilesystem_info(PedPartition *part, QP_PartInfo *par
     if (partinfo->_virtual)
     {
         partinfo->min_size = -1;
-        return true;
+        return false;
     }
 
 #ifdef USE_PARTED2_FS_SUPPORT // Filesystem support was removed from parted 3.x
@@ -485,20 +681,14 @@ bool QP_ActionList::get_partfilesystem_info(PedPartition *part, QP_PartInfo *par
 
     if (!fs)
     {
-        /*---exist a wrapper for min_size?---*/
-        if (partinfo->fswrap() && partinfo->fsspec->fswrap()->wrap_min_size)
+        if (pool)
         {
-            /*---get the min_size from the wrapper---*/
-            partinfo->min_size = partinfo->fsspec->fswrap()->min_size(partinfo->partname());
-
-            if (partinfo->min_size > (partinfo->end - partinfo->start))
-                partinfo->min_size = partinfo->end - partinfo->start;
+            pool->add(partinfo);
+            return true;
         }
-        else
-            /*---get the min_size from space_stats (that is a "df" wrapper)---*/
-            partinfo->min_size = space_stats(partinfo);
 
-        return true;
+        partinfo->min_size = probe_min_size(partinfo);
+        return false;
     }
 
     /*---get the minimum filesystem size---*/
@@ -514,7 +704,32 @@ bool QP_ActionList::get_partfilesystem_info(PedPartition *part, QP_PartInfo *par
     ped_file_system_close(fs);
 #endif
 
-    return true;
+    return false;
+}
+
+/*---get the used space without libparted. It doesn't touch the PedDisk, so it
+ *   can run in a QP_ScanPool thread: every probe has its own wrapper (the
+ *   wrapper keep the state of the tool it run)---*/
+PedSector QP_ActionList::probe_min_size(QP_PartInfo *partinfo, QString *error)
+{
+    PedSector min_size;
+
+    /*---exist a wrapper for min_size?---*/
+    if (partinfo->fswrap() && partinfo->fsspec->fswrap()->wrap_min_size)
+    {
+        /*---get the min_size from the wrapper---*/
+        QP_FSWrap *fswrap = QP_FSWrap::fswrap(partinfo->fsspec->name());
+        min_size = fswrap->min_size(partinfo->partname());
+        delete fswrap;
+
+        if (min_size > (partinfo->end - partinfo->start))
+            min_size = partinfo->end - partinfo->start;
+    }
+    else
+        /*---get the min_size from space_stats (that is a "df" wrapper)---*/
+        min_size = space_stats(partinfo, error);
+
+    return min_size;
 }
 
 bool QP_ActionList::get_partfilesystem_label(PedPartition *part, QP_PartInfo *partinfo)
@@ -547,16 +762,6 @@ void QP_ActionList::ins_move(int num, PedSector start, PedSector end, PedGeometr
     ins_newdisk();
 }
 
-void QP_ActionList::ins_move(int num, PedSector start, PedSector end, PedGeometry geom, PedPartitionType part_type)
-{
-    qDebug() << "actionlist::ins_move";
-
-    QP_ActListItem *actlistitem = new QP_ActListItem(QTParted::move, num, start, end, geom, part_type);
-    actlist.append(actlistitem);
-
-    ins_newdisk();
-}
-
 void QP_ActionList::ins_rm(int num)
 {
     qDebug() << "actionlist::ins_rm";
@@ -587,6 +792,16 @@ void QP_ActionList::ins_mkpart(QTParted::partType type, PedSector start, PedSect
     ins_newdisk();
 }
 
+void QP_ActionList::ins_copy(int num, QTParted::partType type, PedSector start, PedSector end, QP_FileSystemSpec *fsspec, PedGeometry geom, PedPartitionType part_type)
+{
+    qDebug() << "actionlist::ins_copy";
+
+    QP_ActListItem *actlistitem = new QP_ActListItem(QTParted::copy, num, type, start, end, fsspec, geom, part_type);
+    actlist.append(actlistitem);
+
+    ins_newdisk();
+}
+
 void QP_ActionList::ins_active(int num, bool active)
 {
     qDebug() << "actionlist::ins_active";
@@ -616,7 +831,8 @@ void QP_ActionList::get_partinfo(QP_PartInfo *partinfo, PedPartition *part)
         if ((pl->_action == QTParted::create) ||
             (pl->_action == QTParted::resize) ||
             (pl->_action == QTParted::move) ||
-            (pl->_action == QTParted::format))
+            (pl->_action == QTParted::format) ||
+            (pl->_action == QTParted::copy))
         {
             if ((part->geom.start == pl->_geom.start) &&
                 (part->geom.end == pl->_geom.end) &&
@@ -632,6 +848,10 @@ void QP_ActionList::get_partinfo(QP_PartInfo *partinfo, PedPartition *part)
                 if (pl->_action == QTParted::format) {
                     partinfo->fsspec = pl->_fsspec;
                 }
+
+                if (pl->_action == QTParted::copy) {
+                    partinfo->fsspec = pl->_fsspec;
+                }
             }
         }
     }
@@ -639,33 +859,244 @@ void QP_ActionList::get_partinfo(QP_PartInfo *partinfo, PedPartition *part)
 
 bool QP_ActionList::canUndo()
 {
-    return ( listdisk.first() != listdisk.last() );
+    return !actlist.isEmpty();
+}
+
+bool QP_ActionList::canRedo()
+{
+    return !redolist.isEmpty();
 }
 
 void QP_ActionList::undo()
 {
     showDebug ( "%s", "actionlist::undo\n" );
 
-    /*---destroy the state of the disk in this moment---*/
-    ped_disk_destroy ( _disk );
+    if ( actlist.isEmpty() )
+        return;
 
-    /*---undo last operation---*/
-    PedDisk *disk = ( PedDisk * ) listdisk.last();
-    ped_disk_destroy ( disk );
-    listdisk.removeLast();
+    /*---revert the changes of the last operation and keep it for redo---*/
+    QP_ActListItem *item = actlist.takeLast();
+    redolist.append ( item );
 
-    /*---restore last state---*/
-    _disk = ped_disk_duplicate ( ( PedDisk * ) listdisk.last() ); //FIXME: if !_disk :(
+    if ( !apply_delta ( item->_delta, false ) )
+        restore_disk();
 
-    if ( !_disk ) showDebug ( "%s", "actionlist::undo, ped_disk_duplicate ko\n" );
+    /*---the state of the disk... is of course changed---*/
+    emit sigDiskChanged();
+}
 
-    /*---remove last operation---*/
-    actlist.removeLast();
+void QP_ActionList::redo()
+{
+    showDebug ( "%s", "actionlist::redo\n" );
+
+    if ( redolist.isEmpty() )
+        return;
+
+    QP_ActListItem *item = redolist.takeLast();
+    actlist.append ( item );
+
+    if ( !apply_delta ( item->_delta, true ) )
+        restore_disk();
 
-    /*---the state of the disk... is of course changed---*/
     emit sigDiskChanged();
 }
 
+QList<QP_PartState> QP_ActionList::disk_state()
+{
+    QList<QP_PartState> state;
+
+    if ( !_disk )
+        return state;
+
+    for ( PedPartition *part = ped_disk_next_partition ( _disk, nullptr ); part;
+          part = ped_disk_next_partition ( _disk, part ) )
+    {
+        /*---freespace and metadata are not partitions---*/
+        if ( ped_partition_is_active ( part ) )
+            state.append ( part_state ( part ) );
+    }
+
+    return state;
+}
+
+/*---apply the changes of an operation to _disk (forward) or revert them.
+ *   A partition that is still in the same place is changed in place, one
+ *   that keep its number is moved/resized, the others are removed or added
+ *   again with the exact geometry they had---*/
+bool QP_ActionList::apply_delta ( const QP_DiskDelta &delta, bool forward )
+{
+    QList<QP_PartState> removed = forward ? delta.before : delta.after;
+    QList<QP_PartState> added = forward ? delta.after : delta.before;
+    QList<QP_PartState> changedFrom;
+    QList<QP_PartState> changedTo;
+    PedConstraint *constraint;
+    PedGeometry geom;
+
+    /*---the state of the disk we want at the end---*/
+    QList<QP_PartState> target = _state;
+    for ( const QP_PartState &state : removed )
+        target.removeOne ( state );
+    target += added;
+
+    for ( int pass = 0; pass < 2; pass++ )
+    {
+        int i = 0;
+        while ( i < removed.count() )
+        {
+            int j;
+            for ( j = 0; j < added.count(); j++ )
+            {
+                if ( pass == 0 ? removed.at ( i ).sameGeometry ( added.at ( j ) )
+                               : ( removed.at ( i ).num == added.at ( j ).num )
+                                 && ( removed.at ( i ).type == added.at ( j ).type ) )
+                    break;
+            }
+
+            if ( j < added.count() )
+            {
+                changedFrom.append ( removed.takeAt ( i ) );
+                changedTo.append ( added.takeAt ( j ) );
+            }
+            else
+                i++;
+        }
+    }
+
+    std::stable_sort ( removed.begin(), removed.end(), logical_first );
+    std::stable_sort ( added.begin(), added.end(), extended_first );
+
+    for ( const QP_PartState &state : removed )
+    {
+        PedPartition *part = find_partition ( _disk, state );
+        if ( !part || !ped_disk_delete_partition ( _disk, part ) )
+            goto error;
+    }
+
+    /*---an extended partition that grow must do it before its logicals move
+     *   outside the old geometry, one that shrink after they moved inside---*/
+    for ( int pass = 0; pass < 3; pass++ )
+    {
+        for ( int i = 0; i < changedFrom.count(); i++ )
+        {
+            const QP_PartState &from = changedFrom.at ( i );
+            const QP_PartState &to = changedTo.at ( i );
+            bool extended = from.type & PED_PARTITION_EXTENDED;
+            bool grow = ( to.start <= from.start ) && ( to.end >= from.end );
+
+            if ( ( pass == 0 && !( extended && grow ) )
+              || ( pass == 1 && extended )
+              || ( pass == 2 && !( extended && !grow ) ) )
+                continue;
+
+            PedPartition *part = find_partition ( _disk, from );
+            if ( !part )
+                goto error;
+
+            if ( !from.sameGeometry ( to ) )
+            {
+                ped_geometry_init ( &geom, _disk->dev, to.start, to.end - to.start + 1 );
+                constraint = ped_constraint_exact ( &geom );
+                bool rc = ped_disk_set_partition_geom ( _disk, part, constraint, to.start, to.end );
+                ped_constraint_destroy ( constraint );
+                if ( !rc )
+                    goto error;
+            }
+
+            if ( !set_part_state ( part, to ) )
+                goto error;
+        }
+    }
+
+    for ( const QP_PartState &state : added )
+    {
+        PedPartition *part = ped_partition_new ( _disk, state.type, state.fs_type, state.start, state.end );
+        if ( !part )
+            goto error;
+
+        /*---keep the number, where the label let us choose it---*/
+        part->num = state.num;
+
+        constraint = ped_constraint_exact ( &part->geom );
+        bool rc = ped_disk_add_partition ( _disk, part, constraint );
+        ped_constraint_destroy ( constraint );
+        if ( !rc )
+        {
+            ped_partition_destroy ( part );
+            goto error;
+        }
+
+        if ( !set_part_state ( part, state ) )
+            goto error;
+    }
+
+    /*---libparted renumber the logical partitions by itself: give them back
+     *   the numbers the next operations was done with---*/
+    for ( const QP_PartState &state : target )
+    {
+        PedPartition *part = find_partition ( _disk, state );
+        if ( part )
+            part->num = state.num;
+    }
+
+    _state = disk_state();
+
+    if ( _state.count() != target.count() )
+        goto error;
+    for ( const QP_PartState &state : target )
+        if ( !_state.contains ( state ) )
+            goto error;
+
+    return true;
+
+error:
+    showDebug ( "actionlist::apply_delta, cannot %s the operation\n", forward ? "redo" : "undo" );
+    return false;
+}
+
+/*---build again _disk from the original disk, replaying every operation;
+ *   the ones that cannot be replayed are lost---*/
+void QP_ActionList::restore_disk()
+{
+    showDebug ( "%s", "actionlist::restore_disk\n" );
+
+    int count = actlist.count();
+    int done;
+
+    for ( int pass = 0; pass < 2; pass++ )
+    {
+        if ( _disk )
+            ped_disk_destroy ( _disk );
+        _disk = ped_disk_duplicate ( _origDisk );
+        _state = disk_state();
+
+        for ( done = 0; done < count; done++ )
+            if ( !apply_delta ( actlist.at ( done )->_delta, true ) )
+                break;
+
+        if ( done == count )
+            break;
+
+        /*---the disk is half changed: start again with only the good ones---*/
+        count = done;
+    }
+
+    if ( count < actlist.count() )
+    {
+        while ( actlist.count() > count )
+            delete actlist.takeLast();
+        clear_redo();
+
+        QString label = QString ( tr ( "The state of the disk cannot be restored: the last operations were discarded." ) );
+        showMessage ( label );
+    }
+}
+
+void QP_ActionList::clear_redo()
+{
+    qDeleteAll ( redolist );
+    redolist.clear();
+}
+
 void QP_ActionList::commit()
 {
     showDebug ( "%s", "actionlist::commit\n" );
@@ -674,15 +1105,10 @@ void QP_ActionList::commit()
     QString messageState = QString::null;
 
     /*---undo all disk state---*/
+    clear_redo();
+    ped_disk_destroy ( _disk );
 
-    while ( listdisk.first() != listdisk.last() )
-    {
-        PedDisk *disk = ( PedDisk * ) listdisk.last();
-        ped_disk_destroy ( disk );
-        listdisk.removeLast();
-    }
-
-    _disk = ped_disk_duplicate ( ( PedDisk * ) listdisk.first() );
+    _disk = ped_disk_duplicate ( _origDisk );
 
     if ( !_disk ) showDebug ( "%s", "actionlist::commit, ped_disk_duplicate ko\n" );
 
@@ -691,6 +1117,21 @@ void QP_ActionList::commit()
 
     bool rc = true;
 
+    /*---a new partition table (see QP_Batch) is written before the
+     *   operations made on it---*/
+    if ( _libparted->_qpdevice->freshTable() )
+    {
+        showDebug ( "%s", "actionlist::commit, want to write the new partition table\n" );
+
+        if ( _libparted->disk_commit ( _disk ) )
+            _libparted->_qpdevice->setFreshTable ( false );
+        else
+        {
+            messageState = _libparted->message();
+            rc = false;
+        }
+    }
+
     //counter of how much operations are done!
     int i = 0;
 
@@ -699,6 +1140,29 @@ void QP_ActionList::commit()
     foreach(QP_ActListItem *pl, actlist) {
         showDebug ( "%s", "actionlist::commit, loop for commit\n" );
 
+        if ( rc == false )
+            break;
+
+        /*---the user pressed "cancel": the operations left are not done---*/
+        if ( _libparted->canceled() )
+        {
+            showDebug ( "%s", "actionlist::commit, canceled\n" );
+            messageState = tr ( "Canceled: %1 operations were not committed." ).arg ( actlist.count() - actlist.indexOf ( pl ) );
+            break;
+        }
+
+        /*---to know what the step changed---*/
+        QList<QP_PartState> before = disk_state();
+
+        /*---the data a move, copy or resize go through: the progress give
+         *   bytes and throughput on it (0: just the percent)---*/
+        qint64 bytes = 0;
+        if ( ( pl->_action == QTParted::move )
+          || ( pl->_action == QTParted::copy )
+          || ( pl->_action == QTParted::resize ) )
+            bytes = ( pl->_end - pl->_start + 1 ) * _disk->dev->sector_size;
+        _libparted->progress()->begin ( bytes );
+
         //---mkpart commit---
 
         if ( pl->_action == QTParted::create )
@@ -718,7 +1182,7 @@ void QP_ActionList::commit()
         {
             showDebug ( "%s", "actionlist::commit, want to commit a rm\n" );
             emit sigOperations ( tr ( "Preparation for removing a partition." ), messageState, i++, iTotAct );
-            scan_partitions();
+            scan_partitions(false);
             _libparted->scan_orig_partitions();
 
             emit sigOperations ( tr ( "Removing a partition." ), messageState, i, iTotAct );
@@ -734,7 +1198,7 @@ void QP_ActionList::commit()
         {
             qInfo() << "actionlist::commit, want to commit a resize\n";
             emit sigOperations(tr("Preparation for resizing a partition."), messageState, i++, iTotAct);
-            scan_partitions();
+            scan_partitions(false);
             _libparted->scan_orig_partitions();
 
             emit sigOperations(tr("Resizing a partition."), messageState, i, iTotAct);
@@ -751,7 +1215,7 @@ void QP_ActionList::commit()
         {
             qInfo() << "actionlist::commit, want to commit a move\n";
             emit sigOperations(tr("Preparation for moving a partition."), messageState, i++, iTotAct);
-            scan_partitions();
+            scan_partitions(false);
             _libparted->scan_orig_partitions();
 
             emit sigOperations(tr("Moving a partition."), messageState, i, iTotAct);
@@ -763,12 +1227,29 @@ void QP_ActionList::commit()
             }
         }
 
+        //---copy commit---
+        else if (pl->_action == QTParted::copy)
+        {
+            qInfo() << "actionlist::commit, want to commit a copy\n";
+            emit sigOperations(tr("Preparation for copying a partition."), messageState, i++, iTotAct);
+            scan_partitions(false);
+            _libparted->scan_orig_partitions();
+
+            emit sigOperations(tr("Copying a partition."), messageState, i, iTotAct);
+
+            if (!_libparted->copy(pl->_num, pl->_type, pl->_start))
+            {
+                messageState = _libparted->message();
+                rc = false;
+            }
+        }
+
         //---active commit---
         else if (pl->_action == QTParted::active)
         {
             qInfo() << "actionlist::commit, want to commit an active\n";
             emit sigOperations(tr("Preparation for activating a partition."), messageState, i++, iTotAct);
-            scan_partitions();
+            scan_partitions(false);
             _libparted->scan_orig_partitions();
 
             emit sigOperations(tr("Activating a partition."), messageState, i, iTotAct);
@@ -785,7 +1266,7 @@ void QP_ActionList::commit()
         {
             qInfo() << "actionlist::commit, want to commit a hidden\n";
             emit sigOperations(tr("Preparation for hiding a partition."), messageState, i++, iTotAct);
-            scan_partitions();
+            scan_partitions(false);
             _libparted->scan_orig_partitions();
 
             emit sigOperations(tr("Hiding a partition."), messageState, i, iTotAct);
@@ -802,7 +1283,7 @@ void QP_ActionList::commit()
         {
             qInfo() << "actionlist::commit, want to commit a format\n";
             emit sigOperations(tr("Preparation for formatting a partition."), messageState, i++, iTotAct);
-            scan_partitions();
+            scan_partitions(false);
             _libparted->scan_orig_partitions();
 
             emit sigOperations(tr("Formatting a partition."), messageState, i, iTotAct);
@@ -814,16 +1295,21 @@ void QP_ActionList::commit()
             }
         }
 
-        /*---just update GUI---*/
-        QCoreApplication::processEvents();
+        /*---only these partitions will be probed again---*/
+        touch_partitions(before, pl);
 
         if (rc == false)
         {
             break;
         }
     }
+    qDeleteAll(actlist);
     actlist.clear();
 
+    /*---the steps are over: the rescan below (and the refresh of the
+     *   caller) must not see the "Cancel" of this commit---*/
+    _libparted->_cancel.store(0);
+
     /*---return in test mode---*/
     _libparted->setWrite(false);
 
@@ -831,28 +1317,27 @@ void QP_ActionList::commit()
     ped_disk_destroy(_disk);
 
     /*---remove also the original disk---*/
-    ped_disk_destroy((PedDisk*)listdisk.first());
-    listdisk.clear();
+    ped_disk_destroy(_origDisk);
 
-    /*---prepare the list and the _disk---*/
-    PedDisk *disk = ped_disk_new(_libparted->dev); //FIXME !disk
+    /*---prepare the original disk and the _disk---*/
+    _origDisk = open_disk(); //FIXME !_origDisk
 
-    if (!disk)
+    if (!_origDisk)
         showDebug("%s", "actionlist::commit, ped_disk_new ko\n");
 
-    listdisk.append(disk);
-
-    _disk = ped_disk_duplicate(disk); //FIXME !_disk
+    _disk = ped_disk_duplicate(_origDisk); //FIXME !_disk
 
     if (!_disk)
         showDebug("%s", "actionlist::commit, ped_disk_duplicate ko\n");
 
+    _state = disk_state();
+
     emit sigOperations(tr("Rescan of the disk."), messageState, i, iTotAct);
 
     showDebug("%s", "actionlist::commit, call scan_partitions\n");
 
-    /*---make a new scan of the partitions---*/
-    scan_partitions();
+    /*---make a new scan of the partitions (the touched ones)---*/
+    scan_partitions(false);
 
     emit sigOperations(tr("All operations completed."), messageState, iTotAct, iTotAct);
 
@@ -860,6 +1345,18 @@ void QP_ActionList::commit()
     emit sigDiskChanged();
 }
 
+/*---a device with a new partition table not written yet (see
+ *   QP_Device::setFreshTable) start from an empty msdos table---*/
+PedDisk* QP_ActionList::open_disk()
+{
+    if ( !_libparted->_qpdevice->freshTable() )
+        return ped_disk_new ( _libparted->dev );
+
+    const PedDiskType *type = ped_disk_type_get ( "msdos" );
+
+    return type ? ped_disk_new_fresh ( _libparted->dev, type ) : nullptr;
+}
+
 PedDisk* QP_ActionList::disk()
 {
     return _disk;
@@ -894,11 +1391,25 @@ void QP_ActionList::ins_newdisk()
 {
     showDebug("%s", "actionlist::ins_newdisk\n");
 
-    listdisk.append(_disk);
-    _disk = ped_disk_duplicate(_disk); //FIXME !_disk
+    /*---keep only what the operation changed, not a copy of the whole disk---*/
+    QList<QP_PartState> state = disk_state();
+    QP_DiskDelta &delta = actlist.last()->_delta;
 
-    if (!_disk)
-        showDebug("%s", "actionlist::ins_newdisk, ped_disk_duplicate ko\n");
+    for (const QP_PartState &before : _state)
+        if (!state.contains(before))
+            delta.before.append(before);
+
+    for (const QP_PartState &after : state)
+        if (!_state.contains(after))
+            delta.after.append(after);
+
+    _state = state;
+
+    /*---a new operation: what was undone cannot be redone any more---*/
+    clear_redo();
+
+    showDebug("actionlist::ins_newdisk, %d partitions before, %d after\n",
+              delta.before.count(), delta.after.count());
 
     emit sigDiskChanged();
 }
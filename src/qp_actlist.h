@@ -34,10 +34,36 @@
 #include "qp_libparted.h"
 #include "qp_fswrap.h"
 
+class QP_ScanPool;
+
+/*---what an action can change of a partition (flags is a bit for every
+ *   PedPartitionFlag)---*/
+class QP_PartState {
+public:
+    int num;
+    PedPartitionType type;
+    PedSector start;
+    PedSector end;
+    const PedFileSystemType *fs_type;
+    unsigned long long flags;
+    QString name;
+
+    bool sameGeometry(const QP_PartState &) const;
+    bool operator==(const QP_PartState &) const;
+};
+
+/*---the partitions before and after an action, only the ones it changed---*/
+class QP_DiskDelta {
+public:
+    QList<QP_PartState> before;
+    QList<QP_PartState> after;
+};
+
 /* move,   -> num, start, end
  * resize, -> num, start, end
  * rm,	 -> num
  * create  -> start, end, tipo_estesa_logica, fsspec, label
+ * copy    -> num, logical/primary, start, end, fsspec
  * */
 class QP_ActListItem {
 public:
@@ -62,6 +88,13 @@ public:
                    PedGeometry,
                    PedPartitionType);
 
+    /*---type (copy), num, logical/primary, start, end, fsspec, geometry, parttype---*/
+    QP_ActListItem(QTParted::actType, int, QTParted::partType,
+                   PedSector, PedSector,
+                   QP_FileSystemSpec *,
+                   PedGeometry,
+                   PedPartitionType);
+
     QTParted::actType _action;
     PedSector _start;
     PedSector _end;
@@ -72,44 +105,9 @@ public:
     PedGeometry _geom;
     PedPartitionType _part_type;
     bool _status; //used for boot and hidden flags
+    QP_DiskDelta _delta; //used for undo/redo
 };
 
-class QP_ActionList : public QObject {
-    Q_OBJECT
-
-public:
-    QP_ActionList(QP_LibParted *);
-    ~QP_ActionList();
-
-    void clear();
-    bool isEmpty();
-    void undo();
-    void redo();
-    void commit();
-    PedDisk *disk();
-    QP_PartInfo *partActive();
-
-    void partition_get_flags(QP_PartInfo *partinfo, PedPartition *part);
-    void ins_newdisk();
-
-    QList<QP_ActListItem *> actlist;
-
-signals:
-    void sigOperations(QString, int, int, int);
-    void sigDiskChanged();
-
-private:
-    QP_LibParted *_libparted;
-    QList<PedDisk *> listdisk;
-    PedDisk *_disk;
-    QP_PartInfo *_partActive;
-
-    void scan_partitions();
-    bool insert_item(QP_ActListItem *);
-};
-
-
-
 class QP_ActionList : public QObject {
     friend class QP_LibParted;
     friend class QP_PartInfo;
@@ -118,19 +116,23 @@ public:
     QP_ActionList(QP_LibParted *);
     ~QP_ActionList();
     void update_listpartitions();
-    void scan_partitions(); //scan for every partition
-    bool get_partfilesystem_info(PedPartition *, QP_PartInfo *);
+    void scan_partitions(bool full = true); //scan for every partition, or only the ones touched by commit
+    bool get_partfilesystem_info(PedPartition *, QP_PartInfo *, QP_ScanPool *pool = nullptr);
     bool get_partfilesystem_label(PedPartition *part, QP_PartInfo *partinfo);
+    static PedSector probe_min_size(QP_PartInfo *, QString *error = nullptr); //thread safe
     void ins_resize(int, PedSector, PedSector, PedGeometry, PedPartitionType);
     void ins_move(int, PedSector, PedSector, PedGeometry, PedPartitionType);
     void ins_rm(int);
     void ins_mkfs(QP_FileSystemSpec *, int, QString, PedGeometry, PedPartitionType);
     void ins_mkpart(QTParted::partType, PedSector, PedSector, QP_FileSystemSpec *, QString, PedGeometry, PedPartitionType);
+    void ins_copy(int, QTParted::partType, PedSector, PedSector, QP_FileSystemSpec *, PedGeometry, PedPartitionType);
     void ins_active(int, bool);
     void ins_hidden(int, bool);
     void get_partinfo(QP_PartInfo *, PedPartition *);
     bool canUndo();  //Does the user can undo/commit?
+    bool canRedo();  //Is there an undone operation?
     void undo();     //undo last operation
+    void redo();     //redo last undone operation
     void commit();   //commit all operations
     PedDisk *disk(); //return the actual state of the disk
     QP_PartInfo *partActive(); //return the partinfo that is bootable
@@ -140,9 +142,19 @@ public:
 private:
     void partition_get_flags(QP_PartInfo *, PedPartition *); //will get the active flag
     void ins_newdisk();
+    void clear_redo();
+    QList<QP_PartState> disk_state(); //state of the partitions of _disk
+    bool apply_delta(const QP_DiskDelta &, bool); //replay (true) or revert (false)
+    void restore_disk(); //undo everything if a delta cannot be applied
+    PedDisk *open_disk(); //the disk of the device, or a new empty one
+    bool reuse_partinfo(QP_PartInfo *, const QList<QP_PartInfo*> &);
+    void touch_partitions(const QList<QP_PartState> &, QP_ActListItem *);
     QList<QP_ActListItem*> actlist;
-    QList<PedDisk*> listdisk;
-    PedDisk *_disk;
+    QList<QP_ActListItem*> redolist;
+    PedDisk *_origDisk; //the disk as it is on the device
+    PedDisk *_disk;     //the disk with all the operations applied
+    QList<QP_PartState> _state;
+    QList<QP_PartState> _touched; //changed by commit since the last scan
     QP_LibParted *_libparted;
     QP_PartInfo *_partActive; //a pointer to the partinfo that is current active (ie bootable)
     QList<QP_PartInfo*> orig_partlist;
@@ -0,0 +1,310 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include "qp_batch.h"
+#include "qp_commitscheduler.h"
+#include "qp_filesystem.h"
+#include "qp_debug.h"
+
+QP_Batch::QP_Batch(QP_Settings *settings) {
+	_settings = settings;
+	_libparted = NULL;
+}
+
+QP_Batch::~QP_Batch() {
+	qDeleteAll(_libparteds);
+	qDeleteAll(_devices);
+}
+
+int QP_Batch::run(QString fileName) {
+	QJsonObject plan;
+
+	if (!load(fileName, &plan))
+		return done(false, false);
+
+	/*---a plan for a device, or a list of them committed together---*/
+	QJsonArray devices = plan.contains("devices")
+			   ? plan.value("devices").toArray()
+			   : QJsonArray{plan};
+
+	if (devices.isEmpty()) {
+		error(tr("The plan has no \"devices\"."));
+		return done(false, false);
+	}
+
+	for (const QJsonValue &device : devices)
+		if (!prepare(device.toObject()))
+			return done(false, false);
+
+	if (!plan.value("commit").toBool(true)) {
+		for (QP_LibParted *libparted : _libparteds) {
+			_libparted = libparted;
+			printPartitions();
+		}
+		return done(true, false);
+	}
+
+	QP_CommitScheduler scheduler(plan.value("jobs").toInt(_settings->commitJobs()),
+				     plan.value("serialize_bus").toBool(_settings->commitSerializeBus()));
+	connect(&scheduler, SIGNAL(sigTimer(QP_LibParted *, int, QString, QString)),
+		this, SLOT(slotTimer(QP_LibParted *, int, QString, QString)));
+	connect(&scheduler, SIGNAL(sigOperations(QP_LibParted *, QString, QString, int, int)),
+		this, SLOT(slotOperations(QP_LibParted *, QString, QString, int, int)));
+	connect(&scheduler, SIGNAL(sigProgress(int, int, int, int, QString)),
+		this, SLOT(slotProgress(int, int, int, int, QString)));
+
+	for (QP_LibParted *libparted : _libparteds)
+		scheduler.add(libparted, _paths.value(libparted));
+
+	_failed.clear();
+	scheduler.run();
+
+	/*---the last update of every device, if it is still waiting for its frame---*/
+	for (QP_LibParted *libparted : _libparteds)
+		libparted->progress()->flush();
+
+	for (QP_LibParted *libparted : _libparteds) {
+		_libparted = libparted;
+		_libparted->scan_partitions();
+		printPartitions();
+	}
+
+	return done(_failed.isEmpty(), true);
+}
+
+/*---open a device and queue its operations---*/
+bool QP_Batch::prepare(const QJsonObject &plan) {
+	_path = plan.value("device").toString();
+	_libparted = NULL;
+
+	QJsonArray operations = plan.value("operations").toArray();
+
+	if (_path.isEmpty())
+		return error(tr("The plan has no \"device\"."));
+
+	if (_paths.values().contains(_path))
+		return error(tr("The device %1 is in the plan more than once.").arg(_path));
+
+	QP_DevList::pedListMutex()->lock();
+	PedDevice *dev = ped_device_get(_path.toLatin1().constData());
+	QP_DevList::pedListMutex()->unlock();
+	if (!dev)
+		return error(tr("Cannot open the device %1.").arg(_path));
+
+	QP_Device *device = new QP_Device(_settings);
+	_devices.append(device);
+	device->setShortname(_path);
+	device->setPartitionTable(ped_disk_probe(dev) != NULL);
+	device->setIsBusy(ped_device_is_busy(dev));
+
+	/*---the operations are checked on an empty table, that is written only
+	 *   by the commit: a plan that fail here leave the device as it is---*/
+	if (plan.value("newtable").toBool()) {
+		if (device->isBusy())
+			return error(tr("Cannot make a new partition table on %1: it is busy.").arg(_path));
+
+		device->setPartitionTable(true);
+		device->setFreshTable(true);
+	}
+
+	if (!device->partitionTable())
+		return error(tr("The device %1 has no partition table.").arg(_path));
+
+	_libparted = new QP_LibParted();
+	_libparteds.append(_libparted);
+	_paths.insert(_libparted, _path);
+
+	_libparted->setDevice(device);
+	_libparted->scan_partitions();
+
+	/*---queue all the operations: the first that fail stop the plan---*/
+	for (int i = 0; i < operations.count(); i++) {
+		if (!queue(i, operations.at(i).toObject()))
+			return false;
+
+		/*---the next operation look for the partitions after this one---*/
+		_libparted->scan_partitions();
+	}
+
+	return true;
+}
+
+bool QP_Batch::load(QString fileName, QJsonObject *plan) {
+	QFile file(fileName);
+
+	if (!file.open(QIODevice::ReadOnly))
+		return error(tr("Cannot read the plan %1.").arg(fileName));
+
+	QJsonParseError parseError;
+	QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+
+	if (!document.isObject())
+		return error(tr("The plan %1 is not valid: %2.").arg(fileName).arg(parseError.errorString()));
+
+	*plan = document.object();
+	return true;
+}
+
+bool QP_Batch::queue(int index, const QJsonObject &operation) {
+	QString op = operation.value("op").toString();
+	int num = operation.value("num").toInt(-1);
+	PedSector start = operation.value("start").toVariant().toLongLong();
+	PedSector end = operation.value("end").toVariant().toLongLong();
+	bool rc;
+
+	showDebug("batch::queue, %d: %s\n", index, op.toLatin1().data());
+
+	/*---all but create need an existing partition---*/
+	if ((op != "create") && !_libparted->numToPartInfo(num))
+		return error(tr("There is no partition %1.").arg(num), index);
+
+	if (op == "create") {
+		QP_FileSystemSpec *fsspec = _libparted->filesystem->nameToFSSpec(operation.value("fs").toString());
+		QTParted::partType type = partType(operation.value("type").toString("primary"));
+
+		if ((type != QTParted::extended) && !fsspec->create())
+			return error(tr("Cannot create a %1 filesystem.").arg(operation.value("fs").toString()), index);
+
+		rc = _libparted->mkpartfs(type, fsspec, start, end, operation.value("label").toString());
+	} else if (op == "resize") {
+		rc = _libparted->resize(num, start, end);
+	} else if (op == "move") {
+		rc = _libparted->move(num, start, end);
+	} else if (op == "copy") {
+		rc = _libparted->copy(num, partType(operation.value("type").toString("primary")), start);
+	} else if (op == "format") {
+		QP_FileSystemSpec *fsspec = _libparted->filesystem->nameToFSSpec(operation.value("fs").toString());
+
+		if (!fsspec->create())
+			return error(tr("Cannot create a %1 filesystem.").arg(operation.value("fs").toString()), index);
+
+		rc = _libparted->mkfs(num, fsspec, operation.value("label").toString());
+	} else if (op == "rm") {
+		rc = _libparted->rm(num);
+	} else if (op == "active") {
+		rc = _libparted->partition_set_flag_active(num, operation.value("value").toBool(true));
+	} else if (op == "hidden") {
+		rc = _libparted->partition_set_flag_hidden(num, operation.value("value").toBool(true));
+	} else
+		return error(tr("Unknown operation \"%1\".").arg(op), index);
+
+	if (!rc)
+		return error(_libparted->message(), index);
+
+	print("queued", QJsonObject{{"index", index}, {"op", op}}, _libparted);
+	return true;
+}
+
+QTParted::partType QP_Batch::partType(QString type) {
+	if (type == "logical")
+		return QTParted::logical;
+	else if (type == "extended")
+		return QTParted::extended;
+	else
+		return QTParted::primary;
+}
+
+/*---one JSON object for every line, so a script can read it as it come---*/
+void QP_Batch::print(QString event, QJsonObject object, QP_LibParted *libparted) {
+	object.insert("event", event);
+	if (libparted)
+		object.insert("device", _paths.value(libparted));
+	printf("%s\n", QJsonDocument(object).toJson(QJsonDocument::Compact).constData());
+	fflush(stdout);
+}
+
+void QP_Batch::printPartitions() {
+	QList<QP_PartInfo *> list = _libparted->partlist + _libparted->logilist;
+
+	for (QP_PartInfo *p : list) {
+		if (p->isFree())
+			continue;
+
+		QString type = (p->type == QTParted::logical) ? "logical"
+			     : (p->type == QTParted::extended) ? "extended" : "primary";
+
+		print("partition", QJsonObject{
+			{"num", p->num},
+			{"type", type},
+			{"start", (qint64)p->start},
+			{"end", (qint64)p->end},
+			{"fs", p->fsspec->name()},
+			{"label", p->label()},
+			{"active", p->isActive()}}, _libparted);
+	}
+}
+
+bool QP_Batch::error(QString message, int index) {
+	QJsonObject object{{"message", message}};
+
+	if (!_path.isEmpty())
+		object.insert("device", _path);
+
+	if (index >= 0)
+		object.insert("index", index);
+
+	print("error", object);
+	return false;
+}
+
+int QP_Batch::done(bool ok, bool committed) {
+	print("done", QJsonObject{{"ok", ok}, {"committed", committed}});
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void QP_Batch::slotTimer(QP_LibParted *libparted, int percent, QString state, QString timeleft) {
+	/*---the same update the GUI get (see QP_Progress)---*/
+	QP_ProgressInfo info = libparted->progress()->last();
+
+	print("timer", QJsonObject{
+		{"percent", percent},
+		{"state", state},
+		{"timeleft", timeleft},
+		{"bytes_done", (double)info.bytesDone},
+		{"bytes_total", (double)info.bytesTotal},
+		{"rate", info.rate},
+		{"eta", info.eta}}, libparted);
+}
+
+void QP_Batch::slotOperations(QP_LibParted *libparted, QString operation, QString error, int done, int total) {
+	if (!error.isEmpty())
+		_failed.insert(libparted);
+
+	print("operation", QJsonObject{
+		{"message", operation},
+		{"error", error},
+		{"done", done},
+		{"total", total}}, libparted);
+}
+
+void QP_Batch::slotProgress(int percent, int running, int finished, int total, QString timeleft) {
+	print("overall", QJsonObject{
+		{"percent", percent},
+		{"running", running},
+		{"finished", finished},
+		{"total", total},
+		{"timeleft", timeleft}});
+}
@@ -0,0 +1,106 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* About QP_Batch class:
+ *
+ * Run a plan without the GUI (qparted --batch plan.json). The plan is a JSON
+ * object with the device and the operations to do, in order:
+ *
+ *   { "device": "/dev/sdb",
+ *     "newtable": false,
+ *     "commit": true,
+ *     "operations": [
+ *       { "op": "create", "type": "primary", "start": 2048, "end": 1050623,
+ *         "fs": "ext3", "label": "boot" },
+ *       { "op": "resize", "num": 2, "start": 1050624, "end": 9439231 },
+ *       { "op": "move",   "num": 3, "start": 9439232, "end": 20000000 },
+ *       { "op": "copy",   "num": 2, "type": "logical", "start": 20000001 },
+ *       { "op": "format", "num": 3, "fs": "fat32", "label": "data" },
+ *       { "op": "rm",     "num": 4 },
+ *       { "op": "active", "num": 1, "value": true },
+ *       { "op": "hidden", "num": 3, "value": false } ] }
+ *
+ * With "newtable" the operations are made on a new empty (msdos) partition
+ * table, that replace the old one only when the plan is committed.
+ *
+ * Sectors are the ones of the device. The operations are queued with
+ * QP_LibParted (so they are checked like in the GUI) and committed together.
+ *
+ * More devices can be committed at the same time with a list of plans:
+ *
+ *   { "jobs": 2, "serialize_bus": true,
+ *     "devices": [ { "device": "/dev/sdb", "operations": [ ... ] },
+ *                  { "device": "/dev/sdc", "operations": [ ... ] } ] }
+ *
+ * "jobs" and "serialize_bus" are optional (the default come from the
+ * settings), see QP_CommitScheduler.
+ *
+ * Every event is printed on stdout as a JSON object on a line by itself,
+ * with the "device" it is about: "queued", "timer", "operation",
+ * "partition", "error", "overall" (all the devices together) and, at last,
+ * "done". A "timer" come at most every PROGRESS_FRAME msecs for a device,
+ * with "bytes_done", "bytes_total", "rate" (bytes/s) and "eta" (seconds):
+ * see QP_Progress.
+ */
+
+#ifndef QP_BATCH_H
+#define QP_BATCH_H
+
+#include <QObject>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include "qp_libparted.h"
+#include "qp_settings.h"
+
+class QP_Batch : public QObject {
+	Q_OBJECT
+public:
+	QP_Batch(QP_Settings *);
+	~QP_Batch();
+	int run(QString);	/*---run a plan file, return the exit code---*/
+
+private:
+	bool load(QString, QJsonObject *);
+	bool prepare(const QJsonObject &);
+	bool queue(int, const QJsonObject &);
+	void print(QString, QJsonObject, QP_LibParted *libparted = NULL);
+	void printPartitions();
+	bool error(QString, int index = -1);
+	int done(bool, bool);
+	QTParted::partType partType(QString);
+	QP_Settings *_settings;
+	QList<QP_Device *> _devices;
+	QList<QP_LibParted *> _libparteds;
+	QHash<QP_LibParted *, QString> _paths;	/*---the device of every QP_LibParted---*/
+	QSet<QP_LibParted *> _failed;		/*---devices with an error in the commit---*/
+	QP_LibParted *_libparted;		/*---the device being prepared---*/
+	QString _path;
+
+private slots:
+	void slotTimer(QP_LibParted *, int, QString, QString);
+	void slotOperations(QP_LibParted *, QString, QString, int, int);
+	void slotProgress(int, int, int, int, QString);
+};
+
+#endif
@@ -0,0 +1,702 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QThread>
+#include "qp_blockcopy.h"
+#include "qp_debug.h"
+
+/*---state of a slot (a buffer) of the io_uring copy---*/
+#define SLOT_FREE    0
+#define SLOT_READING 1
+#define SLOT_READ    2
+#define SLOT_WRITING 3
+
+/*---read the whole "length" bytes, retrying short reads---*/
+static bool full_pread(int fd, char *buffer, long long length, long long offset) {
+	while (length > 0) {
+		ssize_t n = pread(fd, buffer, length, offset);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0) {
+			if (n == 0)
+				errno = EIO;
+			return false;
+		}
+		buffer += n;
+		offset += n;
+		length -= n;
+	}
+	return true;
+}
+
+static bool full_pwrite(int fd, const char *buffer, long long length, long long offset) {
+	while (length > 0) {
+		ssize_t n = pwrite(fd, buffer, length, offset);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0) {
+			if (n == 0)
+				errno = ENOSPC;
+			return false;
+		}
+		buffer += n;
+		offset += n;
+		length -= n;
+	}
+	return true;
+}
+
+
+/*-begin of QP_BlockCopyRing-----------------------------------------------------------------------*/
+
+/*---a minimal io_uring, with the raw syscalls: liburing is not needed for a
+ *   single ring with one kind of request---*/
+class QP_BlockCopyRing {
+public:
+	QP_BlockCopyRing(unsigned entries, char **buffers, int count, size_t length);
+	~QP_BlockCopyRing();
+	bool ok() { return _fd >= 0; }
+	void prepare(bool write, int fd, int buffer, size_t offset, size_t length,
+		     long long position, uint64_t data);
+	int submit(unsigned count, unsigned wait);
+	bool reap(uint64_t *data, int *result);
+
+private:
+	int _fd;
+	bool _fixed;			/*---buffers registered with the kernel---*/
+	struct iovec *_iov;
+	char **_buffers;
+	void *_sq;
+	void *_cq;
+	size_t _sqSize;
+	size_t _cqSize;
+	struct io_uring_sqe *_sqes;
+	size_t _sqesSize;
+	unsigned *_sqTail;
+	unsigned *_sqMask;
+	unsigned *_sqArray;
+	unsigned *_cqHead;
+	unsigned *_cqTail;
+	unsigned *_cqMask;
+	struct io_uring_cqe *_cqes;
+};
+
+QP_BlockCopyRing::QP_BlockCopyRing(unsigned entries, char **buffers, int count, size_t length) {
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+
+	_sq = MAP_FAILED;
+	_cq = MAP_FAILED;
+	_sqes = (struct io_uring_sqe *)MAP_FAILED;
+	_fixed = false;
+	_buffers = buffers;
+
+	_iov = new struct iovec[count];
+	for (int i = 0; i < count; i++) {
+		_iov[i].iov_base = buffers[i];
+		_iov[i].iov_len = length;
+	}
+
+	_fd = syscall(__NR_io_uring_setup, entries, &params);
+	if (_fd < 0) {
+		showDebug("blockcopyring::blockcopyring, io_uring_setup ko: %s\n", strerror(errno));
+		return;
+	}
+
+	_sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	_cqSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (_cqSize > _sqSize)
+			_sqSize = _cqSize;
+		_cqSize = _sqSize;
+	}
+
+	_sq = mmap(NULL, _sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+	if (_sq == MAP_FAILED)
+		goto error;
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+		_cq = _sq;
+	else {
+		_cq = mmap(NULL, _cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+		if (_cq == MAP_FAILED)
+			goto error;
+	}
+
+	_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+	_sqes = (struct io_uring_sqe *)mmap(NULL, _sqesSize, PROT_READ | PROT_WRITE,
+					     MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+	if (_sqes == MAP_FAILED)
+		goto error;
+
+	_sqTail = (unsigned *)((char *)_sq + params.sq_off.tail);
+	_sqMask = (unsigned *)((char *)_sq + params.sq_off.ring_mask);
+	_sqArray = (unsigned *)((char *)_sq + params.sq_off.array);
+	_cqHead = (unsigned *)((char *)_cq + params.cq_off.head);
+	_cqTail = (unsigned *)((char *)_cq + params.cq_off.tail);
+	_cqMask = (unsigned *)((char *)_cq + params.cq_off.ring_mask);
+	_cqes = (struct io_uring_cqe *)((char *)_cq + params.cq_off.cqes);
+
+	/*---registered buffers save a get_user_pages for every request; with a
+	 *   low RLIMIT_MEMLOCK the kernel refuse them, and readv/writev is used---*/
+	_fixed = syscall(__NR_io_uring_register, _fd, IORING_REGISTER_BUFFERS, _iov, count) == 0;
+	showDebug("blockcopyring::blockcopyring, %u entries, fixed buffers %s\n",
+		  params.sq_entries, _fixed ? "yes" : "no");
+	return;
+
+error:
+	showDebug("blockcopyring::blockcopyring, mmap ko: %s\n", strerror(errno));
+	if (_sq != MAP_FAILED)
+		munmap(_sq, _sqSize);
+	if (_cq != MAP_FAILED && _cq != _sq)
+		munmap(_cq, _cqSize);
+	close(_fd);
+	_fd = -1;
+}
+
+QP_BlockCopyRing::~QP_BlockCopyRing() {
+	if (_fd >= 0) {
+		munmap(_sqes, _sqesSize);
+		if (_cq != _sq)
+			munmap(_cq, _cqSize);
+		munmap(_sq, _sqSize);
+		close(_fd);		/*---unregister the buffers too---*/
+	}
+	delete[] _iov;
+}
+
+/*---queue a read (or a write) of "length" bytes at "offset" in a buffer;
+ *   the caller never queue more requests than the ring have entries---*/
+void QP_BlockCopyRing::prepare(bool write, int fd, int buffer, size_t offset, size_t length,
+			       long long position, uint64_t data) {
+	unsigned tail = *_sqTail;
+	unsigned index = tail & *_sqMask;
+	struct io_uring_sqe *sqe = &_sqes[index];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->fd = fd;
+	sqe->off = position;
+	sqe->user_data = data;
+
+	if (_fixed) {
+		sqe->opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+		sqe->addr = (uint64_t)(uintptr_t)(_buffers[buffer] + offset);
+		sqe->len = length;
+		sqe->buf_index = buffer;
+	} else {
+		/*---the iovec must live until the request complete: one for buffer---*/
+		_iov[buffer].iov_base = _buffers[buffer] + offset;
+		_iov[buffer].iov_len = length;
+		sqe->opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+		sqe->addr = (uint64_t)(uintptr_t)&_iov[buffer];
+		sqe->len = 1;
+	}
+
+	_sqArray[index] = index;
+	__atomic_store_n(_sqTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/*---submit "count" requests and wait for at least "wait" completions---*/
+int QP_BlockCopyRing::submit(unsigned count, unsigned wait) {
+	int rc;
+
+	do {
+		rc = syscall(__NR_io_uring_enter, _fd, count, wait, IORING_ENTER_GETEVENTS, NULL, 0);
+	} while (rc < 0 && errno == EINTR);
+
+	return rc;
+}
+
+bool QP_BlockCopyRing::reap(uint64_t *data, int *result) {
+	unsigned head = *_cqHead;
+
+	if (head == __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE))
+		return false;
+
+	struct io_uring_cqe *cqe = &_cqes[head & *_cqMask];
+	*data = cqe->user_data;
+	*result = cqe->res;
+
+	__atomic_store_n(_cqHead, head + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+/*-end of QP_BlockCopyRing-------------------------------------------------------------------------*/
+
+
+/*-begin of QP_BlockCopyWorker---------------------------------------------------------------------*/
+
+/*---the fallback without io_uring: "depth" threads, every one with its own
+ *   buffer, take the blocks in order and copy them with pread/pwrite---*/
+class QP_BlockCopyWorker : public QThread {
+public:
+	QP_BlockCopyWorker(QP_BlockCopy *copy, int buffer) {
+		_copy = copy;
+		_buffer = buffer;
+	}
+
+protected:
+	void run();
+
+private:
+	bool readPending(long long);
+	QP_BlockCopy *_copy;
+	int _buffer;
+};
+
+/*---is a block before "block" still being read?---*/
+bool QP_BlockCopyWorker::readPending(long long block) {
+	for (long long reading : _copy->_reading)
+		if (reading < block)
+			return true;
+	return false;
+}
+
+void QP_BlockCopyWorker::run() {
+	long long sector_size = _copy->_dev->sector_size;
+	char *buffer = _copy->_buffer[_buffer];
+
+	_copy->_mutex.lock();
+
+	while (!_copy->_failed && (_copy->_next < _copy->_blocks)) {
+		long long i = _copy->_next++;
+		_copy->_reading.append(i);
+		_copy->_mutex.unlock();
+
+		PedSector offset, count;
+		_copy->block(i, &offset, &count);
+
+		bool ok = full_pread(_copy->_fd, buffer, count * sector_size,
+				     (_copy->_from + offset) * sector_size);
+		int error = errno;
+
+		_copy->_mutex.lock();
+		_copy->_reading.removeOne(i);
+		_copy->_cond.wakeAll();
+		if (!ok) {
+			_copy->fail(QString("read error at sector %1").arg(_copy->_from + offset), error);
+			break;
+		}
+
+		/*---the blocks before this one may not be in memory yet, and this
+		 *   write could overwrite them---*/
+		while (!_copy->_failed && readPending(i))
+			_copy->_cond.wait(&_copy->_mutex);
+		if (_copy->_failed)
+			break;
+		_copy->_mutex.unlock();
+
+		ok = full_pwrite(_copy->_fd, buffer, count * sector_size,
+				 (_copy->_to + offset) * sector_size);
+		error = errno;
+
+		_copy->_mutex.lock();
+		if (!ok) {
+			_copy->fail(QString("write error at sector %1").arg(_copy->_to + offset), error);
+			break;
+		}
+		_copy->_written++;
+		_copy->_cond.wakeAll();
+	}
+
+	_copy->_cond.wakeAll();
+	_copy->_mutex.unlock();
+}
+
+/*-end of QP_BlockCopyWorker-----------------------------------------------------------------------*/
+
+
+/*-begin of QP_BlockCopy---------------------------------------------------------------------------*/
+
+QP_BlockCopy::QP_BlockCopy(PedDevice *dev, int depth, int blockSize) {
+	_dev = dev;
+	_depth = depth < 1 ? 1 : depth;
+	_ring = NULL;
+	_cancel = NULL;
+	_failed = false;
+
+	_blockSectors = blockSize / _dev->sector_size;
+	if (_blockSectors < 1)
+		_blockSectors = 1;
+
+	_buffer = new char *[_depth];
+	for (int i = 0; i < _depth; i++)
+		_buffer[i] = NULL;
+
+	/*---O_DIRECT don't pollute the page cache with the whole partition; a
+	 *   device (or an image on tmpfs) that refuse it is opened as usual---*/
+	_direct = true;
+	_fd = open(_dev->path, O_RDWR | O_DIRECT);
+	if ((_fd < 0) && (errno == EINVAL)) {
+		_direct = false;
+		_fd = open(_dev->path, O_RDWR);
+	}
+
+	if (_fd < 0) {
+		fail(QString("cannot open %1").arg(_dev->path), errno);
+		return;
+	}
+
+	for (int i = 0; i < _depth; i++) {
+		void *p;
+		if (posix_memalign(&p, BLOCKCOPY_ALIGN, _blockSectors * _dev->sector_size) != 0) {
+			fail(QString("cannot allocate the copy buffers"), ENOMEM);
+			return;
+		}
+		_buffer[i] = (char *)p;
+	}
+
+	/*---a read and a write for every buffer can be queued at the same time---*/
+	_ring = new QP_BlockCopyRing(2 * _depth, _buffer, _depth, _blockSectors * _dev->sector_size);
+	if (!_ring->ok()) {
+		delete _ring;
+		_ring = NULL;
+	}
+
+	showDebug("blockcopy::blockcopy, %s, O_DIRECT %s, %s, %d x %lld bytes\n",
+		  _dev->path, _direct ? "yes" : "no", backend(),
+		  _depth, _blockSectors * _dev->sector_size);
+}
+
+QP_BlockCopy::~QP_BlockCopy() {
+	delete _ring;
+	for (int i = 0; i < _depth; i++)
+		free(_buffer[i]);
+	delete[] _buffer;
+	if (_fd >= 0)
+		close(_fd);
+}
+
+void QP_BlockCopy::setCancel(const QAtomicInt *cancel) {
+	_cancel = cancel;
+}
+
+bool QP_BlockCopy::canceled() {
+	return _cancel && (_cancel->load() != 0);
+}
+
+QString QP_BlockCopy::message() {
+	return _message;
+}
+
+const char *QP_BlockCopy::backend() {
+	return _ring ? "io_uring" : "threads";
+}
+
+/*---remember only the first error: the other requests fail just after it.
+ *   The workers call it with _mutex locked---*/
+bool QP_BlockCopy::fail(QString message, int error) {
+	if (!_failed || _message.isEmpty()) {
+		_message = QString("%1: %2").arg(message).arg(strerror(error));
+		showDebug("blockcopy::fail, %s\n", _message.toLatin1().data());
+	}
+	_failed = true;
+	return false;
+}
+
+/*---sectors of the block "i", relative to the start of the range. Going
+ *   backward the blocks are the same, in the reverse order---*/
+void QP_BlockCopy::block(long long i, PedSector *offset, PedSector *count) {
+	if (_backward)
+		i = _blocks - 1 - i;
+
+	/*---the last range that start before the block---*/
+	int r = std::upper_bound(_firstBlock.begin(), _firstBlock.end(), i) - _firstBlock.begin() - 1;
+	const QP_Extent &range = _ranges[r];
+
+	*offset = range.offset + (i - _firstBlock[r]) * _blockSectors;
+	*count = range.offset + range.length - *offset;
+	if (*count > _blockSectors)
+		*count = _blockSectors;
+}
+
+bool QP_BlockCopy::copy(PedSector from, PedSector to, PedSector count, PedTimer *timer,
+		       const QVector<QP_Extent> *used) {
+	long long sector_size = _dev->sector_size;
+	QElapsedTimer elapsed;
+	PedSector copied = 0;
+	bool ok;
+
+	if (_fd < 0 || !_buffer[_depth - 1])
+		return false;
+
+	if (count < 1 || from == to)
+		return true;
+
+	_from = from;
+	_to = to;
+	_count = count;
+
+	/*---the ranges in use, rounded out to whole sectors---*/
+	_ranges.clear();
+	if (!used) {
+		QP_Extent all = { 0, count };
+		_ranges.append(all);
+	}
+	else {
+		for (const QP_Extent &e : *used) {
+			QP_Extent range;
+			range.offset = e.offset / sector_size;
+			range.length = (e.offset + e.length + sector_size - 1) / sector_size;
+			if (range.length > count)
+				range.length = count;
+			range.length -= range.offset;
+			if (range.length > 0)
+				_ranges.append(range);
+		}
+	}
+
+	_firstBlock.clear();
+	_blocks = 0;
+	for (const QP_Extent &range : _ranges) {
+		_firstBlock.append(_blocks);
+		_blocks += (range.length + _blockSectors - 1) / _blockSectors;
+		copied += range.length;
+	}
+
+	_next = 0;
+	_written = 0;
+	_reading.clear();
+	_failed = false;
+	_message = QString::null;
+
+	/*---moving to the right over itself: start from the end, or the first
+	 *   block written would overwrite sectors not yet read---*/
+	_backward = (to > from) && (to < from + count);
+
+	showDebug("blockcopy::copy, %lld sectors from %lld to %lld, %s, %lld sectors in use\n",
+		  count, from, to, _backward ? "backward" : "forward", copied);
+
+	ped_timer_reset(timer);
+	ped_timer_set_state_name(timer, "moving data");
+
+	elapsed.start();
+	ok = _ring ? copyRing(timer) : copyThreads(timer);
+
+	/*---with O_DIRECT the data is already out of the page cache, but the
+	 *   disk may still have it in its own cache---*/
+	if (ok && used)
+		punchHoles();
+
+	if (ok && fsync(_fd) != 0)
+		ok = fail(QString("cannot flush %1").arg(_dev->path), errno);
+
+	if (ok) {
+		double seconds = elapsed.elapsed() / 1000.0;
+		double mbytes = (double)copied * sector_size / (1024 * 1024);
+		showDebug("blockcopy::copy, %.1f MiB in %.2f s, %.1f MiB/s with %s\n",
+			  mbytes, seconds, seconds > 0 ? mbytes / seconds : 0.0, backend());
+	}
+
+	return ok;
+}
+
+/*---a disk image should stay sparse: free the holes between the ranges
+ *   copied. On a real disk they are left as they are---*/
+void QP_BlockCopy::punchHoles() {
+	long long sector_size = _dev->sector_size;
+	struct stat st;
+	PedSector hole = 0;
+	int punched = 0;
+
+	if ((fstat(_fd, &st) != 0) || !S_ISREG(st.st_mode))
+		return;
+
+	for (int r = 0; r <= _ranges.count(); r++) {
+		PedSector end = (r < _ranges.count()) ? _ranges[r].offset : _count;
+
+		if ((end > hole)
+		 && (fallocate(_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+			       (_to + hole) * sector_size, (end - hole) * sector_size) == 0))
+			punched++;
+
+		if (r < _ranges.count())
+			hole = _ranges[r].offset + _ranges[r].length;
+	}
+
+	showDebug("blockcopy::punchHoles, %d holes punched\n", punched);
+}
+
+bool QP_BlockCopy::copyRing(PedTimer *timer) {
+	long long sector_size = _dev->sector_size;
+	QVector<int> state(_depth, SLOT_FREE);
+	QVector<long long> block(_depth);
+	QVector<long long> done(_depth);
+	int inflight = 0;
+
+	while (true) {
+		unsigned queued = 0;
+
+		if (!_failed && canceled())
+			fail(QString("canceled at block %1 of %2").arg(_written).arg(_blocks), ECANCELED);
+
+		if (!_failed) {
+			for (int s = 0; s < _depth && _next < _blocks; s++) {
+				if (state[s] != SLOT_FREE)
+					continue;
+
+				PedSector offset, count;
+				block[s] = _next++;
+				done[s] = 0;
+				state[s] = SLOT_READING;
+				_reading.append(block[s]);
+
+				this->block(block[s], &offset, &count);
+				_ring->prepare(false, _fd, s, 0, count * sector_size,
+					       (_from + offset) * sector_size, s);
+				queued++;
+			}
+
+			/*---a block is written only when all the blocks before it are in
+			 *   memory (the reads can complete in any order)---*/
+			long long firstReading = _reading.isEmpty() ? _blocks : _reading.first();
+			for (long long reading : _reading)
+				if (reading < firstReading)
+					firstReading = reading;
+
+			for (int s = 0; s < _depth; s++) {
+				if ((state[s] != SLOT_READ) || (block[s] > firstReading))
+					continue;
+
+				PedSector offset, count;
+				done[s] = 0;
+				state[s] = SLOT_WRITING;
+
+				this->block(block[s], &offset, &count);
+				_ring->prepare(true, _fd, s, 0, count * sector_size,
+					       (_to + offset) * sector_size, s);
+				queued++;
+			}
+		}
+
+		inflight += queued;
+		if (inflight == 0)
+			break;
+
+		if (_ring->submit(queued, 1) < 0) {
+			/*---nothing is in flight if the kernel refused the submission---*/
+			fail(QString("io_uring_enter"), errno);
+			break;
+		}
+
+		uint64_t data;
+		int result;
+
+		while (_ring->reap(&data, &result)) {
+			int s = (int)data;
+			PedSector offset, count;
+
+			inflight--;
+			this->block(block[s], &offset, &count);
+
+			if (result <= 0) {
+				if (state[s] == SLOT_READING)
+					fail(QString("read error at sector %1").arg(_from + offset),
+					     result < 0 ? -result : EIO);
+				else
+					fail(QString("write error at sector %1").arg(_to + offset),
+					     result < 0 ? -result : ENOSPC);
+				if (state[s] == SLOT_READING)
+					_reading.removeOne(block[s]);
+				state[s] = SLOT_FREE;
+				continue;
+			}
+
+			/*---a short transfer: queue the rest of the block again---*/
+			done[s] += result;
+			if (done[s] < count * sector_size) {
+				bool write = state[s] == SLOT_WRITING;
+				_ring->prepare(write, _fd, s, done[s], count * sector_size - done[s],
+					       ((write ? _to : _from) + offset) * sector_size + done[s], s);
+				if (_ring->submit(1, 0) < 0) {
+					fail(QString("io_uring_enter"), errno);
+					if (!write)
+						_reading.removeOne(block[s]);
+					state[s] = SLOT_FREE;
+					continue;
+				}
+				inflight++;
+				continue;
+			}
+
+			if (state[s] == SLOT_READING) {
+				_reading.removeOne(block[s]);
+				state[s] = SLOT_READ;
+			} else {
+				state[s] = SLOT_FREE;
+				_written++;
+				ped_timer_update(timer, (float)_written / _blocks);
+			}
+		}
+	}
+
+	return !_failed;
+}
+
+bool QP_BlockCopy::copyThreads(PedTimer *timer) {
+	QList<QP_BlockCopyWorker *> workers;
+
+	for (int i = 0; i < _depth; i++) {
+		QP_BlockCopyWorker *worker = new QP_BlockCopyWorker(this, i);
+		workers.append(worker);
+		worker->start();
+	}
+
+	/*---the PedTimer call back into the GUI: update it from this thread---*/
+	_mutex.lock();
+	while (!_failed && (_written < _blocks)) {
+		/*---wake up now and then to see if the copy was canceled---*/
+		_cond.wait(&_mutex, 250);
+		if (canceled()) {
+			fail(QString("canceled at block %1 of %2").arg(_written).arg(_blocks), ECANCELED);
+			break;
+		}
+
+		float frac = (float)_written / _blocks;
+		_mutex.unlock();
+		ped_timer_update(timer, frac);
+		_mutex.lock();
+	}
+	_mutex.unlock();
+
+	for (QP_BlockCopyWorker *worker : workers) {
+		worker->wait();
+		delete worker;
+	}
+
+	return !_failed;
+}
+
+/*-end of QP_BlockCopy-----------------------------------------------------------------------------*/
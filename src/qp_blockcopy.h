@@ -0,0 +1,109 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* About QP_BlockCopy class:
+ *
+ * Parted 3.x dropped the filesystem code, ped_file_system_copy included, so
+ * QP_LibParted::move need its own way to move the sectors of a partition.
+ * A QP_BlockCopy open the disk with O_DIRECT (if the kernel let it) and copy
+ * a range of sectors in blocks of "blockSize" bytes, keeping "depth" blocks
+ * in flight: with io_uring if the kernel has it (one ring, the buffers are
+ * registered once), else with a small pool of threads doing pread/pwrite.
+ *
+ * When the source and the destination overlap the blocks are copied from the
+ * end to the start (or from the start to the end), and a block is written
+ * only when every block before it has been read: no sector is overwritten
+ * before it has been read, whatever the order the reads complete in.
+ *
+ * Given the ranges in use (see QP_FSStats::extents) only these are copied;
+ * on a disk image the holes are punched in the destination, so the image
+ * stay sparse.
+ *
+ * The progress is reported with the PedTimer given to "copy", exactly like
+ * libparted do for its own operations. A copy stop (and fail) as soon as
+ * the flag given to "setCancel" is set: the blocks in flight are completed
+ * and no other is started.
+ */
+
+#ifndef QP_BLOCKCOPY_H
+#define QP_BLOCKCOPY_H
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <QVector>
+#include <parted/parted.h>
+#include "qp_fsstats.h"
+
+#define BLOCKCOPY_DEPTH  8			/*---blocks in flight          ---*/
+#define BLOCKCOPY_BUFFER (1024 * 1024)		/*---bytes for every read/write---*/
+#define BLOCKCOPY_ALIGN  4096			/*---alignment asked by O_DIRECT---*/
+
+class QP_BlockCopyRing;
+class QP_BlockCopyWorker;
+
+class QP_BlockCopy {
+	friend class QP_BlockCopyWorker;
+public:
+	QP_BlockCopy(PedDevice *, int depth = BLOCKCOPY_DEPTH, int blockSize = BLOCKCOPY_BUFFER);
+	~QP_BlockCopy();
+	bool copy(PedSector from, PedSector to, PedSector count, PedTimer *,
+		  const QVector<QP_Extent> *used = NULL);	/*---NULL: copy every sector---*/
+	void setCancel(const QAtomicInt *);	/*---stop when it is not 0---*/
+	QString message();
+	const char *backend();		/*---"io_uring" or "threads"---*/
+
+private:
+	void block(long long, PedSector *, PedSector *);
+	bool fail(QString, int);
+	bool canceled();
+	bool copyRing(PedTimer *);
+	bool copyThreads(PedTimer *);
+	void punchHoles();
+	PedDevice *_dev;
+	int _fd;
+	bool _direct;
+	int _depth;
+	char **_buffer;
+	PedSector _blockSectors;
+	QP_BlockCopyRing *_ring;
+	const QAtomicInt *_cancel;
+
+	/*---state of the copy in progress, shared with the workers---*/
+	PedSector _from;
+	PedSector _to;
+	PedSector _count;
+	bool _backward;
+	QVector<QP_Extent> _ranges;	/*---sectors to copy, from "from"   ---*/
+	QVector<long long> _firstBlock;	/*---first block of every range     ---*/
+	long long _blocks;
+	long long _next;		/*---next block to read          ---*/
+	long long _written;		/*---blocks done                 ---*/
+	QList<long long> _reading;	/*---blocks being read           ---*/
+	QMutex _mutex;
+	QWaitCondition _cond;
+	bool _failed;
+	QString _message;
+};
+
+#endif
@@ -0,0 +1,163 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <string.h>
+#include <QMutex>
+#include <QMutexLocker>
+#include "qp_blockreader.h"
+#include "qp_debug.h"
+
+/*---the readers alive, one for every device---*/
+static QHash<PedDevice *, QP_BlockReader *> readers;
+static QMutex readersMutex;
+
+QP_BlockReader::QP_BlockReader(PedDevice *dev) {
+	_dev = dev;
+	_calls = 0;
+	_reads = 0;
+	_bytesAsked = 0;
+	_bytesRead = 0;
+
+	_chunkSectors = BLOCKREADER_CHUNK / _dev->sector_size;
+	if (_chunkSectors < 1)
+		_chunkSectors = 1;
+
+	_open = ped_device_open(_dev);
+	if (!_open) {
+		showDebug("%s", "blockreader::blockreader, ped_device_open ko\n");
+		return;
+	}
+
+	QMutexLocker locker(&readersMutex);
+	if (!readers.contains(_dev))
+		readers.insert(_dev, this);
+}
+
+QP_BlockReader::~QP_BlockReader() {
+	if (!_open)
+		return;
+
+	readersMutex.lock();
+	if (readers.value(_dev) == this)
+		readers.remove(_dev);
+	readersMutex.unlock();
+
+	ped_device_close(_dev);
+
+	/*---the old path was open+read+close for every call---*/
+	showDebug("blockreader::~blockreader, %s: %lld reads for %lld calls, "
+		  "%lld syscalls saved, %lld bytes asked, %lld bytes read\n",
+		  _dev->path, _reads, _calls,
+		  (_calls * 3) - (_reads + 2), _bytesAsked, _bytesRead);
+}
+
+QP_BlockReader *QP_BlockReader::find(PedDevice *dev) {
+	QMutexLocker locker(&readersMutex);
+	return readers.value(dev, NULL);
+}
+
+/*---read the chunks first..last that are not in the cache; a run of missing
+ *   chunks is read with a single ped_device_read---*/
+bool QP_BlockReader::fill(long long first, long long last) {
+	long long chunk = first;
+
+	if (_chunks.count() + (last - first + 1) > BLOCKREADER_MAXCHUNKS)
+		_chunks.clear();
+
+	while (chunk <= last) {
+		if (_chunks.contains(chunk)) {
+			chunk++;
+			continue;
+		}
+
+		long long runEnd = chunk;
+		while ((runEnd + 1 <= last) && !_chunks.contains(runEnd + 1))
+			runEnd++;
+
+		PedSector start = chunk * _chunkSectors;
+		PedSector count = (runEnd - chunk + 1) * _chunkSectors;
+		if (start + count > _dev->length)
+			count = _dev->length - start;
+
+		QByteArray run(count * _dev->sector_size, 0);
+		if (!ped_device_read(_dev, run.data(), start, count))
+			return false;
+		_reads++;
+		_bytesRead += run.size();
+
+		/*---a short chunk at the end of the device is padded with zeros---*/
+		int chunkBytes = _chunkSectors * _dev->sector_size;
+		for (long long c = chunk; c <= runEnd; c++) {
+			QByteArray data = run.mid((c - chunk) * chunkBytes, chunkBytes);
+			data.resize(chunkBytes);
+			_chunks.insert(c, data);
+		}
+
+		chunk = runEnd + 1;
+	}
+
+	return true;
+}
+
+bool QP_BlockReader::read(PedGeometry *geom, PedSector offset, PedSector count, char *buffer) {
+	if (!_open)
+		return false;
+
+	if ((offset < 0) || (count < 1) || (offset + count > geom->length))
+		return false;
+
+	_calls++;
+	_bytesAsked += count * _dev->sector_size;
+
+	PedSector start = geom->start + offset;
+	long long first = start / _chunkSectors;
+	long long last = (start + count - 1) / _chunkSectors;
+
+	/*---too big for the cache: read it as it is---*/
+	if (last - first + 1 > BLOCKREADER_MAXCHUNKS) {
+		_reads++;
+		_bytesRead += count * _dev->sector_size;
+		return ped_device_read(_dev, buffer, start, count);
+	}
+
+	if (!fill(first, last))
+		return false;
+
+	/*---copy from the cache into the buffer of the caller---*/
+	PedSector sector = start;
+	char *p = buffer;
+
+	while (sector < start + count) {
+		long long chunk = sector / _chunkSectors;
+		PedSector inChunk = sector - (chunk * _chunkSectors);
+		PedSector n = _chunkSectors - inChunk;
+		if (sector + n > start + count)
+			n = start + count - sector;
+
+		const QByteArray &data = _chunks[chunk];
+		memcpy(p, data.constData() + inChunk * _dev->sector_size, n * _dev->sector_size);
+
+		p += n * _dev->sector_size;
+		sector += n;
+	}
+
+	return true;
+}
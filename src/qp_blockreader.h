@@ -0,0 +1,66 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* About QP_BlockReader class:
+ *
+ * During a scan every label reader (and the probe cache) read a few sectors
+ * of every partition. Without a QP_BlockReader each of these reads open the
+ * device, read and close it again. A QP_BlockReader keep the device open for
+ * as long as it live, and read it in aligned chunks of BLOCKREADER_CHUNK
+ * bytes: superblock, boot sector and MFT reads that fall in the same chunk
+ * are served from memory.
+ *
+ * Just create one on the stack around the scan: QP_FSWrap::read_sector use
+ * it (see "find") while it exist.
+ */
+
+#ifndef QP_BLOCKREADER_H
+#define QP_BLOCKREADER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <parted/parted.h>
+
+#define BLOCKREADER_CHUNK     65536	/*---bytes read with a single syscall---*/
+#define BLOCKREADER_MAXCHUNKS 256	/*---cache at most 16MiB            ---*/
+
+class QP_BlockReader {
+public:
+	QP_BlockReader(PedDevice *);
+	~QP_BlockReader();
+	bool read(PedGeometry *, PedSector, PedSector, char *);	/*---like ped_geometry_read---*/
+	static QP_BlockReader *find(PedDevice *);	/*---the reader open on a device, if any---*/
+
+private:
+	bool fill(long long, long long);
+	PedDevice *_dev;
+	bool _open;
+	PedSector _chunkSectors;
+	QHash<long long, QByteArray> _chunks;
+
+	/*---statistics, compared with an open/read/close for every call---*/
+	long long _calls;
+	long long _reads;
+	long long _bytesAsked;
+	long long _bytesRead;
+};
+
+#endif
@@ -0,0 +1,215 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <QFileInfo>
+#include <QRegExp>
+#include <QStringList>
+#include "qp_commitscheduler.h"
+#include "qp_debug.h"
+
+/*---the thread of a device: it just commit all its operations---*/
+class QP_CommitWorker : public QThread {
+public:
+	QP_CommitWorker(QP_LibParted *libparted) : _libparted(libparted) {}
+
+protected:
+	void run() override {
+		_libparted->commit();
+	}
+
+private:
+	QP_LibParted *_libparted;
+};
+
+QP_CommitScheduler::QP_CommitScheduler(int jobs, bool serializeBus) {
+	_maxJobs = (jobs < 1) ? 1 : jobs;
+	_serializeBus = serializeBus;
+	_running = 0;
+	_finished = 0;
+	_lastPercent = -1;
+}
+
+QP_CommitScheduler::~QP_CommitScheduler() {
+	for (const Job &job : _jobs) {
+		if (job.worker) {
+			job.worker->wait();
+			delete job.worker;
+		}
+	}
+}
+
+void QP_CommitScheduler::add(QP_LibParted *libparted, QString device) {
+	Job job;
+	job.libparted = libparted;
+	job.bus = bus(device);
+	job.worker = NULL;
+	job.started = false;
+	job.finished = false;
+	job.step = 0;
+	job.steps = 1;
+	job.percent = 0;
+	_jobs.append(job);
+
+	showDebug("commitscheduler::add, %s on %s\n",
+		  device.toLatin1().data(), job.bus.toLatin1().data());
+
+	/*---the signals come from the worker thread: they are queued to this one---*/
+	connect(libparted, &QP_LibParted::sigTimer, this,
+		[this, libparted](int percent, QString state, QString timeleft) {
+			int i = find(libparted);
+			if (i >= 0)
+				_jobs[i].percent = percent;
+			emit sigTimer(libparted, percent, state, timeleft);
+			updateProgress();
+		});
+
+	connect(libparted, &QP_LibParted::sigOperations, this,
+		[this, libparted](QString operation, QString error, int step, int steps) {
+			int i = find(libparted);
+			if (i >= 0) {
+				_jobs[i].step = step;
+				_jobs[i].steps = (steps < 1) ? 1 : steps;
+				_jobs[i].percent = 0;
+			}
+			emit sigOperations(libparted, operation, error, step, steps);
+			updateProgress();
+		});
+}
+
+void QP_CommitScheduler::run() {
+	if (_jobs.isEmpty())
+		return;
+
+	_elapsed.start();
+	startNext();
+	updateProgress(true);
+
+	if (_finished < _jobs.count())
+		_loop.exec();
+}
+
+/*---start the devices that can go: not more than _maxJobs, and if asked
+ *   one for every controller---*/
+void QP_CommitScheduler::startNext() {
+	for (Job &job : _jobs) {
+		if (_running >= _maxJobs)
+			break;
+
+		if (job.started)
+			continue;
+
+		bool busy = false;
+		if (_serializeBus) {
+			for (const Job &other : _jobs)
+				if (other.started && !other.finished && (other.bus == job.bus))
+					busy = true;
+		}
+
+		if (busy)
+			continue;
+
+		job.started = true;
+		job.worker = new QP_CommitWorker(job.libparted);
+		connect(job.worker, SIGNAL(finished()), this, SLOT(slotFinished()));
+		_running++;
+		job.worker->start();
+	}
+}
+
+void QP_CommitScheduler::slotFinished() {
+	QThread *worker = qobject_cast<QThread *>(sender());
+
+	for (Job &job : _jobs) {
+		if (job.worker != worker)
+			continue;
+
+		job.finished = true;
+		_running--;
+		_finished++;
+
+		showDebug("commitscheduler::slotFinished, %d of %d devices done\n",
+			  _finished, _jobs.count());
+
+		emit sigFinished(job.libparted);
+	}
+
+	startNext();
+	updateProgress(true);
+
+	if (_finished == _jobs.count())
+		_loop.quit();
+}
+
+int QP_CommitScheduler::find(QP_LibParted *libparted) {
+	for (int i = 0; i < _jobs.count(); i++)
+		if (_jobs.at(i).libparted == libparted)
+			return i;
+
+	return -1;
+}
+
+/*---a device count for its steps done, plus the part of the current one---*/
+void QP_CommitScheduler::updateProgress(bool force) {
+	double done = 0;
+
+	for (const Job &job : _jobs) {
+		if (job.finished)
+			done += 1;
+		else if (job.started)
+			done += qBound(0.0, (job.step + job.percent / 100.0) / job.steps, 1.0);
+	}
+
+	double fraction = done / _jobs.count();
+	int percent = (int)(fraction * 100);
+
+	if (!force && (percent == _lastPercent))
+		return;
+	_lastPercent = percent;
+
+	QString timeleft;
+	if (fraction > 0) {
+		long long left = (long long)(_elapsed.elapsed() / 1000 * (1 - fraction) / fraction);
+		timeleft = QString("%1:%2").arg(left / 60, 2, 10, QChar('0'))
+					   .arg(left % 60, 2, 10, QChar('0'));
+	}
+
+	emit sigProgress(percent, _running, _finished, _jobs.count(), timeleft);
+}
+
+QString QP_CommitScheduler::bus(QString device) {
+	QString name = device.section('/', -1);
+	QString path = QFileInfo("/sys/block/" + name + "/device").canonicalFilePath();
+	QStringList parts = path.split('/', QString::SkipEmptyParts);
+	QRegExp pci("^[0-9a-f]{4}:[0-9a-f]{2}:[0-9a-f]{2}\\.[0-9a-f]$");
+
+	/*---the last PCI function in the path is the controller (AHCI, USB host,
+	 *   the NVMe itself...)---*/
+	int last = -1;
+	for (int i = 0; i < parts.count(); i++)
+		if (pci.exactMatch(parts.at(i)))
+			last = i;
+
+	/*---not known: a bus of its own---*/
+	if (last < 0)
+		return device;
+
+	return "/" + QStringList(parts.mid(0, last + 1)).join('/');
+}
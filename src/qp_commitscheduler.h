@@ -0,0 +1,92 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* About QP_CommitScheduler class:
+ *
+ * Commit the operations of several devices at the same time, every device
+ * in a thread of its own (at most "jobs" threads). Every device has its own
+ * QP_LibParted (so its own QP_ActionList and PedTimer): its progress is
+ * forwarded with the QP_LibParted it come from, and sigProgress give the
+ * progress of all the devices together.
+ *
+ * With "serializeBus" the devices attached to the same controller (the same
+ * PCI function in sysfs) are committed one at a time, so they don't fight
+ * for its bandwidth.
+ */
+
+#ifndef QP_COMMITSCHEDULER_H
+#define QP_COMMITSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include "qp_libparted.h"
+
+class QP_CommitScheduler : public QObject {
+	Q_OBJECT
+public:
+	QP_CommitScheduler(int jobs, bool serializeBus);
+	~QP_CommitScheduler();
+	void add(QP_LibParted *, QString);	/*---a device (and its path) to commit---*/
+	void run();				/*---commit all the devices, return when done---*/
+	static QString bus(QString);		/*---the controller of a device---*/
+
+signals:
+	/*---the progress of a device---*/
+	void sigTimer(QP_LibParted *, int, QString, QString);
+	void sigOperations(QP_LibParted *, QString, QString, int, int);
+	void sigFinished(QP_LibParted *);
+
+	/*---all the devices: percent, running, finished, total, time left---*/
+	void sigProgress(int, int, int, int, QString);
+
+private slots:
+	void slotFinished();
+
+private:
+	struct Job {
+		QP_LibParted *libparted;
+		QString bus;
+		QThread *worker;
+		bool started;
+		bool finished;
+		int step;	/*---from sigOperations---*/
+		int steps;
+		int percent;	/*---of the step, from sigTimer---*/
+	};
+
+	void startNext();
+	void updateProgress(bool force = false);
+	int find(QP_LibParted *);
+	QList<Job> _jobs;
+	int _maxJobs;
+	bool _serializeBus;
+	int _running;
+	int _finished;
+	int _lastPercent;
+	QElapsedTimer _elapsed;
+	QEventLoop _loop;
+};
+
+#endif
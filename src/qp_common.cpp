@@ -27,6 +27,9 @@
 #include <dirent.h>
 #include <stdio.h>
 
+#include <QApplication>
+#include <QMessageBox>
+#include <QThread>
 #include "qp_common.h"
 
 bool flagDevfsEnabled;
@@ -38,4 +41,17 @@ QP_ListExternalTools *lstExternalTools = new QP_ListExternalTools();
 bool isDevfsEnabled() {
     flagDevfsEnabled = !access("/dev/.devfsd", F_OK);
     return flagDevfsEnabled;
-}
\ No newline at end of file
+}
+
+void showMessage(QString label) {
+    QCoreApplication *app = QCoreApplication::instance();
+
+    /*---a commit run in a thread of its own: the box is shown by the GUI one---*/
+    if (qobject_cast<QApplication *>(app) && (QThread::currentThread() != app->thread()))
+        QMetaObject::invokeMethod(app, [label]() { showMessage(label); },
+                                  Qt::BlockingQueuedConnection);
+    else if (qobject_cast<QApplication *>(app))
+        QMessageBox::information(nullptr, "QtParted", label);
+    else
+        fprintf(stderr, "%s\n", label.toLocal8Bit().constData());
+}
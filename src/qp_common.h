@@ -27,3 +27,6 @@ extern bool flagDevfsEnabled;
 extern QP_ListExternalTools *lstExternalTools;
 
 bool isDevfsEnabled();
+
+/*---a message box, or a line on stderr when there is no GUI (batch mode)---*/
+void showMessage(QString);
@@ -17,6 +17,9 @@
 
 #include <qstring.h>
 #include <qdatetime.h>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
 #include <string.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -24,6 +27,12 @@
 
 #include "qp_debug.h"
 
+// the timeline start with the program (g_debug is built before main,
+// after these: keep them first)
+static QElapsedTimer traceTimer;
+static qint64 traceLast = 0;
+static QMutex traceMutex;
+
 // define the global debug object
 QP_Debug g_debug;
 
@@ -31,6 +40,7 @@ QP_Debug g_debug;
 QP_Debug::QP_Debug()
 {
    m_fDebug = NULL;
+   traceTimer.start();
 }
 
 // =====================================
@@ -79,6 +89,28 @@ int QP_Debug::write(const char *szFile, const char *szFunction, int nLine, const
    return 0;
 }
 
+// =====================================
+int QP_Debug::trace(const char *fmt, ...)
+{
+   va_list args;
+
+   if (!isOpen())
+      return -1;
+
+   QMutexLocker locker(&traceMutex);
+   qint64 now = traceTimer.elapsed();
+
+   va_start(args, fmt);
+   fprintf(m_fDebug, "[timeline] %7lld ms (+%5lld ms) ", (long long)now, (long long)(now - traceLast));
+   vfprintf(m_fDebug, fmt, args);
+   va_end(args);
+
+   fflush(m_fDebug);
+   traceLast = now;
+
+   return 0;
+}
+
 // =====================================
 int QP_Debug::open()
 {
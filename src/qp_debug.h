@@ -24,6 +24,7 @@ class QP_Debug;
 extern QP_Debug g_debug;
 
 #define showDebug(format, ...) g_debug.write(__FILE__, __FUNCTION__, __LINE__, format, ##__VA_ARGS__)
+#define showTrace(format, ...) g_debug.trace(format, ##__VA_ARGS__)
 
 class QP_Debug
 {
@@ -36,6 +37,7 @@ class QP_Debug
       int isOpen();
       int write(const char *fmt, ...);
       int write(const char *szFile, const char *szFunction, int nLine, const char *fmt, ...);
+      int trace(const char *fmt, ...);   // a step of the timeline: msecs since the start and since the last step
 
    private:
       FILE *m_fDebug = nullptr;
@@ -29,12 +29,22 @@
 #include <sys/stat.h>   // S_ISLNK
 #include <unistd.h>	 // readlink
 #include <dirent.h>
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QRunnable>
 #include "qp_devlist.h"
 #include "qp_common.h"
+#include "qp_probecache.h"
+#include "qp_debug.h"
 
 
 #define UPTIME_FILE "/proc/uptime"
 
+/*---guard the list of devices of libparted (see QP_DevList::pedListMutex)---*/
+static QMutex pedMutex;
+
 
 time_t uptime() {
     char buf[255];
@@ -54,7 +64,12 @@ time_t uptime() {
 }
 
 QP_Device::QP_Device(QP_Settings *set) {
-    settings = set;
+    _settings = set;
+    _isBusy = false;
+    _data = NULL;
+    _partitionTable = false;
+    _freshTable = false;
+    _probed = false;
 }
 
 QP_Device::~QP_Device() {
@@ -64,7 +79,10 @@ bool QP_Device::newPartTable() {
     PedDisk *disk;
     const PedDiskType *type;
     PedDiskType *def_type;
+
+    QP_DevList::pedListMutex()->lock();
     PedDevice *dev = ped_device_get(shortname().toLatin1().constData());
+    QP_DevList::pedListMutex()->unlock();
 
     if (!dev)
         goto error;
@@ -109,7 +127,7 @@ void QP_Device::setLongname(QString longname) {
     _shortname = QString(newstr);
 }
 
-QString QP_Device::shortname() const {
+QString QP_Device::shortname() {
     return _shortname;
 }
 
@@ -118,15 +136,17 @@ void QP_Device::setShortname(QString shortname) {
     _longname = QString();
 }
 
-bool QP_Device::isBusy() const {
+bool QP_Device::isBusy() {
+    probe();
     return _isBusy;
 }
 
 void QP_Device::setIsBusy(bool isbusy) {
     _isBusy = isbusy;
+    _probed = true;
 }
 
-void * QP_Device::data() const {
+void * QP_Device::data() {
     return _data;
 }
 
@@ -134,18 +154,28 @@ void QP_Device::setData(void * data) {
     _data = data;
 }
 
-bool QP_Device::partitionTable() const {
+bool QP_Device::partitionTable() {
+    probe();
     return _partitionTable;
 }
 
 void QP_Device::setPartitionTable(bool partitiontable) {
     _partitionTable = partitiontable;
+    _probed = true;
+}
+
+bool QP_Device::freshTable() {
+    return _freshTable;
 }
 
-bool QP_Device::canUpdateGeometry() const {
+void QP_Device::setFreshTable(bool fresh) {
+    _freshTable = fresh;
+}
+
+bool QP_Device::canUpdateGeometry() {
     /*geometry cannot be changed if last update was > boottime!!*/
 
-    time_t lastUpdate = settings->getDevUpdate(shortname());
+    time_t lastUpdate = _settings->getDevUpdate(shortname());
     time_t boottime = time((time_t)0) - uptime();
 
     if ((lastUpdate > boottime) && isBusy())
@@ -155,6 +185,9 @@ bool QP_Device::canUpdateGeometry() const {
 }
 
 void QP_Device::commit() {
+    /*---what was probed before the commit is not true anymore---*/
+    QP_ProbeCache::invalidate(shortname());
+
     /*---if the device is busy must be updated to "readonly"---*/
     if (isBusy()) {
         time_t now = time((time_t)0);
@@ -162,6 +195,35 @@ void QP_Device::commit() {
     }
 }
 
+void QP_Device::probe() {
+    QMutexLocker locker(&_probeMutex);
+
+    if (_probed)
+        return;
+    _probed = true;
+
+    /*---the first ped_device_get of a device add it to the list of libparted,
+     *   that is not thread safe: the devices are probed in parallel---*/
+    QP_DevList::pedListMutex()->lock();
+    PedDevice *dev = ped_device_get(shortname().toLatin1().constData());
+    QP_DevList::pedListMutex()->unlock();
+    if (!dev)
+        return;
+
+    PedDiskType *disktype = ped_disk_probe(dev);
+    if (disktype)
+        _partitionTable = true;
+    else
+        _partitionTable = false;
+
+    /*---get if the device is busy---*/
+    _isBusy = ped_device_is_busy(dev);
+}
+
+QP_Settings *QP_Device::settings() {
+    return _settings;
+}
+
 /*---this function convert a longname device to a shortname device
  *   the code was bring from partimage software made by François Dupoux---*/
 int QP_Device::convertDevfsNameToShortName(const char *szDevfs, char *szShort, int nMaxShort) {
@@ -219,44 +281,182 @@ int QP_Device::convertDevfsNameToShortName(const char *szDevfs, char *szShort, i
     return 0;
 }
 
+/*---probe a device in a thread of QP_DevList::_pool, then tell the receiver---*/
+class QP_DeviceProbeJob : public QRunnable {
+public:
+    QP_DeviceProbeJob(QP_Device *device, QObject *receiver, const char *member)
+        : _device(device), _receiver(receiver), _member(member) {}
+
+    void run() override {
+        _device->probe();
+        showTrace("devlist::probe, %s\n", _device->shortname().toLatin1().data());
+
+        if (_receiver)
+            QMetaObject::invokeMethod(_receiver, _member, Qt::QueuedConnection,
+                                      Q_ARG(QP_Device *, _device));
+    }
+
+private:
+    QP_Device *_device;
+    QPointer<QObject> _receiver;
+    const char *_member;
+};
+
 QP_DevList::QP_DevList(QP_Settings *settings) {
     _settings = settings;
 }
 
 QP_DevList::~QP_DevList() {
+    _pool.waitForDone();
     qDeleteAll(devlist);
     devlist.clear();
+    qDeleteAll(_removed);
 }
 
-void QP_DevList::getDevices() {
-    /*---get all the device (ie /dev/sda, /dev/hda /etc /etc)---*/
-    PedDevice *dev = NULL;
-    ped_device_probe_all();
-
-    while ((dev = ped_device_get_next(dev))) {
-        // Workaround for parted detecting CD-ROMs as harddisks
-        // FIXME remove if/when parted gets fixed
-        QString p(dev->path);
-        if(!p.startsWith("/dev/sd") && (p.contains("/dev/scd") || p.contains("/dev/sr") || access(("/proc/ide/" + p.section('/', 2, 2) + "/cache").toLatin1(), R_OK)))
+QMutex *QP_DevList::pedListMutex() {
+    return &pedMutex;
+}
+
+QP_Device *QP_DevList::find(QString path) {
+    for (QP_Device *device : devlist)
+        if (device->shortname() == path)
+            return device;
+    return NULL;
+}
+
+QP_Device *QP_DevList::add(QString path) {
+    /*---a disk back on the same path: libparted still keep the old one
+     *   (with the old size)---*/
+    pedListMutex()->lock();
+    for (PedDevice *dev = ped_device_get_next(NULL); dev; dev = ped_device_get_next(dev)) {
+        if (path == dev->path) {
+            ped_device_destroy(dev);
+            break;
+        }
+    }
+    pedListMutex()->unlock();
+
+    QP_Device *device = new QP_Device(_settings);
+    device->setShortname(path);
+    devlist.append(device);
+
+    return device;
+}
+
+void QP_DevList::remove(QP_Device *device) {
+    /*---a probe can still be running: it is deleted with the list---*/
+    devlist.removeAll(device);
+    _removed.append(device);
+}
+
+/*---the disks the kernel know, from sysfs: only reading a few small files,
+ *   without opening any device. Empty if sysfs is not there---*/
+QStringList QP_DevList::discover() {
+    QStringList paths;
+    QDir sysblock(SYSBLOCK_DIR);
+
+    if (!sysblock.exists())
+        return paths;
+
+    QStringList skip = QStringList() << "ram" << "zram" << "fd" << "sr" << "scd";
+
+    for (const QString &name : sysblock.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name)) {
+        QString sys = sysblock.filePath(name);
+        bool skipped = false;
+
+        for (const QString &prefix : skip)
+            if (name.startsWith(prefix))
+                skipped = true;
+        if (skipped)
             continue;
 
-        QP_Device *device = new QP_Device(_settings);
+        /*---an unused loop device, a card reader or a cdrom without media---*/
+        if (readSysfs(sys + "/size").toLongLong() == 0)
+            continue;
 
-        /*---with devfs libparted return longname, otherwise the shortname---*/
-        if (ped_device_is_devfs(dev))
-            device->setLongname(dev->path);
-        else
-            device->setShortname(dev->path);
+        /*---cdrom: scsi type 5, or ide media "cdrom"---*/
+        if (readSysfs(sys + "/device/type") == "5")
+            continue;
+        QString media = readSysfs("/proc/ide/" + name + "/media");
+        if (!media.isEmpty() && (media != "disk"))
+            continue;
 
-        PedDiskType *disktype = ped_disk_probe(dev);
-        if (disktype)
-            device->setPartitionTable(true);
+        /*---device mapper: libparted use the /dev/mapper name---*/
+        QString path;
+        QString dmname = readSysfs(sys + "/dm/name");
+        if (!dmname.isEmpty())
+            path = "/dev/mapper/" + dmname;
         else
-            device->setPartitionTable(false);
+            path = "/dev/" + QString(name).replace('!', '/');
+
+        if (access(path.toLatin1().constData(), F_OK) == 0)
+            paths.append(path);
+    }
+
+    return paths;
+}
+
+QString QP_DevList::readSysfs(QString file) {
+    QFile f(file);
+
+    if (!f.open(QIODevice::ReadOnly))
+        return QString();
+    return QString(f.readAll()).trimmed();
+}
 
-        /*---get if the device is busy---*/
-        device->setIsBusy(ped_device_is_busy(dev));
+void QP_DevList::getDevices(bool fast) {
+    /*---get all the device (ie /dev/sda, /dev/hda /etc /etc)---*/
+    QStringList paths = discover();
+    showTrace("devlist::getDevices, %d devices in sysfs\n", paths.count());
 
+    for (const QString &path : paths) {
+        QP_Device *device = new QP_Device(_settings);
+        device->setShortname(path);
         devlist.append(device);
     }
+
+    /*---no sysfs: ask libparted (it open every device)---*/
+    if (paths.isEmpty()) {
+        PedDevice *dev = NULL;
+        QMutexLocker locker(pedListMutex());
+        ped_device_probe_all();
+        showTrace("devlist::getDevices, ped_device_probe_all\n");
+
+        while ((dev = ped_device_get_next(dev))) {
+            // Workaround for parted detecting CD-ROMs as harddisks
+            // FIXME remove if/when parted gets fixed
+            QString p(dev->path);
+            if(!p.startsWith("/dev/sd") && (p.contains("/dev/scd") || p.contains("/dev/sr") || access(("/proc/ide/" + p.section('/', 2, 2) + "/cache").toLatin1(), R_OK)))
+                continue;
+
+            QP_Device *device = new QP_Device(_settings);
+
+            /*---with devfs libparted return longname, otherwise the shortname---*/
+            if (ped_device_is_devfs(dev))
+                device->setLongname(dev->path);
+            else
+                device->setShortname(dev->path);
+
+            devlist.append(device);
+        }
+    }
+
+    /*---reading the partition table can wait (see QP_StartupScan)---*/
+    if (!fast) {
+        probeDevices();
+        _pool.waitForDone();
+    }
+    showTrace("devlist::getDevices, %d devices%s\n", devlist.count(), fast ? ", not probed" : "");
+}
+
+void QP_DevList::probeDevices(QObject *receiver, const char *member) {
+    for (QP_Device *device : devlist)
+        probeDevice(device, receiver, member);
+}
+
+void QP_DevList::probeDevice(QP_Device *device, QObject *receiver, const char *member) {
+    qRegisterMetaType<QP_Device *>("QP_Device*");
+    _pool.setMaxThreadCount(_settings->scanJobs());
+
+    _pool.start(new QP_DeviceProbeJob(device, receiver, member));
 }
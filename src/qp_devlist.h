@@ -22,6 +22,17 @@
 /* About QP_DevList class:
  *
  * This class keep a list with all devices (ie all hard disk) detected by libparted
+ *
+ * The devices are listed from sysfs (/sys/block), without opening them. If
+ * they have a partition table and if they are busy is read by "probe", that
+ * open the device: "probeDevices" run it for all the devices in a pool of
+ * threads and tell a receiver every time a device is ready.
+ *
+ * With "fast" getDevices only list the devices: the probe is done the first
+ * time somebody ask it (or by "probeDevices").
+ *
+ * A disk plugged in or out later (see QP_HotPlug) is added or removed alone
+ * with "add" and "remove": the others are not probed again.
  */
 
 #ifndef QP_DEVLIST_H
@@ -29,9 +40,16 @@
 
 #include <time.h>
 #include <QList>
+#include <QMetaType>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
 #include <QString>
 #include "qp_settings.h"
 
+#define SYSBLOCK_DIR "/sys/block"
+
 class QP_Device {
 public:
     QP_Device(QP_Settings *);
@@ -47,8 +65,12 @@ public:
     void setData(void *);         //set data stuff ;)
     bool partitionTable();        //return if has a partition table
     void setPartitionTable(bool); //set if it has a partition table
+    bool freshTable();            //return if the new partition table is not written yet
+    void setFreshTable(bool);     //start from an empty table, written by the commit
     bool canUpdateGeometry();     //return if the geometry of the device can be changed
+    void probe();                 //probe partition table and busy state, once
     void commit();                //the device was commited!
+    QP_Settings *settings();      //return the user settings
 
 private:
     int convertDevfsNameToShortName(const char *, char *, int);
@@ -57,18 +79,33 @@ private:
     bool _isBusy;
     void *_data;
     bool _partitionTable;
-    QP_Settings *settings;
+    bool _freshTable;
+    bool _probed;
+    QMutex _probeMutex;           //the startup scan probe in its own thread
+    QP_Settings *_settings;
 };
 
 class QP_DevList {
 public:
     QP_DevList(QP_Settings *);
     ~QP_DevList();
-    void getDevices();          //probe all devices
+    void getDevices(bool fast = false); //probe all devices (with fast only list them)
+    void probeDevices(QObject *receiver = NULL, const char *member = NULL); //probe them in parallel, call member(QP_Device *) of receiver for each
+    void probeDevice(QP_Device *, QObject *receiver = NULL, const char *member = NULL); //the same for one device
+    QP_Device *find(QString);           //the device with this shortname, if any
+    QP_Device *add(QString);            //a device plugged in (not probed)
+    void remove(QP_Device *);           //a device unplugged
+    static QStringList discover();      //the disk devices found in sysfs
+    static QMutex *pedListMutex();      //hold it for every ped_device_get/destroy (not thread safe)
     QList<QP_Device*> devlist;
 
 private:
+    static QString readSysfs(QString);
     QP_Settings *_settings;
+    QThreadPool _pool;          //the threads of probeDevices
+    QList<QP_Device*> _removed; //unplugged, deleted with the list
 };
 
+Q_DECLARE_METATYPE(QP_Device *)
+
 #endif
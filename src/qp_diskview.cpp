@@ -20,6 +20,8 @@
 */
 
 #include "qp_diskview.h"
+#include "qp_commitscheduler.h"
+#include "qp_debug.h"
 
 QP_DiskView::QP_DiskView(QWidget *parent, Qt::WindowFlags f)
     : QWidget(parent, f), _layout(this)
@@ -36,6 +38,17 @@ QP_DiskView::QP_DiskView(QWidget *parent, Qt::WindowFlags f)
     connect(listchart, &QP_ListChart::sigDevicePopup, this, &QP_DiskView::sigDevicePopup);
     _layout.addWidget(listchart);
 
+    /*---the partition map replace the listchart when there are many partitions---*/
+    partmap = new QP_PartMap(this);
+    connect(partmap, &QP_PartMap::sigSelectPart, this, &QP_DiskView::slotListChartSelectPart);
+    connect(partmap, &QP_PartMap::sigPopup, this, &QP_DiskView::sigPopup);
+    connect(partmap, &QP_PartMap::sigDevicePopup, this, &QP_DiskView::sigDevicePopup);
+    _layout.addWidget(partmap);
+    partmap->hide();
+
+    _chart = listchart;
+    _layoutType = 0;
+
     /*---create the listview, attach it and connect the signals---*/
     listview = new QP_ListView(this);
     connect(listview, &QP_ListView::sigSelectPart, this, &QP_DiskView::slotListViewSelectPart);
@@ -83,6 +96,7 @@ void QP_DiskView::setDevice(QP_Device* dev)
     /*---change the device in the chart and list---*/
     listview->setDevice(dev);
     listchart->setDevice(dev);
+    partmap->setDevice(dev);
 
     /*---selecte the _device string---*/
     _qpdevice = dev;
@@ -92,6 +106,7 @@ void QP_DiskView::setDevice(QP_Device* dev)
 
     /*---fully redraw of the partitions (using QP_PartList widgets)---*/
     update_partlist();
+    showTrace("diskview::setDevice, %s\n", dev->shortname().toLatin1().data());
 }
 
 void QP_DiskView::update_partlist()
@@ -119,20 +134,26 @@ void QP_DiskView::refresh()
 
 void QP_DiskView::setLayout(int layout)
 {
+    _layoutType = layout;
+
+    /*---only one of the two charts is shown---*/
+    QP_PartList* hidden = (_chart == listchart) ? (QP_PartList*)partmap : (QP_PartList*)listchart;
+    hidden->hide();
+
     if (layout == 0)
     {
         listview->show();
-        listchart->show();
+        _chart->show();
     }
     else if (layout == 1)
     {
         listview->hide();
-        listchart->show();
+        _chart->show();
     }
     else if (layout == 2)
     {
         listview->show();
-        listchart->hide();
+        _chart->hide();
     }
 }
 
@@ -141,6 +162,11 @@ bool QP_DiskView::canUndo()
     return libparted->canUndo();
 }
 
+bool QP_DiskView::canRedo()
+{
+    return libparted->canRedo();
+}
+
 void QP_DiskView::undo()
 {
     /*---undo last operation---*/
@@ -150,17 +176,46 @@ void QP_DiskView::undo()
     refresh();
 }
 
+void QP_DiskView::redo()
+{
+    /*---redo last undone operation---*/
+    libparted->redo();
+
+    /*---refresh the listview+listchart---*/
+    refresh();
+}
+
 void QP_DiskView::commit()
 {
-    /*---commit all operations---*/
-    libparted->commit();
+    /*---commit all operations in a thread: the GUI keep being drawn---*/
+    QP_CommitScheduler scheduler(1, false);
+    scheduler.add(libparted, _qpdevice->shortname());
+
+    /*---the partitions are changing under the widgets---*/
+    setEnabled(false);
+    scheduler.run();
+    setEnabled(true);
 
     /*---refresh the listview+listchart---*/
     refresh();
 }
 
+void QP_DiskView::cancel()
+{
+    libparted->cancel();
+}
+
 void QP_DiskView::refresh_widgets()
 {
+    /*---a QP_PartWidget for every partition is too much for big GPT disks---*/
+    int count = libparted->partlist.count() + libparted->logilist.count();
+    QP_PartList* chart = (count > PARTMAP_PARTITIONS) ? (QP_PartList*)partmap : (QP_PartList*)listchart;
+    if (chart != _chart)
+    {
+        _chart = chart;
+        setLayout(_layoutType);
+    }
+
     /*---loop for adding primary/extended partitions---*/
     for (QP_PartInfo* p : libparted->partlist)
     {
@@ -183,41 +238,42 @@ void QP_DiskView::refresh_widgets()
 void QP_DiskView::clear()
 {
     listview->clear();
-    listchart->clear();
+    _chart->clear();
 }
 
 void QP_DiskView::addPrimary(QP_PartInfo* partinfo)
 {
     listview->addPrimary(partinfo);
-    listchart->addPrimary(partinfo);
+    _chart->addPrimary(partinfo);
 }
 
 void QP_DiskView::addLogical(QP_PartInfo* partinfo)
 {
     listview->addLogical(partinfo);
-    listchart->addLogical(partinfo);
+    _chart->addLogical(partinfo);
 }
 
 void QP_DiskView::set_mb_hdsize(float mb_hdsize)
 {
     listview->set_mb_hdsize(mb_hdsize);
     listchart->set_mb_hdsize(mb_hdsize);
+    partmap->set_mb_hdsize(mb_hdsize);
 }
 
 void QP_DiskView::draw()
 {
     listview->draw();
-    listchart->draw();
+    _chart->draw();
 }
 
 void QP_DiskView::slotListChartSelectPart(QP_PartInfo* partinfo)
 {
     // Syncronize selection of listview and listchart
-    listchart->blockSignals(true);
+    _chart->blockSignals(true);
     listview->blockSignals(true);
-    listchart->setselPartInfo(partinfo);
+    _chart->setselPartInfo(partinfo);
     listview->setselPartInfo(partinfo);
-    listchart->blockSignals(false);
+    _chart->blockSignals(false);
     listview->blockSignals(false);
 
     // Emit the selected signals
@@ -227,12 +283,12 @@ void QP_DiskView::slotListChartSelectPart(QP_PartInfo* partinfo)
 void QP_DiskView::slotListViewSelectPart(QP_PartInfo* partinfo)
 {
     // Syncronize selection of listview and listchart
-    listchart->blockSignals(true);
+    _chart->blockSignals(true);
     listview->blockSignals(true);
     listview->setselPartInfo(partinfo);
-    listchart->setselPartInfo(partinfo);
+    _chart->setselPartInfo(partinfo);
     listview->blockSignals(false);
-    listchart->blockSignals(false);
+    _chart->blockSignals(false);
 
     // Emit the selected signals
     emit sigSelectPart(partinfo);
@@ -34,6 +34,7 @@
 #include "qp_partlist.h"
 #include "qp_listview.h"
 #include "qp_listchart.h"
+#include "qp_partmap.h"
 #include "qp_devlist.h"
 
 class QP_DiskView : public QWidget {
@@ -48,15 +49,21 @@ public:
     void refresh();                                /*---destroy libparted and call refresh_widgets---*/
     void setLayout(int);                           /*---set the layout of the widget               ---*/
     bool canUndo();                                /*---the state of the disk is changed?           ---*/
+    bool canRedo();                                /*---there is an undone operation?              ---*/
     void undo();                                   /*---undo last operation                        ---*/
+    void redo();                                   /*---redo last undone operation                 ---*/
     void commit();                                 /*---commit all operations                      ---*/
+    void cancel();                                 /*---stop the commit in progress                ---*/
     QP_LibParted *libparted;                       /*---libparted is the wrapper to parted          ---*/
     QP_ListChart *listchart;                       /*---chart implementation of QP_PartList        ---*/
+    QP_PartMap *partmap;                           /*---chart for disks with many partitions       ---*/
     QP_ListView *listview;                         /*---list implementation of QP_PartList         ---*/
     QP_FileSystem *filesystem;                     /*---a class with all feature of filesystems     ---*/
 
 private:
     QP_Device *_qpdevice;                          /*---this is the device (example: /dev/hda)      ---*/
+    QP_PartList *_chart;                           /*---listchart or partmap, the one shown         ---*/
+    int _layoutType;                               /*---the last layout set (see setLayout)         ---*/
     void refresh_widgets();                        /*---recalculate and redraw QP_PartList         ---*/
     void clear();                                  /*---clear partitions                           ---*/
     void addPrimary(QP_PartInfo *);                /*---add a Primary or Extended partition        ---*/
@@ -73,7 +80,7 @@ signals:
     void sigDiskChanged();                         /*---emitted to state of the disk changed       ---*/
 
 protected slots:
-    void slotListChartSelectPart(QP_PartInfo *);   /*---connected to receive signal from ListChart ---*/
+    void slotListChartSelectPart(QP_PartInfo *);   /*---connected to receive signal from the chart ---*/
     void slotListViewSelectPart(QP_PartInfo *);    /*---connected to receive signal from ListView  ---*/
 
 protected:
@@ -59,7 +59,7 @@ QP_dlgConfig::QP_dlgConfig(QWidget *p):QDialog(p),_layout(this) {
         QTableWidgetItem *w = new QTableWidgetItem(it.value()->name());
         w->setFlags(0); // Get rid of Qt::ItemIsEditable
         _extTools->setItem(row, 0, w);
-        _extTools->setItem(row, 1, new QTableWidgetItem(it.value()->path()));
+        _extTools->setItem(row, 1, new QTableWidgetItem(lstExternalTools->getPath(it.key())));
         w = new QTableWidgetItem(it.value()->description());
         w->setFlags(Qt::NoItemFlags); // Get rid of Qt::ItemIsEditable
         _extTools->setItem(row, 2, w);
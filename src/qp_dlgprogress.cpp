@@ -26,6 +26,7 @@
 #include <QCloseEvent>
 
 #include "qp_dlgprogress.h"
+#include "qp_libparted.h"
 
 QP_dlgProgress::QP_dlgProgress(QWidget *parent):QDialog(parent),Ui::QP_UIProgress() {
     setupUi(this);
@@ -33,6 +34,11 @@ QP_dlgProgress::QP_dlgProgress(QWidget *parent):QDialog(parent),Ui::QP_UIProgres
     QPalette pal=lblMessage->palette();
     pal.setColor(QPalette::WindowText, Qt::red); // Error messages in red
     lblMessage->setPalette(pal);
+
+    /*---the commit run in a thread: the rest of the GUI wait for it---*/
+    setModal(true);
+
+    connect(btnCancel, &QPushButton::clicked, this, &QP_dlgProgress::slotCancel);
 }
 
 QP_dlgProgress::~QP_dlgProgress() {
@@ -40,6 +46,7 @@ QP_dlgProgress::~QP_dlgProgress() {
 
 void QP_dlgProgress::init_dialog() {
     btnOk->setEnabled(false);
+    btnCancel->setEnabled(false);
     progressBar->setValue(0);
     lblState->setText(tr("Initializing"));
     lblMessage->setText(QString::null);
@@ -50,6 +57,10 @@ int QP_dlgProgress::show_dialog() {
     return exec();
 }
 
+void QP_dlgProgress::setCancelable(bool cancelable) {
+    btnCancel->setEnabled(cancelable);
+}
+
 void QP_dlgProgress::closeEvent (QCloseEvent *ce) {
     if (btnOk->isEnabled())
         ce->accept();
@@ -65,7 +76,27 @@ void QP_dlgProgress::slotTimer(int percent, QString state, QString timeleft) {
     progressBar->setValue(percent);
     lblState->setText(state);
     lblTimeLeft->setText(tleft);
-    qApp->processEvents();
+}
+
+void QP_dlgProgress::slotProgress(const QP_ProgressInfo &info) {
+    QString tleft = QString(tr("Time Left: %1"))
+                    .arg(info.timeleft);
+
+    /*---a move, copy or resize: how much of it and how fast---*/
+    if (info.bytesTotal > 0)
+        tleft += QString(tr(" - %1 of %2 at %3/s"))
+                    .arg(MB2String(info.bytesDone * 1.0 / MEGABYTE))
+                    .arg(MB2String(info.bytesTotal * 1.0 / MEGABYTE))
+                    .arg(MB2String(info.rate / MEGABYTE));
+
+    progressBar->setValue(info.percent);
+    lblState->setText(info.state);
+    lblTimeLeft->setText(tleft);
+
+    /*---the scans of setDevice and refresh still run on the GUI thread, that
+     *   doesn't go back to the event loop until they are over: paint now
+     *   (QP_Progress call this at most every PROGRESS_FRAME msecs)---*/
+    repaint();
 }
 
 void QP_dlgProgress::slotOperations(QString operation, QString message, int count, int total) {
@@ -83,5 +114,12 @@ void QP_dlgProgress::slotOperations(QString operation, QString message, int coun
             lblMessage->setText(tr("Operations completed sucessfully."));
         }
         btnOk->setEnabled(true);
+        btnCancel->setEnabled(false);
     }
 }
+
+void QP_dlgProgress::slotCancel() {
+    btnCancel->setEnabled(false);
+    lblState->setText(tr("Canceling"));
+    emit sigCancel();
+}
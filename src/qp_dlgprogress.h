@@ -25,6 +25,8 @@
  * the layout of this dialog just use QT designer!
  *
  * This dialog is used when user request a "long time" operation.
+ * During a commit the "Cancel" button emit sigCancel: the operation in
+ * progress (if it is a copy) and the ones left are not done.
  */
 
 #ifndef QP_DLGPROGRESS_H
@@ -32,6 +34,7 @@
 
 #include <QDialog>
 #include "ui_qp_ui_progress.h"
+#include "qp_progress.h"
 #include <QtGui/QCloseEvent>
 
 class QP_dlgProgress : public QDialog, public Ui::QP_UIProgress
@@ -43,13 +46,21 @@ public:
 	~QP_dlgProgress();
 	void init_dialog();
 	int show_dialog();
+	void setCancelable(bool);	/*---enable the "Cancel" button---*/
 
 protected:
 	void closeEvent (QCloseEvent *);
 
 public slots:
 	void slotTimer(int, QString, QString);
+	void slotProgress(const QP_ProgressInfo &);	/*---like slotTimer, with the bytes---*/
 	void slotOperations(QString, QString, int, int);
+
+protected slots:
+	void slotCancel();
+
+signals:
+	void sigCancel();
 };
 
 #endif
@@ -28,6 +28,7 @@
 #include "qp_devlist.h"
 #include "qp_libparted.h"
 #include "qp_common.h"
+#include "qp_debug.h"
 
 QP_DriveList::QP_DriveList(QWidget *parent, QP_Settings *settings)
     : QTreeWidget(parent)
@@ -39,6 +40,10 @@ QP_DriveList::QP_DriveList(QWidget *parent, QP_Settings *settings)
 
     /*---init the selected device---*/
     _selDevice = nullptr;
+    _startupScan = nullptr;
+    _root = nullptr;
+    _pending = 0;
+    _hotplug = nullptr;
 
     devlist = new QP_DevList(settings);
 
@@ -50,6 +55,7 @@ QP_DriveList::QP_DriveList(QWidget *parent, QP_Settings *settings)
 
 QP_DriveList::~QP_DriveList()
 {
+    delete _startupScan;
 }
 
 void QP_DriveList::setPopup(QMenu *popup)
@@ -57,51 +63,168 @@ void QP_DriveList::setPopup(QMenu *popup)
     _popup = popup;
 }
 
-void QP_DriveList::buildView()
+void QP_DriveList::buildView(bool fast)
 {
     /*---make the "root" of the listview---*/
-    QTreeWidgetItem* ideRoot = new QTreeWidgetItem(this);
-    ideRoot->setText(0, tr("Disks"));
+    _root = new QTreeWidgetItem(this);
+    _root->setText(0, tr("Disks"));
+    _root->setExpanded(true);
 
-    /*---get a list of all available devices---*/
-    devlist->getDevices();
+    /*---make the group menu---*/
+    _agDevices = new QActionGroup(this);
+    _agDevices->setExclusive(true);
+    connect(_agDevices, &QActionGroup::selected, this, &QP_DriveList::slotActionSelected);
+
+    /*---get a list of all available devices (from sysfs, without opening them)---*/
+    devlist->getDevices(true);
+
+    /*---from now on a disk plugged in or out is added or removed alone---*/
+    QStringList known;
+    for (QP_Device *dev : devlist->devlist)
+        known.append(dev->shortname());
+
+    _hotplug = new QP_HotPlug(this);
+    connect(_hotplug, &QP_HotPlug::sigAdded, this, &QP_DriveList::slotDeviceAdded);
+    connect(_hotplug, &QP_HotPlug::sigRemoved, this, &QP_DriveList::slotDeviceRemoved);
+    _hotplug->start(known);
 
     //QStrList lstdrives = QP_LibParted::device_probe();
     if (devlist->devlist.count() == 0)
     {
+        delete _root;
+        _root = nullptr;
+
         QMessageBox::information(this, "QParted",
             QString(tr("No device found. Maybe you're not using root user?")));
+        return;
     }
 
-    /*---make the group menu---*/
-    _agDevices = new QActionGroup(this);
-    _agDevices->setExclusive(true);
-    connect(_agDevices, &QActionGroup::selected, this, &QP_DriveList::slotActionSelected);
+    /*---made now so a device selected before the scan start is claimed---*/
+    if (fast)
+        _startupScan = new QP_StartupScan(devlist->devlist);
+
+    /*---read the partition tables in parallel: every device is shown as soon as
+     *   it is probed (see slotDeviceProbed)---*/
+    _pending = devlist->devlist.count();
+    devlist->probeDevices(this, "slotDeviceProbed");
+}
 
-    /*---add every device found---*/
-    for (QP_Device* p : devlist->devlist)
+void QP_DriveList::slotDeviceProbed(QP_Device *p)
+{
+    _pending--;
+
+    /*---unplugged while it was probed---*/
+    if (!devlist->devlist.contains(p))
+        return;
+
+    /*---get the device name---*/
+    QString st = p->shortname();
+
+    /*---add to the listview, in the order of devlist---*/
+    int index = 0;
+    for (QP_Device *dev : devlist->devlist)
+    {
+        if (dev == p)
+            break;
+        if (dev->data())
+            index++;
+    }
+
+    /*---the first disk plugged in after "No device found"---*/
+    if (!_root)
     {
-        /*---get the device name---*/
-        QString st = p->shortname();
+        _root = new QTreeWidgetItem(this);
+        _root->setText(0, tr("Disks"));
+        _root->setExpanded(true);
+    }
+
+    QTreeWidgetItem *item = new QTreeWidgetItem();
+    item->setText(0, st);
+    _root->insertChild(index, item);
+
+    /*---add to the group menu---*/
+    QAction *actDisk = new QAction(st, _agDevices);
+    actDisk->setCheckable(true);
+
+    QP_DeviceNode *devicenode = new QP_DeviceNode();
+    devicenode->action = actDisk;
+    devicenode->listitem = item;
 
-        /*---add to the listview---*/
-        QTreeWidgetItem *item = addDevice(st, ideRoot);
+    p->setData(reinterpret_cast<void *>(devicenode));
 
-        /*---add to the group menu---*/
-        QAction *actDisk = new QAction(st, _agDevices);
-        actDisk->setCheckable(true);
+    emit devicesChanged();
 
-        QP_DeviceNode *devicenode = new QP_DeviceNode();
-        devicenode->action = actDisk;
-        devicenode->listitem = item;
+    if (_pending)
+        return;
+
+    showTrace("drivelist::slotDeviceProbed, %d devices shown\n", devlist->devlist.count());
+
+    /*---the partitions are scanned while the user look at the window (only the
+     *   devices found at startup)---*/
+    if (_startupScan && !_startupScan->isRunning() && !_startupScan->isFinished())
+        _startupScan->start(QThread::LowPriority);
+}
 
-        p->setData(reinterpret_cast<void *>(devicenode));
+void QP_DriveList::slotDeviceAdded(QString path)
+{
+    /*---plugged back while it was still selected: it is not removed any more---*/
+    _unplugged.removeAll(path);
+
+    /*---a device known is never probed again---*/
+    if (devlist->find(path))
+        return;
+
+    QP_Device *device = devlist->add(path);
+    _pending++;
+    devlist->probeDevice(device, this, "slotDeviceProbed");
+}
+
+void QP_DriveList::slotDeviceRemoved(QString path)
+{
+    QP_Device *device = devlist->find(path);
+    if (!device)
+        return;
+
+    /*---the device shown in the diskview stay: its operations can still
+     *   be undone, and a commit will tell what is wrong. QP_HotPlug has
+     *   already forgot it, so it is removed when another one is selected---*/
+    if (device == _selDevice)
+    {
+        showDebug("drivelist::slotDeviceRemoved, %s is selected: kept\n", path.toLatin1().data());
+        if (!_unplugged.contains(path))
+            _unplugged.append(path);
+        return;
     }
 
-    if (ideRoot->childCount())
-        ideRoot->setExpanded(true);
-    else
-        delete ideRoot;
+    /*---the startup scan must not be reading it---*/
+    if (_startupScan)
+        _startupScan->claim(device);
+
+    QP_DeviceNode *p = static_cast<QP_DeviceNode *>(device->data());
+    if (p)
+    {
+        delete p->listitem;
+        delete p->action;
+        delete p;
+        device->setData(nullptr);
+    }
+
+    devlist->remove(device);
+    emit devicesChanged();
+}
+
+QList<QAction *> QP_DriveList::deviceActions()
+{
+    QList<QAction *> actions;
+
+    for (QP_Device *dev : devlist->devlist)
+    {
+        QP_DeviceNode *p = static_cast<QP_DeviceNode *>(dev->data());
+        if (p)
+            actions.append(p->action);
+    }
+
+    return actions;
 }
 
 QTreeWidgetItem* QP_DriveList::addDevice(QString dev, QTreeWidgetItem* parent)
@@ -126,7 +249,7 @@ void QP_DriveList::slotDisksSelected()
 {
     QTreeWidgetItem* item = currentItem();
     /*---if the item selected is not the root---*/
-    if (!item->childCount())
+    if (item && (item != _root))
     {
         /*---get the device name (ex. /dev/hda)---*/
         QString name = item->text(0);
@@ -134,8 +257,10 @@ void QP_DriveList::slotDisksSelected()
         /*---scan for every menu in the group---*/
         for (QP_Device* dev : devlist->devlist)
         {
-            /*---get the device node from devlist---*/
+            /*---get the device node from devlist (none if not probed yet)---*/
             QP_DeviceNode* p = static_cast<QP_DeviceNode*>(dev->data());
+            if (!p)
+                continue;
 
             /*---the name match, so select it!---*/
             if (p->action->text().compare(name) == 0)
@@ -146,7 +271,28 @@ void QP_DriveList::slotDisksSelected()
                 _selDevice = dev;
             }
         }
+
+        /*---the GUI scan it now: the startup scan must leave it alone---*/
+        if (_startupScan && _selDevice)
+            _startupScan->claim(_selDevice);
+
         emit deviceSelected(_selDevice);
+
+        removeUnplugged();
+    }
+}
+
+/*---the devices unplugged while they were selected, now that they are not---*/
+void QP_DriveList::removeUnplugged()
+{
+    for (const QString &path : QStringList(_unplugged))
+    {
+        QP_Device *device = devlist->find(path);
+        if (device == _selDevice)
+            continue;
+
+        _unplugged.removeAll(path);
+        slotDeviceRemoved(path);
     }
 }
 
@@ -158,8 +304,10 @@ void QP_DriveList::slotActionSelected(QAction* action)
     /*---scan for every menu in the group---*/
     for (QP_Device* dev : devlist->devlist)
     {
-        /*---get the device node from devlist---*/
+        /*---get the device node from devlist (none if not probed yet)---*/
         QP_DeviceNode* p = static_cast<QP_DeviceNode*>(dev->data());
+        if (!p)
+            continue;
 
         /*---the name match, so select it!---*/
         if (p->listitem->text(0).compare(name) == 0)
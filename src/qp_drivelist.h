@@ -32,7 +32,10 @@
 #include <QTreeWidget>
 #include <QList>
 #include <QMenu>
+#include <QStringList>
 #include "qp_devlist.h"
+#include "qp_startupscan.h"
+#include "qp_hotplug.h"
 
 class QP_DeviceNode {
 public:
@@ -47,25 +50,36 @@ public:
     QP_DriveList(QWidget *parent = nullptr, QP_Settings *settings = nullptr);
     ~QP_DriveList();
     void setPopup(QMenu *); /*---set the popup menu (right click)---*/
-    void buildView();
+    void buildView(bool fast = false); /*---fast: scan the devices in background---*/
     QTreeWidgetItem *addDevice(QString, QTreeWidgetItem *);
     QActionGroup *agDevices();
     QP_Device *selDevice(); /*---return the selected device---*/
+    QList<QAction *> deviceActions(); /*---the actions of the devices shown, in order---*/
 
 private:
     QActionGroup *_agDevices;
     QP_DevList *devlist;
     QMenu *_popup;
     QP_Device *_selDevice;
+    QP_StartupScan *_startupScan;
+    QTreeWidgetItem *_root;
+    int _pending;           /*---devices not probed yet---*/
+    QP_HotPlug *_hotplug;
+    QStringList _unplugged; /*---unplugged while selected: removed when deselected---*/
+    void removeUnplugged();
 
 signals:
     void deviceSelected(QP_Device *);
+    void devicesChanged();  /*---a device was added to or removed from the view---*/
     void onItem(QString);
 
 public slots:
     void slotDisksSelected();
     void slotActionSelected(QAction *);
     void slotPopUp();
+    void slotDeviceProbed(QP_Device *);
+    void slotDeviceAdded(QString);
+    void slotDeviceRemoved(QString);
 };
 
 #endif
\ No newline at end of file
@@ -22,8 +22,14 @@
 */
 
 #include <cstdio>
+#include <unistd.h>
+#include <QMutexLocker>
 
 #include "qp_exttools.h"
+#include "qp_process.h"
+#include "qp_debug.h"
+
+#define PROBE_TIMEOUT 3000      /*---msecs for a "--version" or a "--help"---*/
 
 QP_ListExternalTools::QP_ListExternalTools() : QHash<QString, QP_ExternalTool*>() {}
 
@@ -38,12 +44,17 @@ void QP_ListExternalTools::add(QString name, QString path, QString description)
 }
 
 QString QP_ListExternalTools::getPath(QString name) {
-    if (!contains(name))
+    QMutexLocker locker(&_mutex);
+    QP_ExternalTool *tool = resolve(name);
+
+    if (!tool)
         return QString();
-    return value(name)->path();
+    return tool->path();
 }
 
 void QP_ListExternalTools::setPath(QString name, QString path) {
+    QMutexLocker locker(&_mutex);
+
     if (!contains(name))
         return;
     value(name)->setPath(path);
@@ -54,3 +65,121 @@ QString QP_ListExternalTools::getDescription(QString name) {
         return QString();
     return value(name)->description();
 }
+
+bool QP_ListExternalTools::available(QString name) {
+    QMutexLocker locker(&_mutex);
+    QP_ExternalTool *tool = resolve(name);
+
+    return tool && tool->_available;
+}
+
+QString QP_ListExternalTools::version(QString name) {
+    QString version;
+    QByteArray help;
+
+    if (!probe(name, &version, &help))
+        return QString();
+    return version;
+}
+
+bool QP_ListExternalTools::supports(QString name, QString option) {
+    QString version;
+    QByteArray help;
+
+    return probe(name, &version, &help) && help.contains(option.toLatin1());
+}
+
+QString QP_ListExternalTools::find(QString name) {
+    QStringList s = QString(getenv("PATH")).split(':');
+    // Add locations where external applications are commonly found...
+    s << "/sbin" << "/usr/sbin" << "/usr/local/sbin" << "/opt/local/sbin" << "/bin" << "/usr/bin" << "/usr/local/bin" << "/opt/local/bin";
+    foreach(QString const p, s) {
+        QString const guess = p + "/" + name;
+        if (access(guess.toLocal8Bit().constData(), X_OK) == 0)
+            return guess;
+    }
+    return QString::null;
+}
+
+/*---the path of a tool is looked for only the first time. Called with
+ *   _mutex locked---*/
+QP_ExternalTool *QP_ListExternalTools::resolve(QString name) {
+    if (!contains(name))
+        return NULL;
+
+    QP_ExternalTool *tool = value(name);
+    if (tool->_resolved)
+        return tool;
+
+    if (tool->_path.isEmpty())
+        tool->_path = find(name);
+
+    tool->_available = !tool->_path.isEmpty()
+                     && (access(tool->_path.toLocal8Bit().constData(), X_OK) == 0);
+    tool->_resolved = true;
+
+    showDebug("exttools::resolve, %s: %s\n", name.toLatin1().data(),
+              tool->_available ? tool->_path.toLatin1().data() : "not found");
+    return tool;
+}
+
+/*---run "--version" and "--help" once. The tool is run with _mutex unlocked,
+ *   so a slow one don't stop who ask for another tool: if two threads ask
+ *   together both run it, and the first answer is kept. False if the tool
+ *   is not installed---*/
+bool QP_ListExternalTools::probe(QString name, QString *version, QByteArray *help) {
+    QString path;
+
+    {
+        QMutexLocker locker(&_mutex);
+        QP_ExternalTool *tool = resolve(name);
+
+        if (!tool || !tool->_available)
+            return false;
+
+        if (tool->_probed) {
+            *version = tool->_version;
+            *help = tool->_help;
+            return true;
+        }
+        path = tool->_path;
+    }
+
+    QP_Process process;
+    QByteArray line;
+    QString newVersion;
+    QByteArray newHelp;
+
+    process.setTimeout(PROBE_TIMEOUT);
+    if (process.start(QStringList() << path << "--version")) {
+        while (process.getLine(&line)) {
+            if (newVersion.isEmpty() && line.contains('.'))
+                newVersion = QString(line).trimmed();
+        }
+        process.wait();
+    }
+
+    /*---some tools print the usage on stderr: both streams are read---*/
+    if (process.start(QStringList() << path << "--help")) {
+        while (process.getLine(&line))
+            newHelp += line + "\n";
+        process.wait();
+    }
+
+    showDebug("exttools::probe, %s: version \"%s\", %d bytes of help\n",
+              name.toLatin1().data(), newVersion.toLatin1().data(), newHelp.size());
+
+    QMutexLocker locker(&_mutex);
+    QP_ExternalTool *tool = value(name);
+
+    /*---if setPath changed the tool meanwhile, this answer is of the old one---*/
+    if (!tool->_probed && tool->_path == path) {
+        tool->_version = newVersion;
+        tool->_help = newHelp;
+        tool->_probed = true;
+    }
+
+    *version = newVersion;
+    *help = newHelp;
+    return true;
+}
@@ -21,34 +21,51 @@
 
 /* About QP_ListExternalTools class
  *
- * This class keeps a list of all external tools needed by the libparted wrapper
+ * This class keeps a list of all external tools needed by the libparted wrapper.
+ *
+ * It is also the registry of what is installed: a tool without a path is
+ * looked for in the search path (with access, no process is started) the
+ * first time it is needed, and the answer is kept. The version and the
+ * --help of a tool are read only if somebody ask for them (see "version"
+ * and "supports"), once. All the wrappers, of every device, share it.
  */
 
 #ifndef QP_EXTTOOLS_H
 #define QP_EXTTOOLS_H
 
 #include <QHash>
+#include <QMutex>
 #include <QString>
+#include <QStringList>
 
 class QP_ExternalTool {
 public:
-    QP_ExternalTool() {}
+    QP_ExternalTool() {_resolved = false; _available = false; _probed = false;}
     QP_ExternalTool(QString name, QString path, QString description) {
         _name = name;
         _path = path;
         _description = description;
+        _resolved = false;
+        _available = false;
+        _probed = false;
     }
     QString path() {return _path;}
     QString description() {return _description;}
     QString name() {return _name;}
-    void setPath(QString path) {_path = path;}
+    void setPath(QString path) {_path = path; _resolved = false; _probed = false;}
     void setDescription(QString description) {_description = description;}
     void setName(QString name) {_name = name;}
 
 private:
+    friend class QP_ListExternalTools;
     QString _path;
     QString _description;
     QString _name;
+    bool _resolved;         /*---_path and _available are known---*/
+    bool _available;
+    bool _probed;           /*---_version and _help are read---*/
+    QString _version;
+    QByteArray _help;
 };
 
 class QP_ListExternalTools:public QHash<QString,QP_ExternalTool*> {
@@ -59,6 +76,16 @@ public:
     QString getPath(QString);
     void setPath(QString, QString);
     QString getDescription(QString);
+    bool available(QString);                /*---installed and executable?---*/
+    QString version(QString);               /*---first line of "--version"---*/
+    bool supports(QString, QString);        /*---the --help of the tool talk about an option?---*/
+    static QString find(QString);           /*---look for a program in the search path---*/
+
+private:
+    QP_ExternalTool *resolve(QString);
+    bool probe(QString, QString *, QByteArray *);
+    QMutex _mutex;                          /*---the wrappers of more devices ask together;
+                                             *   never held while a tool runs---*/
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -92,13 +92,13 @@ QP_FileSystemSpec::QP_FileSystemSpec(QString name, bool create,
 
     /*---default color is unknow---*/
     _color = qpfslist[MAXFS-1].color;
-    _pixmap = QPixmap(qpfslist[MAXFS-1].pixmap);
+    _xpm = qpfslist[MAXFS-1].pixmap;
 
     /*---look for a specific color for that filesystem---*/
     for (int i=0; i<MAXFS; i++)
         if (name.compare(qpfslist[i].fstype) == 0) {
             _color = qpfslist[i].color;
-            _pixmap = QPixmap(qpfslist[i].pixmap);
+            _xpm = qpfslist[i].pixmap;
             _minFsSize = qpfslist[i].minFsSize;
             _maxFsSize = qpfslist[i].maxFsSize;
         }
@@ -116,6 +116,10 @@ QColor QP_FileSystemSpec::color() {
 }
 
 QPixmap QP_FileSystemSpec::pixmap() {
+    /*---made the first time it is drawn: there is no pixmap without a GUI---*/
+    if (_pixmap.isNull())
+        _pixmap = QPixmap(_xpm);
+
     return _pixmap;
 }
 
@@ -63,6 +63,7 @@ private:
     QString _name;
     QColor _color;
     QPixmap _pixmap;
+    void *_xpm;
     bool _create;
     bool _resize;
     bool _move;
@@ -0,0 +1,807 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>	// BLKSSZGET
+#include <algorithm>
+#include <QByteArray>
+#include <QElapsedTimer>
+
+#include "qp_fsstats.h"
+#include "qp_fswrap.h"
+#include "qp_debug.h"
+
+#define STATS_BUFFER (1024 * 1024)	/*---$Bitmap is read 1MiB at time         ---*/
+#define FAT_BUFFER (8 * 1024 * 1024)	/*---a FAT32 table can be hundreds of MiB---*/
+
+/*---XFS is big endian: the NTFS_GETUxx macros are for little endian---*/
+#define XFS_GETU16(p) ((uint16_t)Be16ToCpu(*(uint16_t*)(p)))
+#define XFS_GETU32(p) ((uint32_t)Be32ToCpu(*(uint32_t*)(p)))
+#define XFS_GETU64(p) ((uint64_t)Be64ToCpu(*(uint64_t*)(p)))
+
+/*---append a range, merging it with the last one if they touch---*/
+static void add_extent(QVector<QP_Extent> *extents, long long offset, long long length) {
+	if (length <= 0)
+		return;
+
+	if (!extents->isEmpty()) {
+		QP_Extent &last = extents->last();
+		if ((offset >= last.offset) && (offset <= last.offset + last.length)) {
+			if (offset + length > last.offset + last.length)
+				last.length = offset + length - last.offset;
+			return;
+		}
+	}
+
+	QP_Extent extent = { offset, length };
+	extents->append(extent);
+}
+
+/*---append the runs of bits set in a bitmap (bit 0 of byte 0 first), every
+ *   bit is "unit" bytes starting from "base"---*/
+static void add_bits(QVector<QP_Extent> *extents, const uint8_t *bits, uint64_t count,
+		     long long base, long long unit) {
+	uint64_t i = 0;
+
+	while (i < count) {
+		/*---whole words free or used are the common case---*/
+		if ((i % 64 == 0) && (i + 64 <= count)) {
+			uint64_t word;
+			memcpy(&word, bits + i / 8, 8);
+			if (word == 0) {
+				i += 64;
+				continue;
+			}
+			if (word == ~0ULL) {
+				add_extent(extents, base + i * unit, 64 * unit);
+				i += 64;
+				continue;
+			}
+		}
+
+		if (bits[i / 8] & (1 << (i % 8)))
+			add_extent(extents, base + i * unit, unit);
+		i++;
+	}
+}
+
+QP_FSStats::QP_FSStats(QString device, PedSector start, PedSector end) {
+	int sectorSize = 512;
+
+	_offset = 0;
+	_length = 0;
+
+	_fd = open(device.toLatin1().constData(), O_RDONLY | O_CLOEXEC);
+	if (_fd < 0) {
+		showDebug("fsstats::fsstats, cannot open %s\n", device.toLatin1().data());
+		return;
+	}
+
+	/*---parted sectors are logical sectors of the disk---*/
+	if (ioctl(_fd, BLKSSZGET, &sectorSize) != 0)
+		sectorSize = 512;
+
+	_offset = (long long)start * sectorSize;
+	_length = (long long)(end - start + 1) * sectorSize;
+}
+
+QP_FSStats::~QP_FSStats() {
+	if (_fd >= 0)
+		close(_fd);
+}
+
+long long QP_FSStats::length() {
+	return _length;
+}
+
+bool QP_FSStats::read(long long offset, void *buffer, size_t length) {
+	if ((_fd < 0) || (offset < 0) || (offset + (long long)length > _length))
+		return false;
+
+	char *p = (char *)buffer;
+	while (length > 0) {
+		ssize_t n = pread(_fd, p, length, _offset + offset);
+		if (n <= 0)
+			return false;
+		p += n;
+		offset += n;
+		length -= n;
+	}
+
+	return true;
+}
+
+bool QP_FSStats::used(QString fsname, unsigned long long *bytes) {
+	bool rc = false;
+
+	if (fsname.startsWith("ext"))
+		rc = ext2(bytes);
+	else if (fsname == "xfs")
+		rc = xfs(bytes);
+	else if (fsname.startsWith("fat") || (fsname == "vfat"))
+		rc = fat(bytes);
+	else if (fsname == "ntfs")
+		rc = ntfs(bytes);
+	else if (fsname == "btrfs")
+		rc = btrfs(bytes);
+	else if (fsname.contains("swap"))
+		rc = swap(bytes);
+
+	showDebug("fsstats::used, %s: %s %llu bytes\n", fsname.toLatin1().data(),
+		  rc ? "ok" : "ko", rc ? *bytes : 0ULL);
+	return rc;
+}
+
+bool QP_FSStats::extents(QString fsname, QVector<QP_Extent> *extents) {
+	QVector<QP_Extent> found;
+	unsigned long long used;
+	bool rc = false;
+
+	if (fsname.startsWith("ext"))
+		rc = ext2Extents(&found);
+	else if (fsname == "xfs")
+		rc = xfsExtents(&found);
+	else if (fsname.startsWith("fat") || (fsname == "vfat"))
+		rc = fat(&used, &found);
+	else if (fsname == "ntfs")
+		rc = ntfs(&used, &found);
+
+	if (!rc) {
+		showDebug("fsstats::extents, %s: ko\n", fsname.toLatin1().data());
+		return false;
+	}
+
+	/*---boot loaders, backup superblocks and signatures live at the edges---*/
+	QP_Extent head = { 0, EXTENT_EDGE };
+	QP_Extent tail = { _length - EXTENT_EDGE, EXTENT_EDGE };
+	found.append(head);
+	found.append(tail);
+
+	std::sort(found.begin(), found.end(),
+		  [](const QP_Extent &a, const QP_Extent &b) { return a.offset < b.offset; });
+
+	/*---clip to the partition and merge the ranges with small holes between---*/
+	extents->clear();
+	long long total = 0;
+
+	for (QP_Extent e : found) {
+		if (e.offset < 0) {
+			e.length += e.offset;
+			e.offset = 0;
+		}
+		if (e.offset + e.length > _length)
+			e.length = _length - e.offset;
+		if (e.length <= 0)
+			continue;
+
+		if (!extents->isEmpty()) {
+			QP_Extent &last = extents->last();
+			if (e.offset <= last.offset + last.length + EXTENT_GAP) {
+				if (e.offset + e.length > last.offset + last.length)
+					last.length = e.offset + e.length - last.offset;
+				continue;
+			}
+		}
+
+		extents->append(e);
+	}
+
+	for (const QP_Extent &e : *extents)
+		total += e.length;
+
+	showDebug("fsstats::extents, %s: %d extents, %lld of %lld bytes\n", fsname.toLatin1().data(),
+		  extents->count(), total, _length);
+	return true;
+}
+
+unsigned long QP_FSStats::usedKiloBytes(QP_PartInfo *partinfo) {
+	unsigned long long bytes;
+
+	QP_FSStats stats(partinfo->device()->shortname(), partinfo->start, partinfo->end);
+	if (!stats.used(partinfo->fsspec->name(), &bytes))
+		return 0L;
+
+	return (unsigned long)(bytes / 1024ULL);
+}
+
+/*---EXT2/3/4---------------------------------------------------------------------*/
+/*---sum the free blocks of every group descriptor: the counter in the superblock
+ *   is updated lazily by ext4---*/
+bool QP_FSStats::ext2(unsigned long long *used) {
+	uint8_t sb[1024];
+
+	if (!read(1024, sb, sizeof(sb)))
+		return false;
+
+	if (NTFS_GETU16(sb + 0x38) != 0xEF53)
+		return false;
+
+	uint32_t logBlockSize = NTFS_GETU32(sb + 0x18);
+	if (logBlockSize > 6)
+		return false;
+
+	uint64_t blockSize = 1024ULL << logBlockSize;
+	uint32_t incompat = NTFS_GETU32(sb + 0x60);
+	bool is64 = incompat & 0x80;		// INCOMPAT_64BIT
+	bool metaBg = incompat & 0x10;		// INCOMPAT_META_BG
+
+	uint64_t blocks = NTFS_GETU32(sb + 0x04);
+	uint64_t reserved = NTFS_GETU32(sb + 0x08);
+	uint64_t freeBlocks = NTFS_GETU32(sb + 0x0C);
+
+	if (is64) {
+		blocks |= (uint64_t)NTFS_GETU32(sb + 0x150) << 32;
+		reserved |= (uint64_t)NTFS_GETU32(sb + 0x154) << 32;
+		freeBlocks |= (uint64_t)NTFS_GETU32(sb + 0x158) << 32;
+	}
+
+	uint32_t firstData = NTFS_GETU32(sb + 0x14);
+	uint32_t perGroup = NTFS_GETU32(sb + 0x20);
+	uint16_t descSize = is64 ? NTFS_GETU16(sb + 0xFE) : 32;
+	if (descSize < 32)
+		descSize = 32;
+
+	if ((perGroup == 0) || (blocks <= firstData))
+		return false;
+
+	/*---with meta_bg the descriptors are spread over the disk: trust the superblock---*/
+	if (!metaBg) {
+		uint64_t groups = (blocks - firstData + perGroup - 1) / perGroup;
+		QByteArray table(groups * descSize, 0);
+
+		if (read((firstData + 1) * blockSize, table.data(), table.size())) {
+			freeBlocks = 0;
+
+			for (uint64_t g = 0; g < groups; g++) {
+				const uint8_t *desc = (const uint8_t *)table.constData() + g * descSize;
+				freeBlocks += NTFS_GETU16(desc + 0x0C);
+				if (is64 && (descSize >= 64))
+					freeBlocks += (uint64_t)NTFS_GETU16(desc + 0x2C) << 16;
+			}
+		}
+	}
+
+	if (freeBlocks > blocks)
+		return false;
+
+	/*---like statfs: used = blocks - available, and reserved are not available---*/
+	uint64_t usedBlocks = blocks - freeBlocks + reserved;
+	if (usedBlocks > blocks)
+		usedBlocks = blocks;
+
+	*used = usedBlocks * blockSize;
+	return true;
+}
+
+/*---the block bitmap of every group; a group not initialized yet (BLOCK_UNINIT)
+ *   only use its first blocks, for the backup superblock and descriptors---*/
+bool QP_FSStats::ext2Extents(QVector<QP_Extent> *extents) {
+	uint8_t sb[1024];
+
+	if (!read(1024, sb, sizeof(sb)))
+		return false;
+
+	if (NTFS_GETU16(sb + 0x38) != 0xEF53)
+		return false;
+
+	uint32_t logBlockSize = NTFS_GETU32(sb + 0x18);
+	if (logBlockSize > 6)
+		return false;
+
+	uint64_t blockSize = 1024ULL << logBlockSize;
+	uint32_t incompat = NTFS_GETU32(sb + 0x60);
+	uint32_t roCompat = NTFS_GETU32(sb + 0x64);
+	bool is64 = incompat & 0x80;		// INCOMPAT_64BIT
+
+	/*---with meta_bg the descriptors are spread over the disk, and with
+	 *   bigalloc the bitmaps count clusters: copy it all---*/
+	if ((incompat & 0x10) || (roCompat & 0x200))
+		return false;
+
+	uint64_t blocks = NTFS_GETU32(sb + 0x04);
+	if (is64)
+		blocks |= (uint64_t)NTFS_GETU32(sb + 0x150) << 32;
+
+	uint32_t firstData = NTFS_GETU32(sb + 0x14);
+	uint32_t perGroup = NTFS_GETU32(sb + 0x20);
+	uint32_t inodesPerGroup = NTFS_GETU32(sb + 0x28);
+	uint16_t inodeSize = (NTFS_GETU32(sb + 0x4C) >= 1) ? NTFS_GETU16(sb + 0x58) : 128;
+	uint16_t descSize = is64 ? NTFS_GETU16(sb + 0xFE) : 32;
+	if (descSize < 32)
+		descSize = 32;
+	bool hiDesc = is64 && (descSize >= 64);
+
+	if ((perGroup == 0) || (perGroup > blockSize * 8) || (blocks <= firstData))
+		return false;
+
+	uint64_t groups = (blocks - firstData + perGroup - 1) / perGroup;
+	uint64_t inodeTableBlocks = ((uint64_t)inodesPerGroup * inodeSize + blockSize - 1) / blockSize;
+	QByteArray table(groups * descSize, 0);
+	QByteArray bitmap(blockSize, 0);
+
+	if (!read((firstData + 1) * blockSize, table.data(), table.size()))
+		return false;
+
+	for (uint64_t g = 0; g < groups; g++) {
+		const uint8_t *desc = (const uint8_t *)table.constData() + g * descSize;
+		uint64_t start = firstData + g * perGroup;
+		uint64_t count = blocks - start;
+		if (count > perGroup)
+			count = perGroup;
+
+		uint64_t blockBitmap = NTFS_GETU32(desc + 0x00);
+		uint64_t inodeBitmap = NTFS_GETU32(desc + 0x04);
+		uint64_t inodeTable = NTFS_GETU32(desc + 0x08);
+		uint64_t freeBlocks = NTFS_GETU16(desc + 0x0C);
+		uint16_t flags = NTFS_GETU16(desc + 0x12);
+
+		if (hiDesc) {
+			blockBitmap |= (uint64_t)NTFS_GETU32(desc + 0x20) << 32;
+			inodeBitmap |= (uint64_t)NTFS_GETU32(desc + 0x24) << 32;
+			inodeTable |= (uint64_t)NTFS_GETU32(desc + 0x28) << 32;
+			freeBlocks |= (uint64_t)NTFS_GETU16(desc + 0x2C) << 16;
+		}
+
+		if (flags & 0x02) {		// BLOCK_UNINIT
+			if (freeBlocks < count)
+				add_extent(extents, start * blockSize, (count - freeBlocks) * blockSize);
+		}
+		else {
+			if ((blockBitmap >= blocks) || !read(blockBitmap * blockSize, bitmap.data(), blockSize))
+				return false;
+			add_bits(extents, (const uint8_t *)bitmap.constData(), count, start * blockSize, blockSize);
+		}
+
+		/*---with flex_bg the metadata of a group can be in another group---*/
+		add_extent(extents, blockBitmap * blockSize, blockSize);
+		add_extent(extents, inodeBitmap * blockSize, blockSize);
+		add_extent(extents, inodeTable * blockSize, inodeTableBlocks * blockSize);
+	}
+
+	return true;
+}
+
+/*---XFS--------------------------------------------------------------------------*/
+/*---the free space of every allocation group is in its AGF header---*/
+bool QP_FSStats::xfs(unsigned long long *used) {
+	uint8_t sb[512];
+
+	if (!read(0, sb, sizeof(sb)))
+		return false;
+
+	if (memcmp(sb, "XFSB", 4) != 0)
+		return false;
+
+	uint32_t blockSize = XFS_GETU32(sb + 4);
+	uint64_t dblocks = XFS_GETU64(sb + 8);
+	uint32_t agBlocks = XFS_GETU32(sb + 84);
+	uint32_t agCount = XFS_GETU32(sb + 88);
+	uint16_t sectSize = XFS_GETU16(sb + 102);
+
+	if ((blockSize == 0) || (agBlocks == 0) || (agCount == 0) || (sectSize == 0))
+		return false;
+
+	uint64_t freeBlocks = 0;
+	for (uint32_t ag = 0; ag < agCount; ag++) {
+		uint8_t agf[512];
+
+		if (!read((long long)ag * agBlocks * blockSize + sectSize, agf, sizeof(agf)))
+			return false;
+
+		if (memcmp(agf, "XAGF", 4) != 0)
+			return false;
+
+		/*---agf_freeblks + agf_flcount (the free list is free space too)---*/
+		freeBlocks += XFS_GETU32(agf + 52) + XFS_GETU32(agf + 48);
+	}
+
+	if (freeBlocks > dblocks)
+		return false;
+
+	*used = (dblocks - freeBlocks) * blockSize;
+	return true;
+}
+
+/*---the free extents of every allocation group are the leaves of its by-block
+ *   btree (bnobt): what is not there is in use---*/
+bool QP_FSStats::xfsExtents(QVector<QP_Extent> *extents) {
+	uint8_t sb[512];
+
+	if (!read(0, sb, sizeof(sb)))
+		return false;
+
+	if (memcmp(sb, "XFSB", 4) != 0)
+		return false;
+
+	uint32_t blockSize = XFS_GETU32(sb + 4);
+	uint64_t dblocks = XFS_GETU64(sb + 8);
+	uint32_t agBlocks = XFS_GETU32(sb + 84);
+	uint32_t agCount = XFS_GETU32(sb + 88);
+	uint16_t version = XFS_GETU16(sb + 100);
+	uint16_t sectSize = XFS_GETU16(sb + 102);
+
+	if ((blockSize < 512) || (agBlocks == 0) || (agCount == 0) || (sectSize == 0))
+		return false;
+
+	/*---v5 filesystems have the long (crc) btree block header---*/
+	bool crc = (version & 0x0F) == 5;
+	uint32_t header = crc ? 56 : 16;
+	uint32_t maxRecs = (blockSize - header) / 12;	// key (8) + pointer (4)
+	QByteArray buffer(blockSize, 0);
+	uint8_t *block = (uint8_t *)buffer.data();
+
+	for (uint32_t ag = 0; ag < agCount; ag++) {
+		uint64_t agStart = (uint64_t)ag * agBlocks;
+		uint64_t agLength = (dblocks > agStart + agBlocks) ? agBlocks : dblocks - agStart;
+		uint8_t agf[512];
+
+		if (!read(agStart * blockSize + sectSize, agf, sizeof(agf)))
+			return false;
+
+		if (memcmp(agf, "XAGF", 4) != 0)
+			return false;
+
+		uint32_t bno = XFS_GETU32(agf + 16);		// agf_roots[XFS_BTNUM_BNO]
+		uint32_t levels = XFS_GETU32(agf + 28);		// agf_levels[XFS_BTNUM_BNO]
+		if ((levels == 0) || (levels > 16))
+			return false;
+
+		/*---go down to the leftmost leaf, then follow the right siblings---*/
+		for (uint32_t level = levels; level > 0; level--) {
+			if ((bno >= agLength) || !read((agStart + bno) * blockSize, block, blockSize))
+				return false;
+
+			if ((memcmp(block, crc ? "AB3B" : "ABTB", 4) != 0)
+			 || (XFS_GETU16(block + 4) != level - 1))
+				return false;
+
+			if (level > 1)
+				bno = XFS_GETU32(block + header + maxRecs * 8);
+		}
+
+		uint64_t next = 0;		// first block not known to be free
+		uint64_t leaves = 0;
+
+		while (true) {
+			uint16_t recs = XFS_GETU16(block + 6);
+			if (header + recs * 8 > blockSize)
+				return false;
+
+			for (uint16_t r = 0; r < recs; r++) {
+				uint64_t start = XFS_GETU32(block + header + r * 8);
+				uint64_t count = XFS_GETU32(block + header + r * 8 + 4);
+
+				if ((start < next) || (start + count > agLength))
+					return false;
+
+				add_extent(extents, (agStart + next) * blockSize, (start - next) * blockSize);
+				next = start + count;
+			}
+
+			bno = XFS_GETU32(block + 12);		// bb_rightsib
+			if (bno == 0xFFFFFFFF)
+				break;
+
+			if ((++leaves > agLength) || (bno >= agLength)
+			 || !read((agStart + bno) * blockSize, block, blockSize)
+			 || (memcmp(block, crc ? "AB3B" : "ABTB", 4) != 0))
+				return false;
+		}
+
+		add_extent(extents, (agStart + next) * blockSize, (agLength - next) * blockSize);
+	}
+
+	return true;
+}
+
+/*---FAT12/16/32------------------------------------------------------------------*/
+/*---count the free entries of the first FAT---*/
+bool QP_FSStats::fat(unsigned long long *used, QVector<QP_Extent> *extents) {
+	uint8_t bs[512];
+
+	if (!read(0, bs, sizeof(bs)))
+		return false;
+
+	if ((bs[510] != 0x55) || (bs[511] != 0xAA))
+		return false;
+
+	uint16_t bytesPerSector = NTFS_GETU16(bs + 11);
+	uint8_t sectorsPerCluster = bs[13];
+	uint16_t reservedSectors = NTFS_GETU16(bs + 14);
+	uint8_t numFats = bs[16];
+	uint16_t rootEntries = NTFS_GETU16(bs + 17);
+	uint32_t totalSectors = NTFS_GETU16(bs + 19) ? NTFS_GETU16(bs + 19) : NTFS_GETU32(bs + 32);
+	uint32_t fatSize = NTFS_GETU16(bs + 22) ? NTFS_GETU16(bs + 22) : NTFS_GETU32(bs + 36);
+
+	if ((bytesPerSector < 512) || (bytesPerSector & (bytesPerSector - 1))
+	 || (sectorsPerCluster == 0) || (numFats == 0) || (fatSize == 0))
+		return false;
+
+	uint32_t rootSectors = ((rootEntries * 32) + bytesPerSector - 1) / bytesPerSector;
+	uint32_t metaSectors = reservedSectors + numFats * fatSize + rootSectors;
+	if (totalSectors <= metaSectors)
+		return false;
+
+	uint32_t clusters = (totalSectors - metaSectors) / sectorsPerCluster;
+	int bits = (clusters < 4085) ? 12 : ((clusters < 65525) ? 16 : 32);
+
+	/*---the table must be big enough for all the clusters (+2 reserved entries)---*/
+	if ((unsigned long long)fatSize * bytesPerSector * 8 < (unsigned long long)(clusters + 2) * bits)
+		return false;
+
+	long long fatOffset = (long long)reservedSectors * bytesPerSector;
+	long long dataOffset = (long long)metaSectors * bytesPerSector;
+	long long clusterSize = (long long)sectorsPerCluster * bytesPerSector;
+	uint64_t freeClusters = 0;
+
+	/*---boot sector, FATs and the FAT12/16 root directory---*/
+	if (extents)
+		add_extent(extents, 0, dataOffset);
+
+	if (bits == 12) {
+		/*---at most 6KiB: read it all, entries are 12 bit packed---*/
+		QByteArray table((clusters + 2) * 3 / 2 + 2, 0);
+		if (!read(fatOffset, table.data(), table.size()))
+			return false;
+
+		const uint8_t *t = (const uint8_t *)table.constData();
+		for (uint32_t c = 2; c < clusters + 2; c++) {
+			uint16_t v = NTFS_GETU16(t + c + c / 2);
+			v = (c & 1) ? (v >> 4) : (v & 0x0FFF);
+			if (v == 0)
+				freeClusters++;
+			else if (extents)
+				add_extent(extents, dataOffset + (c - 2) * clusterSize, clusterSize);
+		}
+	}
+	else {
+		/*---stream the table through a big buffer and count with SIMD---*/
+		QByteArray buffer(FAT_BUFFER, 0);
+		int entrySize = bits / 8;
+		uint64_t entry = 2;		// entries 0 and 1 are reserved
+		uint64_t lastEntry = (uint64_t)clusters + 2;
+		QElapsedTimer timer;
+
+		timer.start();
+
+		while (entry < lastEntry) {
+			uint64_t count = FAT_BUFFER / entrySize;
+			if (entry + count > lastEntry)
+				count = lastEntry - entry;
+
+			if (!read(fatOffset + entry * entrySize, buffer.data(), count * entrySize))
+				return false;
+
+			freeClusters += QP_FSFat::count_free_clusters((const uint8_t *)buffer.constData(),
+								      count, bits);
+
+			if (extents) {
+				const uint8_t *t = (const uint8_t *)buffer.constData();
+				for (uint64_t i = 0; i < count; i++) {
+					uint32_t v = (bits == 16) ? NTFS_GETU16(t + i * 2)
+								  : (NTFS_GETU32(t + i * 4) & 0x0FFFFFFF);
+					if (v != 0)
+						add_extent(extents, dataOffset + (entry + i - 2) * clusterSize, clusterSize);
+				}
+			}
+
+			entry += count;
+		}
+
+		showDebug("fsstats::fat, FAT%d %llu entries in %lld ms (%s)\n", bits,
+			  (unsigned long long)clusters, (long long)timer.elapsed(),
+			  QP_FSFat::count_free_clusters_impl());
+	}
+
+	if (freeClusters > clusters)
+		return false;
+
+	*used = (unsigned long long)(clusters - freeClusters) * sectorsPerCluster * bytesPerSector;
+	return true;
+}
+
+/*---NTFS-------------------------------------------------------------------------*/
+/*---$Bitmap (MFT record 6) has a bit for every cluster of the volume---*/
+bool QP_FSStats::ntfs(unsigned long long *used, QVector<QP_Extent> *extents) {
+	uint8_t bs[512];
+
+	if (!read(0, bs, sizeof(bs)))
+		return false;
+
+	if (memcmp(bs + 3, "NTFS", 4) != 0)
+		return false;
+
+	uint16_t bytesPerSector = NTFS_GETU16(bs + 0xB);
+	uint8_t sectorsPerCluster = NTFS_GETU8(bs + 0xD);
+	uint64_t totalSectors = NTFS_GETU64(bs + 0x28);
+	uint64_t mftLcn = NTFS_GETU64(bs + 0x30);
+	int8_t clustersPerRecord = NTFS_GETS8(bs + 0x40);
+
+	if ((bytesPerSector < 512) || (bytesPerSector % 512 != 0) || (sectorsPerCluster == 0))
+		return false;
+
+	uint64_t clusterSize = (uint64_t)bytesPerSector * sectorsPerCluster;
+	uint64_t totalClusters = totalSectors / sectorsPerCluster;
+	uint32_t recordSize;
+
+	if (clustersPerRecord > 0)
+		recordSize = clustersPerRecord * clusterSize;
+	else
+		recordSize = 1 << (-clustersPerRecord);
+
+	if ((recordSize < 512) || (recordSize > 65536))
+		return false;
+
+	QByteArray buffer(recordSize, 0);
+	uint8_t *record = (uint8_t *)buffer.data();
+
+	if (!read(mftLcn * clusterSize + 6 * recordSize, record, recordSize))
+		return false;
+
+	if (memcmp(record, "FILE", 4) != 0)
+		return false;
+
+	/*---apply the update sequence (fixup) to every 512 bytes block---*/
+	uint16_t usaOffset = NTFS_GETU16(record + 4);
+	uint16_t usaCount = NTFS_GETU16(record + 6);
+	if ((usaOffset + usaCount * 2 > recordSize) || ((uint32_t)(usaCount - 1) * 512 > recordSize))
+		return false;
+
+	for (uint16_t i = 1; i < usaCount; i++)
+		memcpy(record + i * 512 - 2, record + usaOffset + i * 2, 2);
+
+	/*---look for the non resident $DATA attribute---*/
+	uint32_t attrOffset = NTFS_GETU16(record + 0x14);
+	uint8_t *runs = NULL;
+	uint8_t *recordEnd = record + recordSize;
+
+	while (attrOffset + 8 <= recordSize) {
+		uint8_t *attr = record + attrOffset;
+		uint32_t type = NTFS_GETU32(attr);
+		uint32_t len = NTFS_GETU32(attr + 4);
+
+		if ((type == 0xFFFFFFFF) || (len == 0) || (attrOffset + len > recordSize))
+			break;
+
+		if ((type == 0x80) && (attr[8] != 0)) {
+			runs = attr + NTFS_GETU16(attr + 0x20);
+			recordEnd = attr + len;
+			break;
+		}
+
+		attrOffset += len;
+	}
+
+	if (!runs)
+		return false;
+
+	/*---walk the data runs and count the bits set---*/
+	QByteArray bitmap(STATS_BUFFER, 0);
+	uint64_t bitsLeft = totalClusters;
+	uint64_t usedClusters = 0;
+	int64_t lcn = 0;
+
+	while ((runs < recordEnd) && (*runs != 0) && (bitsLeft > 0)) {
+		int lengthSize = *runs & 0x0F;
+		int offsetSize = *runs >> 4;
+
+		if ((lengthSize == 0) || (lengthSize > 8) || (offsetSize > 8)
+		 || (runs + 1 + lengthSize + offsetSize > recordEnd))
+			return false;
+
+		uint64_t runLength = 0;
+		for (int i = 0; i < lengthSize; i++)
+			runLength |= (uint64_t)runs[1 + i] << (8 * i);
+
+		int64_t runOffset = 0;
+		for (int i = 0; i < offsetSize; i++)
+			runOffset |= (int64_t)runs[1 + lengthSize + i] << (8 * i);
+		if (offsetSize && (runs[lengthSize + offsetSize] & 0x80))
+			runOffset |= -((int64_t)1 << (8 * offsetSize));	// sign extend
+
+		runs += 1 + lengthSize + offsetSize;
+
+		/*---a sparse run (no offset) has no data on disk---*/
+		if (offsetSize == 0)
+			return false;
+		lcn += runOffset;
+
+		uint64_t runBytes = runLength * clusterSize;
+		uint64_t done = 0;
+
+		while ((done < runBytes) && (bitsLeft > 0)) {
+			uint64_t n = runBytes - done;
+			if (n > STATS_BUFFER)
+				n = STATS_BUFFER;
+			if (n * 8 > bitsLeft)
+				n = (bitsLeft + 7) / 8;
+
+			if (!read(lcn * clusterSize + done, bitmap.data(), n))
+				return false;
+
+			const uint8_t *b = (const uint8_t *)bitmap.constData();
+			uint64_t bits = (n * 8 > bitsLeft) ? bitsLeft : n * 8;
+			uint64_t i = 0;
+
+			for (; i + 64 <= bits; i += 64) {
+				uint64_t word;
+				memcpy(&word, b + i / 8, 8);
+				usedClusters += __builtin_popcountll(word);
+			}
+			for (; i < bits; i++)
+				if (b[i / 8] & (1 << (i % 8)))
+					usedClusters++;
+
+			if (extents)
+				add_bits(extents, b, bits, (totalClusters - bitsLeft) * clusterSize, clusterSize);
+
+			bitsLeft -= bits;
+			done += n;
+		}
+	}
+
+	if (bitsLeft > 0)
+		return false;
+
+	/*---the backup boot sector is after the last cluster---*/
+	if (extents)
+		add_extent(extents, totalSectors * bytesPerSector, bytesPerSector);
+
+	*used = usedClusters * clusterSize;
+	return true;
+}
+
+/*---BTRFS------------------------------------------------------------------------*/
+bool QP_FSStats::btrfs(unsigned long long *used) {
+	uint8_t sb[4096];
+
+	if (!read(65536, sb, sizeof(sb)))
+		return false;
+
+	if (memcmp(sb + 0x40, "_BHRfS_M", 8) != 0)
+		return false;
+
+	/*---bytes_used of the whole filesystem (good for a single device)---*/
+	*used = NTFS_GETU64(sb + 0x78);
+	return true;
+}
+
+/*---SWAP-------------------------------------------------------------------------*/
+/*---there are no data in an unused swap: only the header page is used---*/
+bool QP_FSStats::swap(unsigned long long *used) {
+	static const long pageSizes[] = { 4096, 8192, 16384, 65536 };
+	char magic[10];
+
+	for (long pageSize : pageSizes) {
+		if (!read(pageSize - 10, magic, sizeof(magic)))
+			continue;
+
+		if ((memcmp(magic, "SWAPSPACE2", 10) == 0) || (memcmp(magic, "SWAP-SPACE", 10) == 0)) {
+			*used = pageSize;
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,81 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* About QP_FSStats class:
+ *
+ * Get the used space of a filesystem reading its own metadata, without
+ * mounting it: ext2/3/4 group descriptors, XFS AG headers, FAT tables,
+ * the NTFS $Bitmap, the btrfs superblock and the swap header.
+ *
+ * With "extents" it also give the ranges of the partition that are in use
+ * (from the ext2/3/4 block bitmaps, the XFS free space btrees, the FAT and
+ * the NTFS $Bitmap), so a copy can skip the free space.
+ *
+ * It use its own read only file descriptor on the disk (not the PedDevice),
+ * so it can be used by the QP_ScanPool threads.
+ */
+
+#ifndef QP_FSSTATS_H
+#define QP_FSSTATS_H
+
+#include <stddef.h>
+#include <qstring.h>
+#include <QVector>
+#include "qp_libparted.h"
+
+#define EXTENT_GAP  (256 * 1024)	/*---read a smaller hole than skip it     ---*/
+#define EXTENT_EDGE (1024 * 1024)	/*---always copy the first and last MiB   ---*/
+
+/*---a range in use, in bytes from the start of the partition---*/
+struct QP_Extent {
+	long long offset;
+	long long length;
+};
+
+class QP_FSStats {
+public:
+	QP_FSStats(QString device, PedSector start, PedSector end);
+	~QP_FSStats();
+	bool used(QString fsname, unsigned long long *bytes); /*---false if not supported---*/
+	bool read(long long offset, void *buffer, size_t length);  /*---offset in the partition---*/
+	long long length();
+
+	/*---sorted ranges in use, false if the filesystem is not supported---*/
+	bool extents(QString fsname, QVector<QP_Extent> *);
+
+	/*---used KiloBytes of an unmounted partition, 0 on failure---*/
+	static unsigned long usedKiloBytes(QP_PartInfo *);
+
+private:
+	bool ext2(unsigned long long *);
+	bool xfs(unsigned long long *);
+	bool fat(unsigned long long *, QVector<QP_Extent> *extents = NULL);
+	bool ntfs(unsigned long long *, QVector<QP_Extent> *extents = NULL);
+	bool ext2Extents(QVector<QP_Extent> *);
+	bool xfsExtents(QVector<QP_Extent> *);
+	bool btrfs(unsigned long long *);
+	bool swap(unsigned long long *);
+	int _fd;
+	long long _offset;
+	long long _length;
+};
+
+#endif
@@ -21,58 +21,73 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
-#include <qregexp.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <stdarg.h>
 #include <errno.h>
 #include <stdint.h>
 #include <sys/mount.h>
+#include <string.h>
 #include <qapplication.h>
+#include <QMutex>
+#include <QMutexLocker>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 #include "qp_fswrap.h"
 #include "qp_actlist.h"
+#include "qp_blockreader.h"
 #include "qp_common.h"
 #include "qp_debug.h"
+#include "qp_pedlock.h"
+#include "qp_toolparser.h"
 
 #define NOTFOUND tr("command not found")
 #define TMP_MOUNTPOINT "/tmp/mntqp"
+#define MOUNT_TIMEOUT  (60 * 1000)	/*---a mount that hang (dead disk, nfs...)---*/
+
+/*---TMP_MOUNTPOINT is one for all the devices, also when committed together---*/
+static QMutex mountMutex;
 
 #define my_min(a,b) ((a)<(b) ? (a):(b))
 
-bool QP_FSWrap::fs_open(QString cmdline, bool localized)
+/*---start a tool: args[0] is its path, the others are its arguments---*/
+bool QP_FSWrap::fs_open(QStringList args, bool localized, bool cancelable, int timeout)
 {
+	/*---a tool that write the filesystem in place is never stopped in the middle---*/
+	_process.setCancel(cancelable ? _cancel : NULL);
+	_process.setTimeout(timeout);
 
-	/*---this force stderr to stdout and a parsable language---*/
-	QString dupcmdline = QString("%1 %2")
-	                     .arg(cmdline)
-	                     .arg(QString("2>&1"));
-
-	if (!localized)
-		dupcmdline = "LC_ALL=POSIX " + dupcmdline;
-
-	/*---open a pipe from the command line---*/
-	fp = popen(dupcmdline.toLatin1(), "r");
-
-	if (fp)
-		return true;
-	else
-		return false;
+	return _process.start(args, localized);
 }
 
+/*---a line of stdout or stderr, as they come---*/
 char *QP_FSWrap::fs_getline()
 {
-	bool rc = fgets(line, sizeof line, fp);
+	/*---while the tool work, the other commits can call libparted---*/
+	QP_PedUnlock unlock;
 
-	if (rc)
-		return line;
-	else
+	if (!_process.getLine(&_line))
 		return NULL;
+
+	return _line.data();
 }
 
 int QP_FSWrap::fs_close()
 {
-	return pclose(fp);
+	QP_PedUnlock unlock;
+	int status = _process.wait();
+
+	if (_process.stopped())
+		_message = _process.message();
+
+	return status;
+}
+
+void QP_FSWrap::setCancel(const QAtomicInt *cancel)
+{
+	_cancel = cancel;
 }
 
 QP_FSWrap *QP_FSWrap::fswrap(QString name)
@@ -89,7 +104,7 @@ QP_FSWrap *QP_FSWrap::fswrap(QString name)
 		fswrap = new QP_FSExt3();
 	else if (name.compare("ext4") == 0)
 		fswrap = new QP_FSExt4();
-	else if (name.compare("ext3") == 0)
+	else if (name.compare("btrfs") == 0)
 		fswrap = new QP_FSBtrFS();
 	else if (name.compare("xfs") == 0)
 		fswrap = new QP_FSXfs();
@@ -136,6 +151,11 @@ QString QP_FSWrap::get_label(PedPartition * part, QString name)
 bool QP_FSWrap::read_sector(PedPartition * part, PedSector offset,
 			    PedSector count, char *buffer)
 {
+	/*---during a scan the device is already open (see QP_BlockReader)---*/
+	QP_BlockReader *reader = QP_BlockReader::find(part->geom.dev);
+	if (reader)
+		return reader->read(&part->geom, offset, count, buffer);
+
 	/*---open a new device, read a sector and close it---*/
 	if (!ped_device_open(part->geom.dev))
 		return false;
@@ -159,21 +179,20 @@ bool QP_FSWrap::qpMount(QString device)
 	qpUMount(device);
 
 	/*---mount the partition---*/
-	QString cmdline = lstExternalTools->getPath("mount") + " " + device + " " + TMP_MOUNTPOINT;
+	QStringList cmdline = QStringList() << lstExternalTools->getPath("mount") << device << TMP_MOUNTPOINT;
 
-	if (!fs_open(cmdline, true)) {
+	/*---used by the scans: the "Cancel" of a commit must not stop it (the timeout does)---*/
+	if (!fs_open(cmdline, true, false, MOUNT_TIMEOUT)) {
 		_message = QString(NOTFOUND);
 		return false;
 	}
 
+	QP_ToolParser parser("mount");
+	QP_ToolMatch match;
 	char *cline;
 	while ((cline = fs_getline())) {
-		QString line = QString(cline);
-
-		QRegExp rx = QRegExp("^mount: (.*)$");
-		if (rx.indexIn(line) == 0) {
-			QString capError = rx.cap(1);
-			_message = capError;
+		if (parser.parse(cline, &match) && (match.event == ToolFailure)) {
+			_message = match.text;
 			error = true;
 		}
 	}
@@ -198,23 +217,14 @@ bool QP_FSWrap::qpUMount(QString device)
 QP_FSNtfs::QP_FSNtfs():QP_FSWrap()
 {
 	/*---check if the wrapper is installed---*/
-	QString cmdline = "which " + lstExternalTools->getPath("mkntfs");
-	fs_open(cmdline);
-	char *cline;
-	while ((cline = fs_getline()))
+	if (lstExternalTools->available("mkntfs"))
 		wrap_create = true;
-	fs_close();
 
 	/*---check if the wrapper is installed---*/
-	cmdline = "which " + lstExternalTools->getPath("ntfsresize");
-	fs_open(cmdline);
-
-
-	while ((cline = fs_getline())) {
+	if (lstExternalTools->available("ntfsresize")) {
 		wrap_resize = Both;
 		wrap_min_size = true;
 	}
-	fs_close();
 }
 
 bool QP_FSNtfs::resize(QP_LibParted * _libparted, bool write,
@@ -325,8 +335,8 @@ bool QP_FSNtfs::ntfsresize(bool write, QString dev, PedSector newsize)
 	PedSector size = (PedSector) ((newsize - 1) * 512);
 
 	/*---read-only test---*/
-	QString cmdline = lstExternalTools->getPath("ntfsresize") + " " +
-	                  "-n -ff -s " + QString::number(size) + " " + dev;
+	QStringList cmdline = QStringList() << lstExternalTools->getPath("ntfsresize")
+	                      << "-n" << "-ff" << "-s" << QString::number(size) << dev;
 
 	if (!fs_open(cmdline)) {
 		_message = QString(NOTFOUND);
@@ -334,63 +344,21 @@ bool QP_FSNtfs::ntfsresize(bool write, QString dev, PedSector newsize)
 	}
 
 	bool error = false;
+	QP_ToolParser parser("ntfsresize");
+	QP_ToolMatch match;
 	char *cline;
 	while ((cline = fs_getline())) {
-		QString line = QString(cline);
+		if (!parser.parse(cline, &match))
+			continue;
 
-		QRegExp rx;
-
-		if (!error) {
-			rx = QRegExp("^ERROR.*: (.*)");
-			if (rx.indexIn(line) == 0) {
-				QString captured = rx.cap(1);
-				_message = QString(captured);
-				error = true;
-			}
-		}
-
-		if (!error) {
-			rx = QRegExp("^The volume end is fragmented.*");
-			if (rx.indexIn(line) == 0) {
-				_message =
-				    QString
-				    ("The partition is fragmented.");
-				error = true;
-			}
-		}
-
-		/*---progress bar!---*/
-		QString linesub = line;
-#ifdef QT30COMPATIBILITY
-		linesub.replace(QRegExp("\r"), " ");
-#else
-		linesub.replace(QChar('\r'), " ");
-#endif
-		//example: 34,72 percent completed
-		rx = QRegExp("^.* (\\d*),(\\d*) percent completed.*$");
-		if (rx.indexIn(linesub) == 0) {
-			QString capIntPercent = rx.cap(1);
-			printf("letto: %s\n", capIntPercent.toLatin1().data());
-			//QString capFloatPercent = rx.cap(2);
-
-			bool rc;
-			int iPerc = capIntPercent.toInt(&rc) - 1;
-			if (iPerc < 0)
-				iPerc = 0;	//the percente completed run many times, but i don't want it reach 100%
-
-			emit sigTimer(iPerc,
-				      QString(tr("Resizing in progress.")),
-				      QString::null);
-		}
-		//BETA: change could with might with ntfsresize 1.9
-		//rx = QRegExp("^Now You could resize at \\d* bytes or (\\d*) .*");
-		rx = QRegExp("^.*You ..... resize at \\d* bytes or (\\d*) .*");
-		if (rx.indexIn(line) == 0) {
-			QString captured = rx.cap(1);
-			_message = QString("The partition is fragmented. Try to defragment it, or resize to %1MB")
-			           .arg(captured);
+		/*---the first error is the one to show---*/
+		if ((match.event == ToolFailure) && !error) {
+			_message = match.text;
 			error = true;
 		}
+
+		if (match.event == ToolProgress)
+			emit sigTimer(match.percent, match.text, QString::null);
 	}
 	fs_close();
 
@@ -403,58 +371,24 @@ bool QP_FSNtfs::ntfsresize(bool write, QString dev, PedSector newsize)
 
 
 	/*---ok, the readonly test seems ok... now we resize it!---*/
-	cmdline = lstExternalTools->getPath("ntfsresize") + " -ff -s " + QString::number(size) + " " + dev;
-	if (!fs_open(cmdline)) {
+	cmdline = QStringList() << lstExternalTools->getPath("ntfsresize")
+	                        << "-ff" << "-s" << QString::number(size) << dev;
+	if (!fs_open(cmdline, false, false)) {
 		_message = QString(NOTFOUND);
 		return false;
 	}
 
 	bool success = false;
 	while ((cline = fs_getline())) {
-		QString line = QString(cline);
-		QRegExp rx;
+		if (!parser.parse(cline, &match))
+			continue;
 
-		/*---progress bar!---*/
-		QString linesub = line;
-#ifdef QT30COMPATIBILITY
-		linesub.replace(QRegExp("\r"), " ");
-#else
-		linesub.replace(QChar('\r'), " ");
-#endif
-		//example: 34,72 percent completed
-		rx = QRegExp("^.* (\\d*),(\\d*) percent completed.*$");
-		if (rx.indexIn(linesub) == 0) {
-			QString capIntPercent = rx.cap(1);
-			//QString capFloatPercent = rx.cap(2);
-
-			bool rc;
-			int iPerc = capIntPercent.toInt(&rc) - 1;
-			if (iPerc < 0)
-				iPerc = 0;	//the percente completed run many times, but i don't want it reach 100%
-
-			emit sigTimer(iPerc,
-				      QString(tr("Resizing in progress.")),
-				      QString::null);
-		}
-		//rx = QRegExp("^Successfully resized NTFS on device");
-		rx = QRegExp("^.*[Ss]uccessfully.*");
-		if (rx.indexIn(line) == 0)
-			success = true;
-		rx = QRegExp("^Nothing to do: NTFS volume size is already OK.");
-		if (rx.indexIn(line) == 0)
+		if (match.event == ToolProgress)
+			emit sigTimer(match.percent, match.text, QString::null);
+		else if (match.event == ToolSuccess)
 			success = true;
-
-		rx = QRegExp("^Syncing device.*");
-		if (rx.indexIn(line) == 0) {
-			emit sigTimer(99, QString(tr("Syncing device.")),
-				      QString::null);
-		}
-
-		rx = QRegExp("^ERROR.*: (.*)");
-		if (rx.indexIn(line) == 0) {
-			QString captured = rx.cap(1);
-			_message = QString(captured);
-		}
+		else if (match.event == ToolFailure)
+			_message = match.text;
 	}
 	fs_close();
 
@@ -469,17 +403,14 @@ bool QP_FSNtfs::ntfsresize(bool write, QString dev, PedSector newsize)
 
 bool QP_FSNtfs::mkpartfs(QString dev, QString label)
 {
-	QString cmdline;
-
 	/*---init of the error message---*/
 	_message = QString::null;
 
 	/*---prepare the command line---*/
-	if (label.isEmpty())
-		cmdline = " -f -s 512 " + dev;
-	else
-		cmdline = " -f -s 512 -L " + label + " " + dev;
-	cmdline = lstExternalTools->getPath("mkntfs") + cmdline;
+	QStringList cmdline = QStringList() << lstExternalTools->getPath("mkntfs") << "-f" << "-s" << "512";
+	if (!label.isEmpty())
+		cmdline << "-L" << label;
+	cmdline << dev;
 
 	if (!fs_open(cmdline)) {
 		_message = QString(NOTFOUND);
@@ -488,19 +419,17 @@ bool QP_FSNtfs::mkpartfs(QString dev, QString label)
 
 
 	bool success = false;
+	QP_ToolParser parser("mkntfs");
+	QP_ToolMatch match;
 	char *cline;
 	while ((cline = fs_getline())) {
-		QString line = QString(cline);
+		if (!parser.parse(cline, &match))
+			continue;
 
-		QRegExp rx;
-		rx = QRegExp("^mkntfs completed successfully. Have a nice day.");
-		if (rx.indexIn(line) == 0)
+		if (match.event == ToolSuccess)
 			success = true;
-
-		rx = QRegExp("^ERROR.*: (.*)");
-		if (rx.indexIn(line) == 0) {
-			QString captured = rx.cap(1);
-			_message = QString(captured);
+		else if (match.event == ToolFailure) {
+			_message = match.text;
 			success = false;
 		}
 	}
@@ -516,29 +445,29 @@ PedSector QP_FSNtfs::min_size(QString dev)
 	/*---init of the error message---*/
 	_message = QString::null;
 
+	/*---very old ntfsresize cannot tell it (asked once, see QP_ListExternalTools)---*/
+	if (!lstExternalTools->supports("ntfsresize", "--info")) {
+		_message = tr("This ntfsresize cannot get the minimum size.");
+		return size;
+	}
+
 	/*---prepare the command line---*/
-	QString cmdline = lstExternalTools->getPath("ntfsresize") + " -f -i " + dev;
+	QStringList cmdline = QStringList() << lstExternalTools->getPath("ntfsresize") << "-f" << "-i" << dev;
 
-	if (!fs_open(cmdline)) {
+	/*---a scan: it only read, and a canceled commit must not leave min_size at -1---*/
+	if (!fs_open(cmdline, false, false)) {
 		_message = QString(NOTFOUND);
-		return false;
+		return size;
 	}
 
 
-	bool success = false;
+	QP_ToolParser parser("ntfsresize-info");
+	QP_ToolMatch match;
 	char *cline;
 	while ((cline = fs_getline())) {
-		QString line = QString(cline);
-
-		QRegExp rx;
-		rx = QRegExp("^.*You ..... resize at (\\d*) bytes or (\\d*) .*");
-		if (rx.indexIn(line) == 0) {
-			QString captured = rx.cap(1);
-			sscanf(captured.toLatin1(), "%lld", &size);
-			size /= 512;
+		if (parser.parse(cline, &match) && (match.event == ToolValue)) {
+			size = match.text.toLongLong() / 512;
 			size += 8 * MEGABYTE_SECTORS;
-
-			success = true;
 		}
 	}
 	fs_close();
@@ -559,26 +488,19 @@ QString QP_FSNtfs::fsname()
 QP_FSswap::QP_FSswap():QP_FSWrap()
 {
 	/*---check if the wrapper is installed---*/
-	QString cmdline = "which " + lstExternalTools->getPath("mkswap");
-	fs_open(cmdline);
-
-	char *cline;
-	while ((cline = fs_getline()))
+	if (lstExternalTools->available("mkswap"))
 		wrap_create = true;
-	fs_close();
 }
 
 bool QP_FSswap::mkpartfs(QString dev, QString label) {
-	QString cmdline;
-
 	/*---init of the error message---*/
 	_message = QString::null;
 
 	/*---prepare the command line---*/
+	QStringList cmdline = QStringList() << lstExternalTools->getPath("mkswap");
 	if (!label.isEmpty())
-		cmdline = " -L " + label;
-	cmdline += " -v1 ";
-	cmdline = lstExternalTools->getPath("mkswap") + cmdline + " " + dev;
+		cmdline << "-L" << label;
+	cmdline << "-v1" << dev;
 
 	if (!fs_open(cmdline)) {
 		_message = QString(NOTFOUND);
@@ -586,12 +508,9 @@ bool QP_FSswap::mkpartfs(QString dev, QString label) {
 	}
 
 
-	bool writenode = false;
 	bool success = false;
-	char *cline;
-	while ((cline = fs_getline())) {
-		QString line = QString(cline);
-	}
+	while (fs_getline())
+		;
 	success = (fs_close() == 0);
 
 	if (!success)
@@ -604,13 +523,8 @@ bool QP_FSswap::mkpartfs(QString dev, QString label) {
 QP_FSJfs::QP_FSJfs():QP_FSWrap(Enlarge)
 {
 	/*---check if the wrapper is installed---*/
-	QString cmdline = "which " + lstExternalTools->getPath("mkfs.jfs");
-	fs_open(cmdline);
-
-	char *cline;
-	while ((cline = fs_getline()))
+	if (lstExternalTools->available("mkfs.jfs"))
 		wrap_create = true;
-	fs_close();
 }
 
 bool QP_FSJfs::resize(QP_LibParted * _libparted, bool write,
@@ -682,13 +596,18 @@ bool QP_FSJfs::resize(QP_LibParted * _libparted, bool write,
 
 bool QP_FSJfs::jfsresize(bool write, QP_PartInfo * partinfo, PedSector)
 {
-	QString cmdline;
+	QStringList cmdline;
 
 	bool error = false;
 
 	if (!write)
 		return true;
 
+	/*---never wait for mountMutex holding libparted: who has it may want
+	 *   libparted back after a line of its tool (see QP_PedLock)---*/
+	QP_PedUnlock unlock;
+	QMutexLocker locker(&mountMutex);
+
 	/*---init of the error message---*/
 	_message = QString::null;
 
@@ -697,22 +616,19 @@ bool QP_FSJfs::jfsresize(bool write, QP_PartInfo * partinfo, PedSector)
 
 
 	/*---do the resize!---*/
-	cmdline = lstExternalTools->getPath("mount") + " -o remount,resize= " + TMP_MOUNTPOINT;
+	cmdline = QStringList() << lstExternalTools->getPath("mount") << "-o" << "remount,resize=" << TMP_MOUNTPOINT;
 
-	if (!fs_open(cmdline)) {
+	if (!fs_open(cmdline, false, false)) {
 		_message = QString(NOTFOUND);
 		return false;
 	}
 
+	QP_ToolParser parser("mount");
+	QP_ToolMatch match;
 	char *cline;
 	while ((cline = fs_getline())) {
-		QString line = QString(cline);
-
-		QRegExp rx;
-		rx = QRegExp("^mount: (.*)$");
-		if (rx.indexIn(line) == 0) {
-			QString capError = rx.cap(1);
-			_message = capError;
+		if (parser.parse(cline, &match) && (match.event == ToolFailure)) {
+			_message = match.text;
 			error = true;
 		}
 	}
@@ -730,17 +646,14 @@ bool QP_FSJfs::jfsresize(bool write, QP_PartInfo * partinfo, PedSector)
 
 bool QP_FSJfs::mkpartfs(QString dev, QString label)
 {
-	QString cmdline;
-
 	/*---init of the error message---*/
 	_message = QString::null;
 
 	/*---prepare the command line---*/
-	if (label.isEmpty())
-		cmdline = " -q " + dev;
-	else
-		cmdline = " -q -L " + label + " " + dev;
-	cmdline = lstExternalTools->getPath("mkfs.jfs") + cmdline;
+	QStringList cmdline = QStringList() << lstExternalTools->getPath("mkfs.jfs") << "-q";
+	if (!label.isEmpty())
+		cmdline << "-L" << label;
+	cmdline << dev;
 
 	if (!fs_open(cmdline)) {
 		_message = QString(NOTFOUND);
@@ -749,15 +662,12 @@ bool QP_FSJfs::mkpartfs(QString dev, QString label)
 
 
 	bool success = false;
+	QP_ToolParser parser("mkfs.jfs");
+	QP_ToolMatch match;
 	char *cline;
-	while ((cline = fs_getline())) {
-		QString line = QString(cline);
-
-		QRegExp rx;
-		rx = QRegExp("^Format completed successfully.");
-		if (rx.indexIn(line) == 0)
+	while ((cline = fs_getline()))
+		if (parser.parse(cline, &match) && (match.event == ToolSuccess))
 			success = true;
-	}
 	fs_close();
 
 	return success;
@@ -786,13 +696,8 @@ QString QP_FSJfs::_get_label(PedPartition * part)
 QP_FSExt2::QP_FSExt2():QP_FSWrap(),_fsType("ext2"),_extraArgs(QString::null)
 {
 	/*---check if the wrapper is installed---*/
-	QString cmdline = "which " + lstExternalTools->getPath("mkfs." + _fsType);
-	fs_open(cmdline);
-
-	char *cline;
-	while ((cline = fs_getline()))
+	if (lstExternalTools->available("mkfs." + _fsType))
 		wrap_create = true;
-	fs_close();
 }
 
 QString QP_FSExt2::_get_label(PedPartition * part)
@@ -813,15 +718,15 @@ QString QP_FSExt2::_get_label(PedPartition * part)
 
 bool QP_FSExt2::mkpartfs(QString dev, QString label)
 {
-	QString cmdline;
-
 	/*---init of the error message---*/
 	_message = QString::null;
 
 	/*---prepare the command line---*/
+	QStringList cmdline = QStringList() << lstExternalTools->getPath("mkfs." + _fsType)
+	                                    << "-t" << _fsType << "-m" << "1";
 	if (!label.isEmpty())
-		cmdline = " -L " + label;
-	cmdline = lstExternalTools->getPath("mkfs." + _fsType) + " -t " + _fsType + " -m 1 " + cmdline + " " + _extraArgs + " " + dev;
+		cmdline << "-L" << label;
+	cmdline << _extraArgs.split(' ', QString::SkipEmptyParts) << dev;
 
 	if (!fs_open(cmdline)) {
 		_message = QString(NOTFOUND);
@@ -829,54 +734,17 @@ bool QP_FSExt2::mkpartfs(QString dev, QString label)
 	}
 
 
-	bool writenode = false;
 	bool success = false;
+	QP_ToolParser parser("mke2fs");
+	QP_ToolMatch match;
 	char *cline;
 	while ((cline = fs_getline())) {
-		QString line = QString(cline);
+		if (!parser.parse(cline, &match))
+			continue;
 
-		QRegExp rx;
-		rx = QRegExp("^Writing inode tables");
-		if (rx.indexIn(line) == 0) {
-			writenode = true;
-		}
-
-		rx = QRegExp("^Creating journal");
-		if (rx.indexIn(line) == 0) {
-			writenode = false;
-			emit sigTimer(90,
-				      QString(tr
-					      ("Writing superblocks and filesystem.")),
-				      QString::null);
-		}
-
-		if (writenode) {
-			QString linesub = line;
-
-#ifdef QT30COMPATIBILITY
-			linesub.replace(QRegExp("\b"), " ");
-#else
-			linesub.replace(QChar('\b'), " ");
-#endif
-			rx = QRegExp("^.* (\\d*)/(\\d*) .*$");
-			if (rx.indexIn(linesub) == 0) {
-				QString capActual = rx.cap(1);
-				QString capTotal = rx.cap(2);
-
-				bool rc;
-				int iActual = capActual.toInt(&rc);
-				int iTotal = capTotal.toInt(&rc);
-
-				int iPerc = iActual * 80 / iTotal;	//The percentual is calculated in 80% ;)
-				emit sigTimer(iPerc,
-					      QString(tr
-						      ("Writing inode tables.")),
-					      QString::null);
-			}
-		}
-
-		rx = QRegExp("^Writing superblocks and filesystem accounting information: done");
-		if (rx.indexIn(line) == 0)
+		if (match.event == ToolProgress)
+			emit sigTimer(match.percent, match.text, QString::null);
+		else if (match.event == ToolSuccess)
 			success = true;
 	}
 	fs_close();
@@ -897,6 +765,9 @@ QP_FSExt3::QP_FSExt3():QP_FSExt2()
 {
 	_fsType = "ext3";
 	_extraArgs = " -j ";
+
+	/*---QP_FSExt2 checked mkfs.ext2---*/
+	wrap_create = lstExternalTools->available("mkfs." + _fsType);
 }
 
 
@@ -905,92 +776,47 @@ QP_FSExt4::QP_FSExt4():QP_FSExt3()
 {
 	_fsType = "ext4";
 	_extraArgs += " -j -O dir_index,extent,flex_bg,resize_inode,sparse_super,uninit_bg ";
+
+	/*---QP_FSExt3 checked mkfs.ext3---*/
+	wrap_create = lstExternalTools->available("mkfs." + _fsType);
 }
 
 /*---BTRFS WRAPPER----------------------------------------------------------------*/
 QP_FSBtrFS::QP_FSBtrFS():QP_FSWrap()
 {
 	/*---check if the wrapper is installed---*/
-	QString cmdline = "which " + lstExternalTools->getPath("mkfs.btrfs");
-	fs_open(cmdline);
-
-	char *cline;
-	while ((cline = fs_getline()))
+	if (lstExternalTools->available("mkfs.btrfs"))
 		wrap_create = true;
-	fs_close();
 
 }
 
 bool QP_FSBtrFS::mkpartfs(QString dev, QString label)
 {
-	QString cmdline;
-
 	/*---init of the error message---*/
 	_message = QString::null;
 
 	/*---prepare the command line---*/
+	QStringList cmdline = QStringList() << lstExternalTools->getPath("mkfs.btrfs");
 	if (!label.isEmpty())
-		cmdline = " -L " + label;
-	cmdline = lstExternalTools->getPath("mkfs.btrfs") + cmdline + " " + dev;
+		cmdline << "-L" << label;
+	cmdline << dev;
 
 	if (!fs_open(cmdline)) {
 		_message = QString(NOTFOUND);
 		return false;
 	}
 
-	bool writenode = false;
-	bool success = false;
+	QP_ToolParser parser("mkfs.btrfs");
+	QP_ToolMatch match;
 	char *cline;
-	while ((cline = fs_getline())) {
-		QString line = QString(cline);
-
-		QRegExp rx;
-		rx = QRegExp("^Writing inode tables");
-		if (rx.indexIn(line) == 0) {
-			writenode = true;
-		}
-
-		rx = QRegExp("^Creating journal");
-		if (rx.indexIn(line) == 0) {
-			writenode = false;
-			emit sigTimer(90,
-				      QString(tr
-					      ("Writing superblocks and filesystem.")),
-				      QString::null);
-		}
-
-		if (writenode) {
-			QString linesub = line;
-
-#ifdef QT30COMPATIBILITY
-			linesub.replace(QRegExp("\b"), " ");
-#else
-			linesub.replace(QChar('\b'), " ");
-#endif
-			rx = QRegExp("^.* (\\d*)/(\\d*) .*$");
-			if (rx.indexIn(linesub) == 0) {
-				QString capActual = rx.cap(1);
-				QString capTotal = rx.cap(2);
-
-				bool rc;
-				int iActual = capActual.toInt(&rc);
-				int iTotal = capTotal.toInt(&rc);
-
-				int iPerc = iActual * 80 / iTotal;	//The percentual is calculated in 80% ;)
-				emit sigTimer(iPerc,
-					      QString(tr
-						      ("Writing inode tables.")),
-					      QString::null);
-			}
-		}
+	while ((cline = fs_getline()))
+		if (parser.parse(cline, &match) && (match.event == ToolFailure))
+			_message = match.text;
 
-		rx = QRegExp("^Writing superblocks and filesystem accounting information: done");
-		if (rx.indexIn(line) == 0)
-			success = true;
-	}
-	fs_close();
+	/*---mkfs.btrfs has no "done" line: its exit status tell---*/
+	bool success = (fs_close() == 0);
 
-	if (!success)
+	if (!success && _message.isEmpty())
 		_message = QString(tr("There was a problem with mkfs.btrfs."));
 
 	return success;
@@ -1011,37 +837,24 @@ QString QP_FSBtrFS::_get_label(PedPartition * p)
 QP_FSXfs::QP_FSXfs():QP_FSWrap()
 {
 	/*---check if the wrapper is installed---*/
-	QString cmdline = "which " + lstExternalTools->getPath("mkfs.xfs");
-	fs_open(cmdline);
-
-	char *cline;
-	while ((cline = fs_getline()))
+	if (lstExternalTools->available("mkfs.xfs"))
 		wrap_create = true;
-	fs_close();
-
 
 	/*---check if the wrapper is installed---*/
-	cmdline = "which " + lstExternalTools->getPath("xfs_growfs");
-	fs_open(cmdline);
-
-	while ((cline = fs_getline()))
+	if (lstExternalTools->available("xfs_growfs"))
 		wrap_resize = Enlarge;
-	fs_close();
 }
 
 bool QP_FSXfs::mkpartfs(QString dev, QString label)
 {
-	QString cmdline;
-
 	/*---init of the error message---*/
 	_message = QString::null;
 
 	/*---prepare the command line---*/
-	if (label.isEmpty())
-		cmdline = " -f " + dev;
-	else
-		cmdline = " -f -L " + label + " " + dev;
-	cmdline = lstExternalTools->getPath("mkfs.xfs") + cmdline;
+	QStringList cmdline = QStringList() << lstExternalTools->getPath("mkfs.xfs") << "-f";
+	if (!label.isEmpty())
+		cmdline << "-L" << label;
+	cmdline << dev;
 
 	if (!fs_open(cmdline)) {
 		_message = QString(NOTFOUND);
@@ -1049,15 +862,12 @@ bool QP_FSXfs::mkpartfs(QString dev, QString label)
 	}
 
 	bool success = false;
+	QP_ToolParser parser("mkfs.xfs");
+	QP_ToolMatch match;
 	char *cline;
-	while ((cline = fs_getline())) {
-		QString line = QString(cline);
-
-		QRegExp rx;
-		rx = QRegExp("^realtime =.*");
-		if (rx.indexIn(line) == 0)
+	while ((cline = fs_getline()))
+		if (parser.parse(cline, &match) && (match.event == ToolSuccess))
 			success = true;
-	}
 	fs_close();
 
 	if (!success)
@@ -1136,13 +946,18 @@ bool QP_FSXfs::resize(QP_LibParted * _libparted, bool write,
 
 bool QP_FSXfs::xfsresize(bool write, QP_PartInfo * partinfo, PedSector)
 {
-	QString cmdline;
+	QStringList cmdline;
 
 	bool error = false;
 
 	if (!write)
 		return true;
 
+	/*---never wait for mountMutex holding libparted: who has it may want
+	 *   libparted back after a line of its tool (see QP_PedLock)---*/
+	QP_PedUnlock unlock;
+	QMutexLocker locker(&mountMutex);
+
 	/*---init of the error message---*/
 	_message = QString::null;
 
@@ -1150,24 +965,20 @@ bool QP_FSXfs::xfsresize(bool write, QP_PartInfo * partinfo, PedSector)
 		return false;
 
 	/*---do the resize!---*/
-	cmdline = lstExternalTools->getPath("xfs_growfs") + " " + TMP_MOUNTPOINT;
+	cmdline = QStringList() << lstExternalTools->getPath("xfs_growfs") << TMP_MOUNTPOINT;
 
-	if (!fs_open(cmdline)) {
+	if (!fs_open(cmdline, false, false)) {
 		_message = QString(NOTFOUND);
 		return false;
 	}
 
 	error = true;
+	QP_ToolParser parser("xfs_growfs");
+	QP_ToolMatch match;
 	char *cline;
-	while ((cline = fs_getline())) {
-		QString line = QString(cline);
-
-		QRegExp rx;
-		rx = QRegExp("^realtime =.*");
-		if (rx.indexIn(line) == 0) {
+	while ((cline = fs_getline()))
+		if (parser.parse(cline, &match) && (match.event == ToolSuccess))
 			error = false;
-		}
-	}
 	fs_close();
 
 	if (error) {
@@ -1205,30 +1016,23 @@ QString QP_FSXfs::_get_label(PedPartition * part)
 /*---FAT WRAPPER---------------------------------------------------------------*/
 QP_FSFat::QP_FSFat(QString bitflag):QP_FSWrap(),_bitflag(bitflag) {
 	/*---check if the wrapper is installed---*/
-	QString cmdline = "which " + lstExternalTools->getPath("mkdosfs");
-	fs_open(cmdline);
-
-	char *cline;
-	while ((cline = fs_getline()))
+	if (lstExternalTools->available("mkdosfs"))
 		wrap_create = true;
-	fs_close();
 }
 
 bool QP_FSFat::mkpartfs(QString dev, QString label)
 {
-	QString cmdline;
 	_message = QString::null;
+	QStringList cmdline = QStringList() << lstExternalTools->getPath("mkdosfs");
 	if (!label.isEmpty())
-		cmdline += " -n " + label;
-	cmdline += _bitflag;
-	cmdline = lstExternalTools->getPath("mkdosfs") + cmdline + " " + dev;
+		cmdline << "-n" << label;
+	cmdline << _bitflag.split(' ', QString::SkipEmptyParts) << dev;
 	if (!fs_open(cmdline)) {
 		_message = QString(NOTFOUND);
 		return false;
 	}
-	char *cline;
-	while ((cline = fs_getline()))
-		QString line=QString(cline);
+	while (fs_getline())
+		;
 	return (fs_close() == 0);
 }
 
@@ -1253,6 +1057,183 @@ QString QP_FSFat::_get_label(PedPartition * part)
 	return QString(label);
 }
 
+/*---free cluster counting: a FAT32 table of a 2TB volume is ~256MB, so the
+ *   inner loop must go at memory speed. The AVX2/SSE2 versions compare 32/16
+ *   bytes at time (see bench/fatcount)---*/
+static uint64_t fat_count_scalar(const uint8_t *t, uint64_t n, int bits)
+{
+	uint64_t count = 0;
+
+	if (bits == 16) {
+		for (uint64_t i = 0; i < n; i++)
+			if (NTFS_GETU16(t + i * 2) == 0)
+				count++;
+	} else {
+		for (uint64_t i = 0; i < n; i++)
+			if ((NTFS_GETU32(t + i * 4) & 0x0FFFFFFF) == 0)
+				count++;
+	}
+
+	return count;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/*---the zero entries are counted in the lanes of a vector (a compare give -1
+ *   for a match): __builtin_popcount without the popcnt instruction is a
+ *   call, slower than the scalar loop. The lanes are added up every
+ *   FAT_COUNT_FLUSH vectors, before a 16 bit one can overflow---*/
+#define FAT_COUNT_FLUSH 32767
+
+__attribute__((target("sse2")))
+static uint64_t fat_count_sse2_sum(__m128i acc, int bits)
+{
+	uint32_t lanes[4];
+
+	/*---16 bit lanes: pairs added in 32 bit lanes---*/
+	if (bits == 16)
+		acc = _mm_madd_epi16(acc, _mm_set1_epi16(1));
+	_mm_storeu_si128((__m128i *)lanes, acc);
+
+	return (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+__attribute__((target("sse2")))
+static uint64_t fat_count_sse2(const uint8_t *t, uint64_t n, int bits)
+{
+	const uint64_t perVector = 16 / (bits / 8);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i mask32 = _mm_set1_epi32(0x0FFFFFFF);
+	__m128i acc = _mm_setzero_si128();
+	uint64_t count = 0;
+	uint64_t i = 0;
+	int k = 0;
+
+	for (; i + perVector <= n; i += perVector) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(t + i * (bits / 8)));
+
+		if (bits == 16)
+			acc = _mm_sub_epi16(acc, _mm_cmpeq_epi16(v, zero));
+		else
+			acc = _mm_sub_epi32(acc, _mm_cmpeq_epi32(_mm_and_si128(v, mask32), zero));
+
+		if (++k == FAT_COUNT_FLUSH) {
+			count += fat_count_sse2_sum(acc, bits);
+			acc = _mm_setzero_si128();
+			k = 0;
+		}
+	}
+	count += fat_count_sse2_sum(acc, bits);
+
+	return count + fat_count_scalar(t + i * (bits / 8), n - i, bits);
+}
+
+__attribute__((target("avx2")))
+static uint64_t fat_count_avx2_sum(__m256i acc, int bits)
+{
+	uint32_t lanes[8];
+	uint64_t sum = 0;
+
+	if (bits == 16)
+		acc = _mm256_madd_epi16(acc, _mm256_set1_epi16(1));
+	_mm256_storeu_si256((__m256i *)lanes, acc);
+
+	for (int l = 0; l < 8; l++)
+		sum += lanes[l];
+
+	return sum;
+}
+
+__attribute__((target("avx2")))
+static uint64_t fat_count_avx2(const uint8_t *t, uint64_t n, int bits)
+{
+	const uint64_t perVector = 32 / (bits / 8);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i mask32 = _mm256_set1_epi32(0x0FFFFFFF);
+	__m256i acc = _mm256_setzero_si256();
+	uint64_t count = 0;
+	uint64_t i = 0;
+	int k = 0;
+
+	for (; i + perVector <= n; i += perVector) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(t + i * (bits / 8)));
+
+		if (bits == 16)
+			acc = _mm256_sub_epi16(acc, _mm256_cmpeq_epi16(v, zero));
+		else
+			acc = _mm256_sub_epi32(acc, _mm256_cmpeq_epi32(_mm256_and_si256(v, mask32), zero));
+
+		if (++k == FAT_COUNT_FLUSH) {
+			count += fat_count_avx2_sum(acc, bits);
+			acc = _mm256_setzero_si256();
+			k = 0;
+		}
+	}
+	count += fat_count_avx2_sum(acc, bits);
+
+	return count + fat_count_scalar(t + i * (bits / 8), n - i, bits);
+}
+#endif
+
+typedef uint64_t (*fat_count_fn)(const uint8_t *, uint64_t, int);
+
+/*---pick the best version for this cpu, only once---*/
+static fat_count_fn fat_count_select(const char **name)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		*name = "avx2";
+		return fat_count_avx2;
+	}
+	if (__builtin_cpu_supports("sse2")) {
+		*name = "sse2";
+		return fat_count_sse2;
+	}
+#endif
+	*name = "scalar";
+	return fat_count_scalar;
+}
+
+static const char *fat_count_name;
+static const fat_count_fn fat_count = fat_count_select(&fat_count_name);
+
+uint64_t QP_FSFat::count_free_clusters(const uint8_t *table, uint64_t entries, int bits)
+{
+	if ((bits != 16) && (bits != 32))
+		return 0;
+
+	return fat_count(table, entries, bits);
+}
+
+const char *QP_FSFat::count_free_clusters_impl()
+{
+	return fat_count_name;
+}
+
+bool QP_FSFat::count_free_clusters(const uint8_t *table, uint64_t entries, int bits,
+				   const char *impl, uint64_t *count)
+{
+	fat_count_fn fn = NULL;
+
+	if ((bits != 16) && (bits != 32))
+		return false;
+
+	if (!strcmp(impl, "scalar"))
+		fn = fat_count_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+	else if (!strcmp(impl, "sse2") && __builtin_cpu_supports("sse2"))
+		fn = fat_count_sse2;
+	else if (!strcmp(impl, "avx2") && __builtin_cpu_supports("avx2"))
+		fn = fat_count_avx2;
+#endif
+
+	if (!fn)
+		return false;
+
+	*count = fn(table, entries, bits);
+	return true;
+}
+
 /*---REISERFS WRAPPER------------------------------------------------------------*/
 QString QP_FSReiserFS::_get_label(PedPartition *)
 {
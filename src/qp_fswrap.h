@@ -34,6 +34,7 @@
 #include <stdarg.h>
 #include <qobject.h>
 #include "qp_libparted.h"
+#include "qp_process.h"
 
 #define swab16(x) ((uint16_t)( (((uint16_t)(x) & (uint16_t)0x00ffU) << 8) | (((uint16_t)(x) & (uint16_t)0xff00U) >> 8) ))
 
@@ -135,6 +136,9 @@ public:
 	/*---return a string with the latest error---*/
 	virtual QString message() {return _message;}
 
+	/*---stop the tool running (but not one that write in place) when it is not 0---*/
+	void setCancel(const QAtomicInt *);
+
 	/*---return the name of the filesystem---*/
 	virtual QString fsname() {return QString::null;}
 	
@@ -159,15 +163,16 @@ public:
 protected:
 	bool qpMount(QString device);
 	bool qpUMount(QString device);
-	bool fs_open(QString cmdline, bool localized=false);
+	bool fs_open(QStringList args, bool localized=false, bool cancelable=true, int timeout=0);
 	char *fs_getline();
 	int fs_close();
 	QString _message;
 	PedSector _min_size;
 
 private:
-	char line[255];
-	FILE *fp;
+	QP_Process _process;
+	QByteArray _line;
+	const QAtomicInt *_cancel = NULL;
 
 signals:
 	/*---emitted when there is need to update a progress bar---*/
@@ -262,6 +267,14 @@ public:
 	QP_FSFat(QString bitflag=QString::null);
 	bool mkpartfs(QString dev, QString label);
 	static QString _get_label(PedPartition *);
+
+	/*---count the free (zero) entries of a FAT16/FAT32 table---*/
+	static uint64_t count_free_clusters(const uint8_t *table, uint64_t entries, int bits);
+	static const char *count_free_clusters_impl();
+	/*---the same with one implementation ("scalar", "sse2", "avx2"), see
+	 *   bench/fatcount: false if the cpu doesn't have it---*/
+	static bool count_free_clusters(const uint8_t *table, uint64_t entries, int bits,
+					const char *impl, uint64_t *count);
 protected:
 	QString	_bitflag;
 };
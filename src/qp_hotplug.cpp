@@ -0,0 +1,131 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <QDir>
+#include "qp_hotplug.h"
+#include "qp_devlist.h"
+#include "qp_debug.h"
+
+#define UEVENT_BUFFER 8192
+
+QP_HotPlug::QP_HotPlug(QObject *parent) : QObject(parent) {
+	_socket = -1;
+	_notifier = NULL;
+
+	connect(&_rescan, SIGNAL(timeout()), this, SLOT(slotRescan()));
+}
+
+QP_HotPlug::~QP_HotPlug() {
+	delete _notifier;
+	if (_socket >= 0)
+		close(_socket);
+}
+
+void QP_HotPlug::start(QStringList known) {
+	_known = known;
+
+	/*---the devices are found in sysfs: without it there is nothing to compare---*/
+	if (!QDir(SYSBLOCK_DIR).exists()) {
+		showDebug("%s", "hotplug::start, no sysfs\n");
+		return;
+	}
+
+	struct sockaddr_nl addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.nl_family = AF_NETLINK;
+	addr.nl_pid = 0;		/*---the kernel choose it---*/
+	addr.nl_groups = 1;		/*---the events of the kernel, not of udev---*/
+
+	_socket = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+	if (_socket < 0)
+		goto poll;
+
+	if (bind(_socket, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+		close(_socket);
+		_socket = -1;
+		goto poll;
+	}
+
+	_notifier = new QSocketNotifier(_socket, QSocketNotifier::Read, this);
+	connect(_notifier, SIGNAL(activated(int)), this, SLOT(slotUevent()));
+
+	_rescan.setSingleShot(true);
+	showDebug("%s", "hotplug::start, listening to uevents\n");
+	return;
+
+poll:
+	showDebug("hotplug::start, no uevent socket (%s): reading sysfs every %d msecs\n",
+		  strerror(errno), HOTPLUG_POLL);
+	_rescan.setSingleShot(false);
+	_rescan.start(HOTPLUG_POLL);
+}
+
+/*---an uevent is "ACTION@DEVPATH" and then "KEY=VALUE" strings, all ended by \0---*/
+void QP_HotPlug::slotUevent() {
+	char buffer[UEVENT_BUFFER];
+	ssize_t len;
+
+	while ((len = recv(_socket, buffer, sizeof(buffer) - 1, 0)) > 0) {
+		buffer[len] = '\0';
+
+		bool block = false;
+		bool disk = false;
+
+		for (char *p = buffer; p < buffer + len; p += strlen(p) + 1) {
+			if (!strcmp(p, "SUBSYSTEM=block"))
+				block = true;
+			else if (!strcmp(p, "DEVTYPE=disk"))
+				disk = true;
+		}
+
+		/*---partitions are read by the scan of their disk---*/
+		if (block && disk) {
+			showDebug("hotplug::slotUevent, %s\n", buffer);
+			_rescan.start(HOTPLUG_SETTLE);
+		}
+	}
+}
+
+void QP_HotPlug::slotRescan() {
+	QStringList now = QP_DevList::discover();
+
+	for (const QString &path : now) {
+		if (!_known.contains(path)) {
+			showTrace("hotplug::slotRescan, %s added\n", path.toLatin1().data());
+			emit sigAdded(path);
+		}
+	}
+
+	for (const QString &path : _known) {
+		if (!now.contains(path)) {
+			showTrace("hotplug::slotRescan, %s removed\n", path.toLatin1().data());
+			emit sigRemoved(path);
+		}
+	}
+
+	_known = now;
+}
@@ -0,0 +1,73 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+/* About QP_HotPlug class:
+ *
+ * Tell when a disk is plugged in or unplugged, so QP_DriveList can add or
+ * remove just that device.
+ *
+ * It listen to the uevents of the kernel (a NETLINK_KOBJECT_UEVENT socket).
+ * An event of a block device only start a short timer: then the disks in
+ * sysfs (QP_DevList::discover) are compared with the ones known, and a
+ * signal is emitted for every difference. A loop device attached or detached
+ * with losetup only send a "change" (its size go from 0 to something, or
+ * back), and it is catched the same way.
+ *
+ * Without the socket (no netlink in the kernel, a sandbox...) sysfs is just
+ * read every HOTPLUG_POLL msecs.
+ */
+
+#ifndef QP_HOTPLUG_H
+#define QP_HOTPLUG_H
+
+#include <QObject>
+#include <QSocketNotifier>
+#include <QStringList>
+#include <QTimer>
+
+#define HOTPLUG_SETTLE 250	/*---msecs after an uevent, for the device node---*/
+#define HOTPLUG_POLL   2000	/*---msecs between two reads of sysfs         ---*/
+
+class QP_HotPlug : public QObject {
+	Q_OBJECT
+
+public:
+	QP_HotPlug(QObject *parent = NULL);
+	~QP_HotPlug();
+	void start(QStringList);	/*---the devices already known---*/
+
+signals:
+	void sigAdded(QString);		/*---the path of a new device    ---*/
+	void sigRemoved(QString);	/*---the path of a device gone   ---*/
+
+private slots:
+	void slotUevent();
+	void slotRescan();
+
+private:
+	int _socket;
+	QSocketNotifier *_notifier;
+	QTimer _rescan;
+	QStringList _known;
+};
+
+#endif
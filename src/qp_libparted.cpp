@@ -20,13 +20,16 @@
 */
 
 #include <sys/mount.h>
-#include <qmessagebox.h>
 #include <stdlib.h>
 #include <qapplication.h>
+#include <QMutexLocker>
 #include "qp_libparted.h"
 #include "qp_filesystem.h"
 #include "qp_fswrap.h"
 #include "qp_actlist.h"
+#include "qp_blockcopy.h"
+#include "qp_fsstats.h"
+#include "qp_pedlock.h"
 #include "qp_common.h"
 #include "qp_debug.h"
 
@@ -300,6 +303,33 @@ bool QP_PartInfo::move ( PedSector new_start, PedSector new_end )
 	return rc;
 }
 
+bool QP_PartInfo::copy ( QTParted::partType type, PedSector start )
+{
+	showDebug ( "%s", "partinfo::copy\n" );
+
+	/*---the data of a virtual partition is not on the disk yet---*/
+	if ( isVirtual() )
+	{
+		_libparted->_message = QString ( tr ( "This is a virtual partition. You cannot alter it: use undo instead." ) );
+		return false;
+	}
+
+	bool rc = _libparted->copy ( this, type, start );
+
+	if ( !rc )
+	{
+		showDebug ( "%s", "qp_partinfo::copy ko\n" );
+		_libparted->emitSigTimer ( 100, _libparted->message(), QString::null );
+	}
+	else
+	{
+		showDebug ( "%s", "qp_partinfo::copy ok\n" );
+		_libparted->emitSigTimer ( 100, SUCCESS, QString::null );
+	}
+
+	return rc;
+}
+
 bool QP_PartInfo::partition_is_busy()
 {
 	showDebug ( "%s", "partinfo::partition_is_busy\n" );
@@ -381,18 +411,6 @@ QString QP_PartInfo::label()
 /*-begin of QP_LibParted-------------------------------------------------------------------------*/
 
 
-/*structur used for the update of the "time left" on progress bar*/
-
-typedef struct
-{
-	time_t	last_update;
-	time_t	predicted_time_left;
-	QP_LibParted *libparted;
-} TimerContext;
-
-static PedTimer *timer;
-static TimerContext timer_context;
-
 //function called by libparted. 'Cause libparted is write in C you cannot use a method!
 void _timer_handler ( PedTimer *timer, void *context )
 {
@@ -430,6 +448,11 @@ QP_LibParted::QP_LibParted()
 {
 	showDebug ( "%s", "libparted::libparted\n" );
 
+	/*---the reports of the timer and of the wrappers are sent from here---*/
+	_progress = new QP_Progress ( this );
+	connect ( _progress, SIGNAL ( sigTimer ( int, QString, QString ) ),
+			  this, SIGNAL ( sigTimer ( int, QString, QString ) ) );
+
 	/*---get all filesystem supported by libparted---*/
 	filesystem = new QP_FileSystem();
 	get_filesystem ( filesystem );
@@ -467,9 +490,16 @@ QP_LibParted::~QP_LibParted()
 	showDebug ( "%s", "destroy filesystem wrapper\n" );
 	delete filesystem;
 
+	/*---the startup scan make and destroy one for every device---*/
+	if ( actlist ) delete actlist;
+
 //	if (disk) ped_disk_destroy(disk);
 
-	if ( dev ) ped_device_destroy ( dev );
+	if ( dev )
+	{
+		QMutexLocker locker ( QP_DevList::pedListMutex() );
+		ped_device_destroy ( dev );
+	}
 }
 
 
@@ -494,7 +524,9 @@ void QP_LibParted::setDevice ( QP_Device *device )
 
 	char const * const szdevice = strdup(device->shortname().toLatin1().data());
 
+	QP_DevList::pedListMutex()->lock();
 	dev = ped_device_get ( szdevice );
+	QP_DevList::pedListMutex()->unlock();
 
 	free(const_cast<char*>(szdevice));
 
@@ -631,7 +663,9 @@ qtp_DriveInfo QP_LibParted::device_info ( QString strdev )
 	showDebug ( "%s", "libparted::device_info\n" );
 	qtp_DriveInfo driveinfo;
 
+	QP_DevList::pedListMutex()->lock();
 	PedDevice *dev = ped_device_get ( ( const char * ) strdev.toLatin1() );
+	QP_DevList::pedListMutex()->unlock();
 
 	long double length = ( dev->length * ( dev->sector_size / 1024.0 ) ) / 1024.0;
 
@@ -659,7 +693,7 @@ bool QP_LibParted::checkForParted()
 	{
 	printf ( "Cannot get parted version\n" );
 	QString label = QString ( QObject::tr ( "Cannot get parted version." ) );
-	QMessageBox::information ( 0, "QtParted", label );
+	showMessage ( label );
 	showDebug ( "%s", "Cannot get parted version\n" );
 
 		return false;
@@ -670,7 +704,7 @@ bool QP_LibParted::checkForParted()
 	if(sscanf(version, "%d.%d", &major, &minor) != 2) {
 		minor = 0;
 		if(sscanf(version, "%d", &major) != 1) {
-			QMessageBox::information(0, "QtParted", tr("Can't identify parted version; claims to be %1").arg(version));
+			showMessage(tr("Can't identify parted version; claims to be %1").arg(version));
 			return false;
 		}
 	}
@@ -697,7 +731,7 @@ bool QP_LibParted::checkForParted()
 						.arg ( major ) .arg ( minor ) .arg ( micro )
 						.arg ( PARTED_REQUESTED_MAJOR ) .arg ( PARTED_REQUESTED_MINOR ) .arg ( PARTED_REQUESTED_MICRO );
 		showDebug ( "%s", label.toStdString().c_str() );
-		QMessageBox::information ( NULL, "QtParted", label );
+		showMessage ( label );
 		return false;
 	}
 }
@@ -732,6 +766,7 @@ void QP_LibParted::get_filesystem ( QP_FileSystem *filesystem )
 					  fsw->wrap_resize,
 					  fsw->wrap_move,
 					  fsw->wrap_copy);
+			delete fsw;
 		}
 	}
 #endif
@@ -743,8 +778,12 @@ void QP_LibParted::get_filesystem ( QP_FileSystem *filesystem )
 	{
 		//for (p = (QP_FSWrap *)filesystem->fswraplist.first(); p; p = (QP_FSWrap *)filesystem->fswraplist.next()) {
 		p = filesystem->fswraplist.at ( idx );
-		connect ( p, SIGNAL ( sigTimer ( int, QString, QString ) ),
-				  this, SIGNAL ( sigTimer ( int, QString, QString ) ) );
+		/*---direct: the wrapper run in the commit thread, and the report
+		 *   must not be queued line by line to this one---*/
+		connect ( p, &QP_FSWrap::sigTimer, _progress, &QP_Progress::report, Qt::DirectConnection );
+
+		/*---and the "Cancel" of the commit stop its tools---*/
+		p->setCancel ( &_cancel );
 	}
 }
 
@@ -1652,7 +1691,9 @@ bool QP_LibParted::move ( QP_PartInfo *partinfo, PedSector start, PedSector end
 
 	constraint = ped_file_system_get_copy_constraint ( fs, dev );
 #else
-	constraint = ped_constraint_any ( dev );
+	/*---the data is copied block by block: the new place must be exactly as big
+	 *   as the old one, libparted must not align (and shrink) it---*/
+	constraint = NULL;
 #endif
 
 	/* set / test on "disk" */
@@ -1663,6 +1704,16 @@ bool QP_LibParted::move ( QP_PartInfo *partinfo, PedSector start, PedSector end
 		goto error_destroy_constraint;
 	}
 
+	if ( !constraint )
+		constraint = ped_constraint_exact ( &new_geom );
+
+	if ( !constraint || ( new_geom.length != old_geom.length ) )
+	{
+		showDebug ( "%s", "libparted::move, the size would change\n" );
+		_message = QString ( tr ( "The partition must keep its size when it is moved." ) );
+		goto error_destroy_constraint;
+	}
+
 	/*TODO
 	if (!_grow_over_small_freespace (&new_geom, disk))
 		goto error_destroy_constraint;*/
@@ -1675,12 +1726,21 @@ bool QP_LibParted::move ( QP_PartInfo *partinfo, PedSector start, PedSector end
 
 	ped_constraint_destroy ( constraint );
 
+	if ( part->geom.length != old_geom.length )
+	{
+		showDebug ( "%s", "libparted::move, the size has changed\n" );
+		_message = QString ( tr ( "The partition must keep its size when it is moved." ) );
+		goto error_close_fs;
+	}
+
+#ifdef USE_PARTED2_FS_SUPPORT // QP_BlockCopy can move a partition over itself
 	if ( ped_geometry_test_overlap ( &old_geom, &part->geom ) )
 	{
 		showDebug ( "%s", "libparted::move, test_overlap ko\n" );
 		_message = QString ( tr ( "Can't move a partition onto itself. Try using resize, perhaps?" ) );
 		goto error_close_fs;
 	}
+#endif
 
 	/*TODO
 	if (!_solution_check_distant (start, end, part->geom.start, part->geom.end,
@@ -1705,7 +1765,35 @@ bool QP_LibParted::move ( QP_PartInfo *partinfo, PedSector start, PedSector end
 
 		ped_file_system_close ( fs_copy );
 #else
-	showDebug ( "%s", "Move wrapper not used, this shouldn't happen\n" );
+		showDebug ( "%s", "libparted::move, want to move the data\n" );
+		QP_Settings *settings = _qpdevice->settings();
+		QP_BlockCopy blockcopy ( dev, settings->copyQueueDepth(), settings->copyBlockSize() * 1024 );
+
+		/*---the table still point to the old place: a move can stop in the middle
+		 *   only if it doesn't overwrite its own data---*/
+		if ( !ped_geometry_test_overlap ( &old_geom, &part->geom ) )
+			blockcopy.setCancel ( &_cancel );
+
+		/*---move only the blocks the filesystem use, if we can read its bitmaps---*/
+		QP_FSStats stats ( dev->path, old_geom.start, old_geom.end );
+		QVector<QP_Extent> used;
+		bool sparse = stats.extents ( partinfo->fsspec->name(), &used );
+
+		bool copied;
+		{
+			/*---the data don't go through libparted: the other commits can use it---*/
+			QP_PedUnlock unlock;
+			copied = blockcopy.copy ( old_geom.start, part->geom.start,
+									  old_geom.length, timer,
+									  sparse ? &used : NULL );
+		}
+
+		if ( !copied )
+		{
+			showDebug ( "%s", "libparted::move, blockcopy ko\n" );
+			_message = QString ( tr ( "Error moving the partition data: %1" ) ).arg ( blockcopy.message() );
+			goto error_close_fs;
+		}
 #endif
 	}
 
@@ -1737,7 +1825,8 @@ bool QP_LibParted::move ( QP_PartInfo *partinfo, PedSector start, PedSector end
 	return true;
 
 error_destroy_constraint:
-	ped_constraint_destroy ( constraint );
+	if ( constraint )
+		ped_constraint_destroy ( constraint );
 
 error_close_fs:
 #ifdef USE_PARTED2_FS_SUPPORT // Filesystem support was removed from parted 3.x
@@ -1748,6 +1837,154 @@ error:
 	return false;
 }
 
+bool QP_LibParted::copy ( int num, QTParted::partType type, PedSector start )
+{
+	showDebug ( "%s", "libparted::copy(num)\n" );
+
+	/*---scan to find the partinfo to copy---*/
+	QP_PartInfo *partinfo = numToPartInfo ( num );
+
+	if ( partinfo )
+	{
+		return partinfo->copy ( type, start );
+	}
+	else
+	{
+		showDebug ( "%s", "libparted::copy(num), numtopartinfo ko\n" );
+		_message = QString ( tr ( "A bug was found in QTParted during \"copy\" scan, please report it!" ) );
+		return false;
+	}
+}
+
+/*---make a new partition of the same size (and filesystem id) of "partinfo"
+ *   at "start", and copy into it the blocks the source filesystem use---*/
+bool QP_LibParted::copy ( QP_PartInfo *partinfo, QTParted::partType type, PedSector start )
+{
+	showDebug ( "%s", "libparted::copy(partinfo)\n" );
+
+	PedPartition *source;
+	PedPartition *part;
+	PedGeometry source_geom;
+	PedGeometry part_geom;
+	PedPartitionType part_type;
+	PedConstraint *constraint;
+	PedSector end;
+
+	_message = QString::null;
+
+	if ( ( partinfo->type == QTParted::extended ) || ( type == QTParted::extended ) )
+	{
+		_message = QString ( tr ( "Can't copy extended partitions." ) );
+		goto error;
+	}
+
+	/*---get the partition info---*/
+	source = ped_disk_get_partition ( actlist->disk(), partinfo->num );
+
+	if ( !source )
+	{
+		showDebug ( "%s", "libparted::copy, get_partition ko\n" );
+		_message = QString ( ERROR_PED_DISK_GET_PARTITION );
+		goto error;
+	}
+
+	/*---a mounted filesystem change while it is copied---*/
+	if ( !_partition_warn_busy ( source ) )
+	{
+		showDebug ( "%s", "libparted::copy, warn_busy ko\n" );
+		goto error;
+	}
+
+	source_geom = source->geom;
+	end = start + source_geom.length - 1;
+	part_type = type2parttype ( type );
+
+	part = ped_partition_new ( actlist->disk(), part_type, source->fs_type, start, end );
+
+	if ( !part )
+	{
+		showDebug ( "%s", "libparted::copy, ped_partition_new ko\n" );
+		_message = QString ( ERROR_PED_PARTITION_NEW );
+		goto error;
+	}
+
+	/*---the copy must be exactly as big as the source: no alignment here---*/
+	constraint = ped_constraint_exact ( &part->geom );
+
+	if ( !constraint )
+	{
+		showDebug ( "%s", "libparted::copy, ped_constraint_exact ko\n" );
+		goto error_destroy_part;
+	}
+
+	if ( !ped_disk_add_partition ( actlist->disk(), part, constraint ) )
+	{
+		showDebug ( "%s", "libparted::copy, add_partition ko\n" );
+		_message = QString ( ERROR_PED_DISK_ADD_PARTITION );
+		goto error_destroy_constraint;
+	}
+
+	ped_constraint_destroy ( constraint );
+
+	part_geom = part->geom;
+
+	if ( _write )
+	{
+		showDebug ( "%s", "libparted::copy, want to copy the data\n" );
+
+		/*---the data first, like move: if the copy fail (or it is canceled)
+		 *   the table doesn't point to a half copied filesystem---*/
+		QP_Settings *settings = _qpdevice->settings();
+		QP_BlockCopy blockcopy ( dev, settings->copyQueueDepth(), settings->copyBlockSize() * 1024 );
+		blockcopy.setCancel ( &_cancel );
+
+		/*---the free space of the source is skipped (or punched in an image)---*/
+		QP_FSStats stats ( dev->path, source_geom.start, source_geom.end );
+		QVector<QP_Extent> used;
+		bool sparse = stats.extents ( partinfo->fsspec->name(), &used );
+
+		bool copied;
+		{
+			/*---the data don't go through libparted: the other commits can use it---*/
+			QP_PedUnlock unlock;
+			copied = blockcopy.copy ( source_geom.start, part_geom.start, source_geom.length, timer,
+									  sparse ? &used : NULL );
+		}
+
+		if ( !copied )
+		{
+			showDebug ( "%s", "libparted::copy, blockcopy ko\n" );
+			_message = QString ( tr ( "Error copying the partition data: %1" ) ).arg ( blockcopy.message() );
+			goto error;
+		}
+
+		showDebug ( "%s", "libparted::copy, want to commit\n" );
+
+		if ( disk_commit ( actlist->disk() ) == 0 )
+		{
+			showDebug ( "%s", "libparted::copy, commit ko\n" );
+			goto error;
+		}
+	}
+	else
+	{
+		showDebug ( "%s", "libparted::copy, do in virtual actlist\n" );
+		showDebug ( "%s", "operation added to undo/commit list\n" );
+		actlist->ins_copy ( partinfo->num, type, start, end, partinfo->fsspec, part_geom, part_type );
+	}
+
+	return true;
+
+error_destroy_constraint:
+	ped_constraint_destroy ( constraint );
+
+error_destroy_part:
+	ped_partition_destroy ( part );
+
+error:
+	return false;
+}
+
 bool QP_LibParted::_test_move ( QP_PartInfo *partinfo, PedSector start, PedSector end )
 {
 	showDebug ( "%s", "libparted::_test_move\n" );
@@ -1802,7 +2039,9 @@ bool QP_LibParted::_test_move ( QP_PartInfo *partinfo, PedSector start, PedSecto
 
 	constraint = ped_file_system_get_copy_constraint ( fs, dev );
 #else
-	constraint = ped_constraint_any ( dev );
+	/*---the data is copied block by block: the new place must be exactly as big
+	 *   as the old one, libparted must not align (and shrink) it---*/
+	constraint = NULL;
 #endif
 
 	/* set / test on "disk" */
@@ -1813,6 +2052,16 @@ bool QP_LibParted::_test_move ( QP_PartInfo *partinfo, PedSector start, PedSecto
 		goto error_destroy_constraint;
 	}
 
+	if ( !constraint )
+		constraint = ped_constraint_exact ( &new_geom );
+
+	if ( !constraint || ( new_geom.length != old_geom.length ) )
+	{
+		showDebug ( "%s", "libparted::_test_move, the size would change\n" );
+		_message = QString ( tr ( "The partition must keep its size when it is moved." ) );
+		goto error_destroy_constraint;
+	}
+
 	/*TODO
 	if (!_grow_over_small_freespace (&new_geom, disk))
 		goto error_destroy_constraint;*/
@@ -1825,19 +2074,22 @@ bool QP_LibParted::_test_move ( QP_PartInfo *partinfo, PedSector start, PedSecto
 
 	ped_constraint_destroy ( constraint );
 
+#ifdef USE_PARTED2_FS_SUPPORT // QP_BlockCopy can move a partition over itself
 	if ( ped_geometry_test_overlap ( &old_geom, &part->geom ) )
 	{
 		showDebug ( "%s", "libparted::_test_move, _test_overlap ko\n" );
 		_message = QString ( tr ( "Can't move a partition onto itself. Try using resize, perhaps?" ) );
 		goto error_close_fs;
 	}
+#endif
 
 	ped_disk_destroy ( disk );
 
 	return true;
 
 error_destroy_constraint:
-	ped_constraint_destroy ( constraint );
+	if ( constraint )
+		ped_constraint_destroy ( constraint );
 
 error_close_fs:
 #ifdef USE_PARTED2_FS_SUPPORT // Filesystem support was removed from parted 3.x
@@ -2130,8 +2382,12 @@ QString QP_LibParted::message()
 
 void QP_LibParted::emitSigTimer ( int percent, QString state, QString timer )
 {
-	showDebug ( "%s", "libparted::emitSigTimer\n" );
-	emit sigTimer ( percent, state, timer );
+	_progress->report ( percent, state, timer );
+}
+
+QP_Progress *QP_LibParted::progress()
+{
+	return _progress;
 }
 
 void QP_LibParted::setWrite ( bool write )
@@ -2152,19 +2408,47 @@ bool QP_LibParted::canUndo()
 	return actlist->canUndo();
 }
 
+bool QP_LibParted::canRedo()
+{
+	showDebug ( "%s", "libparted::canRedo\n" );
+	return actlist->canRedo();
+}
+
 void QP_LibParted::undo()
 {
 	showDebug ( "%s", "libparted::undo\n" );
 	actlist->undo();
 }
 
+void QP_LibParted::redo()
+{
+	showDebug ( "%s", "libparted::redo\n" );
+	actlist->redo();
+}
+
 void QP_LibParted::commit()
 {
 	showDebug ( "%s", "libparted::commit\n" );
+	_cancel.store ( 0 );
+
+	/*---the commits of other devices can run now: libparted is called by one
+	 *   of them at a time (see QP_PedLock)---*/
+	QP_PedLock pedlock;
 	actlist->commit();
 	_qpdevice->commit();
 }
 
+void QP_LibParted::cancel()
+{
+	showDebug ( "%s", "libparted::cancel\n" );
+	_cancel.store ( 1 );
+}
+
+bool QP_LibParted::canceled()
+{
+	return _cancel.load() != 0;
+}
+
 float QP_LibParted::mb_hdsize()
 {
 	showDebug ( "%s", "libparted::mb_hdsize\n" );
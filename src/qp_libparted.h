@@ -28,18 +28,19 @@
 #ifndef QT_LIBPARTED_H
 #define QT_LIBPARTED_H
 
+#include <QAtomicInt>
 #include <QList>
 #include <QWidget>
 #include <parted/parted.h>
 #include "qparted.h"
 #include "qp_devlist.h"
+#include "qp_progress.h"
 
 #ifndef PED_SECTOR_SIZE
 #define PED_SECTOR_SIZE PED_SECTOR_SIZE_DEFAULT
 #endif
 
 class QP_PartWidget;
-class QP_ListViewItem;
 class QP_LibParted;
 class QP_ActionList;
 class QP_FileSystemSpec;
@@ -51,6 +52,7 @@ QString MB2String(float);
 class QP_PartInfo : public QObject {
 	friend class QP_LibParted;
 	friend class QP_ActionList;
+	friend class QP_ProbeCache;
 	Q_OBJECT
 public:
 	QP_PartInfo();
@@ -63,7 +65,6 @@ public:
 	PedSector end;
 	PedSector min_size;
 	QP_PartWidget *partwidget;
-	QP_ListViewItem *listviewitem;
 	int  width;
 	QP_Device *device();
 	void setDevice(QP_Device *);
@@ -86,6 +87,7 @@ public:
 	bool resize(PedSector, PedSector);		/*---resize the partition (start, end sectors	 ---*/
 	bool mkfs(QP_FileSystemSpec *, QString);/*---format the partition (filesystem, label)	 ---*/
 	bool move(PedSector, PedSector);		 /*---move the partition (start, end sectors		---*/
+	bool copy(QTParted::partType, PedSector); /*---copy the partition (type, start of the copy)---*/
 	bool partition_is_busy();					/*---test if the partition is busy (ie mounted)	---*/
 	bool set_system(QP_FileSystemSpec *);	/*---change the systemid of the partition			---*/
 	bool fswrap();
@@ -111,6 +113,14 @@ private:
 	QString _mountPoint;						 /*---mountpoint of the partition						---*/
 };
 
+/*structur used for the update of the "time left" on progress bar*/
+typedef struct
+{
+	time_t	last_update;
+	time_t	predicted_time_left;
+	QP_LibParted *libparted;
+} TimerContext;
+
 class qtp_DriveInfo {
 public:
 	QString device;
@@ -160,17 +170,24 @@ public:
 	void setFastScan(bool);	/*---make the scan of filesystems fast!		 ---*/
 	bool move(int, PedSector, PedSector);
 	bool move(QP_PartInfo *, PedSector, PedSector);
+	bool copy(int, QTParted::partType, PedSector);
+	bool copy(QP_PartInfo *, QTParted::partType, PedSector);
 	bool resize(int, PedSector, PedSector);
 	bool resize(QP_PartInfo *, PedSector, PedSector);
 	PedGeometry get_geometry(QP_PartInfo *);
 	bool set_geometry(QP_PartInfo *, PedSector, PedSector);
 	QString message();
-	void emitSigTimer(int, QString, QString);
+	void emitSigTimer(int, QString, QString);	/*---report to progress(): any thread---*/
+	QP_Progress *progress();	/*---the progress of the operation in progress---*/
 	void setWrite(bool);
 	bool write();
 	bool canUndo();
+	bool canRedo();
 	void undo();
+	void redo();
 	void commit();
+	void cancel();		/*---stop the commit: it can be called from any thread---*/
+	bool canceled();
 
 private:
 	bool _test_move(QP_PartInfo *, PedSector, PedSector);
@@ -184,9 +201,14 @@ private:
 	QString _message;
 	bool _write;
 	QP_ActionList *actlist;
+	PedTimer *timer;		/*---one for every device: they can be committed together---*/
+	TimerContext timer_context;
+	QAtomicInt _cancel;	/*---set by cancel, checked between the steps and by the copies---*/
+	QP_Progress *_progress;	/*---coalesce the reports into sigTimer---*/
 
 signals:
-	/*---emitted when there is need to update a progress bar---*/
+	/*---emitted when there is need to update a progress bar (by _progress, at most
+	 *   every PROGRESS_FRAME msecs, in the thread of QP_LibParted)---*/
 	void sigTimer(int, QString, QString);
 	void sigOperations(QString, QString, int, int);
 	void sigDiskChanged();
@@ -17,19 +17,24 @@
 	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
+#include <algorithm>
 #include <qpainter.h>
+#include <QElapsedTimer>
 
 #include "qp_libparted.h"
 #include "qp_listchart.h"
+#include "qp_debug.h"
 
 #define MIN_HDWIDTH		 190
 #define MIN_HDHEIGHT		 70
 #define MIN_PARTITION_WIDTH  16
+#define LAYOUT_CACHE		 256	/*---widths kept before the cache is emptied---*/
 
 class QP_ChartItem {
 public:
 	QP_PartWidget *partwidget;
 	QP_PartInfo *partinfo;
+	QP_ChartKey key;	/*---the partinfo can be gone when the chart is cleared---*/
 	int width;
 };
 
@@ -38,6 +43,11 @@ QP_ListChart::QP_ListChart(QWidget *parent, Qt::WindowFlags f)
 
 	/*---prevent a segfualt in ::clear method!---*/
 	_selPartInfo = NULL;
+	extpartinfo = NULL;
+
+	_computed = 0;
+	_cached = 0;
+	_nsecs = 0;
 
 	container = new QWidget(this);
 
@@ -49,6 +59,10 @@ QP_ListChart::~QP_ListChart() {
 }
 
 void QP_ListChart::setselPartInfo(QP_PartInfo *selpartinfo) {
+	/*---already selected: nothing to repaint---*/
+	if (selpartinfo == selPartInfo())
+		return;
+
 	/*---if a partition was selected remove the selection to it---*/
 	/*---please note that in ::clear() selPartInfo is "nulled!"---*/
 	if (selPartInfo() && selPartInfo()->partwidget) {
@@ -70,216 +84,293 @@ void QP_ListChart::setselPartInfo(QP_PartInfo *selpartinfo) {
 void QP_ListChart::clear() {
 	/*--just "unselect" a partition. This prevent segfault in setselpartinfo---*/
 	_selPartInfo = NULL;
-	
-	/*---destroy logical partition widgets attached---*/
-	QListIterator <QP_ChartItem*> it(logilist);
-	while(it.hasNext())
-	{
-		delete it.next()->partwidget;
-	}
 
-	/*---destroy primary/extended partition widgets attached---*/
-	QListIterator <QP_ChartItem *> partit(partlist);
-	while(partit.hasNext())
-	{
-		delete partit.next()->partwidget;
+	/*---the widgets of the scan before, if nobody took them---*/
+	dropSpare();
+
+	/*---how many paints were just a copy of the tile (see QP_PartWidget)---*/
+	int renders = 0;
+	int blits = 0;
+	qint64 nsecs = 0;
+
+	/*---keep the widgets (and their tiles) for the partitions of the next scan---*/
+	QList<QP_ChartItem*> items = logilist + partlist;
+	foreach(QP_ChartItem *item, items) {
+		QP_PartWidget *partwidget = item->partwidget;
+		renders += partwidget->renders();
+		blits += partwidget->blits();
+		nsecs += partwidget->nsecs();
+		partwidget->resetStatistics();
+		partwidget->hide();
+		_spare.insert(item->key, partwidget);
 	}
+
+	if (renders + blits)
+		showDebug("listchart::clear, %d tiles drawn, %d paints from a tile, %lld usecs painting\n",
+			  renders, blits, nsecs / 1000);
 	/*---clear the pointer list of partition  ---*/
 	/*---this is usefull to avoid memory leak!---*/
+	qDeleteAll(items);
 	logilist.clear();
 	partlist.clear();
+	extpartinfo = NULL;
+
+	/*---the layouts were for these partitions---*/
+	if (_computed)
+		showDebug("listchart::clear, %d layouts computed in %lld usecs, %d taken from the cache\n",
+			  _computed, _nsecs / 1000, _cached);
+	_layouts.clear();
+	_computed = 0;
+	_cached = 0;
+	_nsecs = 0;
 }
 
 void QP_ListChart::addPrimary(QP_PartInfo *partinfo) {
 	/*---append to the partition list---*/
 	QP_ChartItem *item = new QP_ChartItem();
 	item->partinfo = partinfo;
+	item->key = chartKey(partinfo);
 	partlist.append(item); //aleste
 
-	if (partinfo->type == QTParted::primary) {
+	/*---the same partition was in the last scan: take its widget back---*/
+	QP_PartWidget *partwidget = _spare.take(item->key);
+	if (partwidget) {
+		partwidget->setPartInfo(partinfo);
+		partwidget->setSelected(false);
+	} else if (partinfo->type == QTParted::primary) {
 		/*---create a new primary partition  ---*/
-		partinfo->partwidget = new QP_Partition(partinfo, container);
+		partwidget = new QP_Partition(partinfo, container);
+		setSignals(partwidget);
 	} else {
 		/*---create a new extended partition ---*/
-		partinfo->partwidget = new QP_Extended(partinfo, container);
-		extpartinfo = partinfo;
+		partwidget = new QP_Extended(partinfo, container);
+		setSignals(partwidget);
 	}
 
+	if (partinfo->type == QTParted::extended)
+		extpartinfo = partinfo;
+
 	//aleste
-	item->partwidget = partinfo->partwidget;
+	partinfo->partwidget = partwidget;
+	item->partwidget = partwidget;
 
 	/*---show the widget---*/
-	partinfo->partwidget->show();
-
-	/*---connect sigPopup and sigSelectPart---*/
-	setSignals(partinfo->partwidget);
+	partwidget->show();
 }
 
 void QP_ListChart::addLogical(QP_PartInfo *partinfo) {
 	/*---append to the partition list---*/
 	QP_ChartItem *item = new QP_ChartItem();
 	item->partinfo = partinfo;
+	item->key = chartKey(partinfo);
 	logilist.append(item);
 
 	QP_Extended *extended = (QP_Extended *)extpartinfo->partwidget;
 
-	/*---add a logical partition the the extended---*/
-	partinfo->partwidget = extended->addLogical(partinfo);
+	/*---take the widget back only if it is inside this extended---*/
+	QP_PartWidget *partwidget = _spare.value(item->key);
+	if (partwidget && (partwidget->parentWidget() == extended->container)) {
+		_spare.remove(item->key);
+		partwidget->setPartInfo(partinfo);
+		partwidget->setSelected(false);
+	} else {
+		/*---add a logical partition the the extended---*/
+		partwidget = extended->addLogical(partinfo);
+		setSignals(partwidget);
+	}
+
+	partinfo->partwidget = partwidget;
 	item->partwidget = partinfo->partwidget;//aleste
-	
+
 	/*---show the widget---*/
-	partinfo->partwidget->show();
+	partwidget->show();
+}
 
-	/*---connect sigPopup and sigSelectPart---*/
-	setSignals(partinfo->partwidget);
+QP_ChartKey QP_ListChart::chartKey(QP_PartInfo *partinfo) {
+	return qMakePair((int)partinfo->type, partinfo->start);
 }
 
-void QP_ListChart::draw() {	
+void QP_ListChart::dropSpare() {
+	/*---the logicals first: destroying an extended destroy its logicals---*/
+	QHashIterator<QP_ChartKey, QP_PartWidget*> it(_spare);
+	while (it.hasNext()) {
+		it.next();
+		if (it.key().first == QTParted::logical)
+			delete it.value();
+	}
+
+	it.toFront();
+	while (it.hasNext()) {
+		it.next();
+		if (it.key().first != QTParted::logical)
+			delete it.value();
+	}
+
+	_spare.clear();
+}
+
+void QP_ListChart::draw() {
 	/*---in this method partitions are resized to fit the container   ---*/
-	/*---only primaries and extended partitions are resized!		  ---*/
 	/*---Logicals partitions are resized inside draw_extended method! ---*/
 
+	/*---the partitions that are gone---*/
+	dropSpare();
+
 	/*---return if the partition list is empty... for example at startup ;)---*/
 	if (partlist.count() == 0) return;
 
-	/*---totwidth contain the minimal width of the QP_ListChart---*/
-	int totwidth = 0;
-
-	/*---the first "for" loop is needed to calculate the totwidth---*/
-
-	foreach(QP_ChartItem* p, partlist)
-	{
-		totwidth += p->width = MIN_PARTITION_WIDTH;
-		if (totwidth > container->width())
-			qFatal("Error calculating size of QP_ListChar! %d\n", container->width());
-	}
+	int width = container->width();
 
-	/*---resize the QP_ListChart---*/
-	if (totwidth > MIN_HDWIDTH)
-		setMinimumWidth(totwidth);
-
-	/*---this "for" loop is needed to calculate how much partitions can grow---*/
-	/*---it loop until partition fit the container						  ---*/
-	QP_ChartItem* p = NULL;
-	QListIterator <QP_ChartItem*> partit(partlist);
-	
-	while (totwidth < container->width()) {
-		if (p == NULL)
-	{
-		if(partit.hasNext())
-		{
-		p = partit.next();
-		}
+	/*---the layout of this width was already computed?---*/
+	if (_layouts.contains(width)) {
+		_cached++;
+	} else {
+		if (_layouts.count() >= LAYOUT_CACHE)
+			_layouts.clear();
+
+		QElapsedTimer elapsed;
+		elapsed.start();
+		_layouts.insert(width, layout(width));
+		_nsecs += elapsed.nsecsElapsed();
+		_computed++;
 	}
-		/*---calculate the size of the partition---*/
-		float mbsize = p->partinfo->mb_end() - p->partinfo->mb_start();
+	_layout = _layouts.value(width);
 
-		/*---calculate the width of the partition---*/
-		int newwidth = (int)((mbsize*container->width())/mb_hdsize() + 1);
-
-		/*---if the actual width is less then the width calculate increment it---*/
-		if (p->width < newwidth) {
-			p->width++;
-			totwidth++;
-		}
+	/*---not enough room for the minimum widths: the chart must grow---*/
+	int totwidth = 0;
+	foreach(int w, _layout.primary)
+		totwidth += w;
 
-		if(partit.hasNext())
-		{
-			p = partit.next();
-		}
-		else
-		{
-			p = NULL;
-			partit.toFront();
-		}
+	if (totwidth > width) {
+		container->setMinimumWidth(totwidth);
+		setMinimumWidth(totwidth + 12);
 	}
 
-	/*---the last "for" loop is needed to resize the partitions with the calculated width---*/
+	/*---resize the partitions with the calculated width---*/
 	int lastleft = 0;
-	totwidth = 0;
-	foreach(QP_ChartItem* p, partlist)
-	{	
-		QP_PartWidget *partwidget = p->partwidget;
-		partwidget->setGeometry(lastleft, 0, p->width, container->height());
+	for (int i = 0; i < partlist.count(); i++) {
+		QP_ChartItem *p = partlist.at(i);
+		p->width = _layout.primary.at(i);
+		p->partwidget->setGeometry(lastleft, 0, p->width, container->height());
 		lastleft += p->width;
 
 		if ((p->partinfo->type == QTParted::extended)
-		&&  (logilist.count()  != 0)) {
-			/*---loop inside for size for logicals partitions ;)---*/
+		&&  (logilist.count()  != 0))
 			draw_extended();
-
-			/*---draw_extended changed the extended size!---*/
-			if (p->width != partwidget->width())
-				lastleft += (partwidget->width() - p->width);
-		}
-		totwidth += partwidget->width();
-		if ((partwidget->x()+partwidget->width()) > container->width()) {
-			container->setMinimumWidth(totwidth);
-			setMinimumWidth(totwidth+12);
-		}
 	}
 }
 
 void QP_ListChart::draw_extended() {
-	/*taccon: cambiare extended->container!*/
-	/*---in this method logical partitions are resized to fit the container---*/
-
-	/*---get extended partition---*/
+	/*---in this method logical partitions are resized to fit the extended---*/
 	QP_Extended *extended = (QP_Extended *)extpartinfo->partwidget;
 
-	/*---totwidth contain the minimal width of the Extended partition---*/
-	int totwidth = 0;
+	/*---the container of the extended has a border of 6 pixels (see QP_Extended)---*/
+	int height = extended->height() - 12;
 
-	/*---the first "for" loop is needed to calculate the totwidth---*/
-	foreach( QP_ChartItem* p, logilist )
-	{
-		totwidth += p->width = MIN_PARTITION_WIDTH;
-		//if (totwidth > extended->container->width())
-		//	qFatal("Error calculating size of QP_ListChar! %d\n", container->width());
+	int lastleft = 0;
+	for (int i = 0; (i < logilist.count()) && (i < _layout.logical.count()); i++) {
+		QP_ChartItem *p = logilist.at(i);
+		p->width = _layout.logical.at(i);
+		p->partwidget->setGeometry(lastleft, 0, p->width, height);
+		lastleft += p->width;
 	}
+}
 
-	/*---if the width of the widget is not enough for extended resize it!---*/
-	if (totwidth != extended->container->width())
-		extended->setMinimumWidth(extended->width()+(totwidth - extended->container->width()));
-
-	/*---this "for" loop is needed to calculate how much partitions can grow---*/
-	/*---it loop until partition fit the container						  ---*/
-	QP_ChartItem* p = NULL;
-	QListIterator <QP_ChartItem*> logiit(logilist);
-
-	while (totwidth < extended->container->width()) {
-		if (!p)
-		{
-			if(logiit.hasNext())
-				p = logiit.next();
-		}
+QP_ChartLayout QP_ListChart::layout(int width) {
+	QP_ChartLayout layout;
+	QVector<double> sizes;
+	QVector<int> minimum;
+	int extended = -1;
+
+	/*---the extended must have room for the minimum of its logicals---*/
+	foreach(QP_ChartItem *p, partlist) {
+		sizes.append(p->partinfo->end - p->partinfo->start);
+		if ((p->partinfo == extpartinfo) && (logilist.count() != 0)) {
+			extended = sizes.count() - 1;
+			minimum.append(qMax(MIN_PARTITION_WIDTH, logilist.count() * MIN_PARTITION_WIDTH + 12));
+		} else
+			minimum.append(MIN_PARTITION_WIDTH);
+	}
+	layout.primary = proportional(sizes, minimum, width);
 
-		/*---calculate the size of the extended partition---*/
-		float extsize = extpartinfo->end - extpartinfo->start;
+	if (extended < 0)
+		return layout;
 
-		/*---calculate the size of the partition---*/
-		float mbsize = p->partinfo->end - p->partinfo->start;
+	/*---logical partitions share the extended, less its border---*/
+	sizes.clear();
+	minimum.clear();
+	foreach(QP_ChartItem *p, logilist) {
+		sizes.append(p->partinfo->end - p->partinfo->start);
+		minimum.append(MIN_PARTITION_WIDTH);
+	}
+	layout.logical = proportional(sizes, minimum, layout.primary.at(extended) - 12);
 
-		/*---calculate the width of the partition---*/
-		int newwidth = (int)((mbsize*extended->container->width())/extsize + 1);
+	return layout;
+}
 
-		/*---if the actual width is less then the width calculate increment it---*/
-		if (p->width < newwidth) {
-			p->width++;
-			totwidth++;
+/*---split width in proportion to sizes, every item at least its minimum:
+ *   the items whose share is under the minimum get the minimum, and the
+ *   others share what is left. The fractions of pixel are given to the
+ *   largest remainders, so the widths sum to width exactly. If width is
+ *   less than the minimums, the minimums are returned---*/
+QVector<int> QP_ListChart::proportional(const QVector<double> &sizes, const QVector<int> &minimum, int width) {
+	int n = sizes.count();
+	QVector<int> widths = minimum;
+	QVector<bool> fixed(n, false);
+
+	int space = width;
+	double total = 0;
+	for (int i = 0; i < n; i++)
+		total += qMax(0.0, sizes.at(i));
+
+	int mintotal = 0;
+	foreach(int m, minimum)
+		mintotal += m;
+	if ((n == 0) || (width <= mintotal))
+		return widths;
+
+	/*---fix the items under their minimum, until none is left---*/
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (int i = 0; i < n; i++) {
+			if (fixed.at(i))
+				continue;
+			double size = qMax(0.0, sizes.at(i));
+			if ((total <= 0) || (size * space / total < minimum.at(i))) {
+				fixed[i] = true;
+				space -= minimum.at(i);
+				total -= size;
+				changed = true;
+			}
 		}
-
-		p = logiit.next();
 	}
 
-	/*---the last "for" loop is needed to resize the partitions with the calculated width---*/
-	int lastleft = 0;
-	foreach( QP_ChartItem* p, logilist )
-	{
-		QP_PartWidget *partwidget = p->partwidget;
-		partwidget->setGeometry(lastleft, 0, p->width, extended->container->height());
-		lastleft += p->width;
+	/*---the others: the integer part, then a pixel to the largest remainders---*/
+	QVector<QPair<double, int> > remainders;
+	int used = 0;
+	int last = -1;
+
+	for (int i = 0; i < n; i++) {
+		if (fixed.at(i))
+			continue;
+		double exact = qMax(0.0, sizes.at(i)) * space / total;
+		widths[i] = (int)exact;
+		used += widths[i];
+		remainders.append(qMakePair(exact - widths[i], i));
+		last = i;
 	}
+
+	std::sort(remainders.begin(), remainders.end(),
+		  [](const QPair<double, int> &a, const QPair<double, int> &b) { return a.first > b.first; });
+	for (int k = 0; (k < remainders.count()) && (used < space); k++, used++)
+		widths[remainders.at(k).second]++;
+
+	/*---everything at its minimum (all the sizes are 0): the rest to the last---*/
+	if (last < 0)
+		widths[n - 1] += space;
+
+	return widths;
 }
 
 void QP_ListChart::paintEvent(QPaintEvent *) {
@@ -23,13 +23,25 @@
  *
  * This is a widget derived from QP_PartList that display a "chart" of partitions
  * Using methods "addPrimary" and "addLogical" you can draw the chart easily ;)
+ *
+ * The width of every partition is computed in one pass (see "proportional"),
+ * and the layout is kept for every width of the chart until the partitions
+ * change (see "clear"): dragging the border of the window reuse it.
+ *
+ * The widgets are not destroyed by "clear": the partitions of the next scan
+ * (same type and start) take them back, so only the tiles of the partitions
+ * that changed are drawn again. The widgets nobody took are destroyed by the
+ * next "draw".
  */
 
 #ifndef QP_LISTCHART_H
 #define QP_LISTCHART_H
 
 #include <QWidget>
+#include <QHash>
 #include <QList>
+#include <QPair>
+#include <QVector>
 #include <QPaintEvent>
 #include <QResizeEvent>
 #include <QMouseEvent>
@@ -39,6 +51,15 @@
 
 class QP_ChartItem;
 
+/*---a partition of a scan and the same one of the next scan---*/
+typedef QPair<int, PedSector> QP_ChartKey;
+
+/*---the widths of the partitions for a width of the chart---*/
+struct QP_ChartLayout {
+    QVector<int> primary;                 /*---primary and extended partitions              ---*/
+    QVector<int> logical;                 /*---logical partitions, inside the extended      ---*/
+};
+
 /*---Implementazione della lista delle partizioni su ListChart---*/
 class QP_ListChart : public QP_PartList {
 Q_OBJECT
@@ -52,6 +73,7 @@ public:
     void addLogical(QP_PartInfo *);       /*---add a Logical partition                      ---*/
     void draw();                          /*---resize and redraw partitions inside listchart---*/
     void draw_extended();                 /*---resize and redraw partitions in QP_Extended  ---*/
+    static QVector<int> proportional(const QVector<double> &sizes, const QVector<int> &minimum, int width);
 
 protected:
     QWidget *container;                   /*---Widget in which you attach partitions        ---*/
@@ -62,6 +84,17 @@ protected:
     void resizeEvent(QResizeEvent *);     /*---reimplemented to resize partitions inside    ---*/
     void mouseReleaseEvent(QMouseEvent *);/*---reimplemented to get mouse popup             ---*/
     void setSignals(QP_PartWidget *);     /*---connect sigPopup and sigSelectPart signals   ---*/
+    QP_ChartLayout layout(int width);     /*---compute the layout for a container width     ---*/
+    static QP_ChartKey chartKey(QP_PartInfo *);
+    void dropSpare();                     /*---destroy the widgets nobody took back         ---*/
+
+private:
+    QHash<int, QP_ChartLayout> _layouts;  /*---by container width, for these partitions     ---*/
+    QP_ChartLayout _layout;               /*---the one drawn                                ---*/
+    QHash<QP_ChartKey, QP_PartWidget*> _spare; /*---widgets of the last scan, hidden        ---*/
+    int _computed;                        /*---statistics, logged by clear                  ---*/
+    int _cached;
+    qint64 _nsecs;
 };
 
 #endif
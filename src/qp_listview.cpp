@@ -20,234 +20,504 @@
 */
 #include "qp_listview.h"
 #include "qp_filesystem.h"
+#include "qp_debug.h"
+#include <QCoreApplication>
 #include <QResizeEvent>
+#include <QSet>
 
 #define MIN_HDWIDTH 190
+#define LIST_COLUMNS 9
 
+/*---the texts are translated in the context of QP_RealListView, that made them
+ *   before QP_ListModel: so the translations in ts/ are still good---*/
+#define trList(text) QCoreApplication::translate ( "QP_RealListView", text )
 
-/*----------QP_ListViewItem----------------------------------------------------------*/
+
+/*----------QP_ListModel-------------------------------------------------------------*/
 /*---																			 ---*/
 
-QP_ListViewItem::QP_ListViewItem ( QTreeWidget *parent,
-								   const QString &number,
-								   const QString &diskName,
-								   const QString &fstype,
-								   const QString &status,
-								   const QString &sizeStr,
-								   const QString &usedStr,
-								   const QString &startStr,
-								   const QString &endStr,
-								   const QString &label,
-								   QP_PartInfo *pinfo )
-		: QTreeWidgetItem ( parent )
-{
-
-	partinfo = pinfo;
-	partinfo->listviewitem = this;
-
-	setIcon ( 0, pinfo->fsspec->pixmap() );
-	setText ( 0, number );
-	setText ( 1, diskName );
-	setText ( 2, fstype );
-	setText ( 3, status );
-	setText ( 4, sizeStr );
-	setText ( 5, usedStr );
-	setText ( 6, startStr );
-	setText ( 7, endStr );
-	setText ( 8, label );
-}
-
-QP_ListViewItem::QP_ListViewItem ( QTreeWidgetItem *parent,
-								   const QString &number,
-								   const QString &diskName,
-								   const QString &fstype,
-								   const QString &status,
-								   const QString &sizeStr,
-								   const QString &usedStr,
-								   const QString &startStr,
-								   const QString &endStr,
-								   const QString &label,
-								   QP_PartInfo *pinfo )
-		: QTreeWidgetItem ( parent )
-{
-
-	partinfo = pinfo;
-	partinfo->listviewitem = this;
-
-	setIcon ( 0, pinfo->fsspec->pixmap() );
-	setText ( 0, number );
-	setText ( 1, diskName );
-	setText ( 2, fstype );
-	setText ( 3, status );
-	setText ( 4, sizeStr );
-	setText ( 5, usedStr );
-	setText ( 6, startStr );
-	setText ( 7, endStr );
-	setText ( 8, label );
+bool QP_ListRow::operator== ( const QP_ListRow &r ) const
+{
+	return ( key == r.key )
+		   && ( fsspec == r.fsspec )
+		   && ( type == r.type )
+		   && ( num == r.num )
+		   && ( start == r.start )
+		   && ( end == r.end )
+		   && ( min_size == r.min_size )
+		   && ( label == r.label )
+		   && ( active == r.active )
+		   && ( hidden == r.hidden );
 }
 
-/*----------QP_RealListView----------------------------------------------------------*/
-/*---																			 ---*/
-QP_RealListView::QP_RealListView ( QWidget *parent )
-		: QTreeWidget ( parent )
+QP_ListModel::QP_ListModel ( QObject *parent )
+		: QAbstractItemModel ( parent )
 {
-	setContextMenuPolicy(Qt::CustomContextMenu);
+	_device = NULL;
+	_table = true;
+	_inserted = 0;
+	_removed = 0;
+	_changed = 0;
+}
 
-	itemextended = NULL;
+QP_ListModel::~QP_ListModel()
+{
+}
 
-	QStringList hlabel;
-	hlabel << tr ( "Number" ) << tr ( "Partition" ) << tr ( "Type" ) << tr ( "Status" ) << tr ( "Size" ) << tr ( "Used Space" ) << tr ( "Start" ) << tr ( "End" ) << tr ( "Label" ); // number 8
+void QP_ListModel::setDevice ( QP_Device *device )
+{
+	/*---nothing of the old device can be kept---*/
+	beginResetModel();
+	_primary.clear();
+	_logical.clear();
+	_device = device;
+	endResetModel();
+}
 
-	setHeaderLabels ( hlabel );
+QP_ListRow QP_ListModel::row ( QP_PartInfo *partinfo )
+{
+	QP_ListRow r;
+
+	/*---a row is known by its type and its start, like the tiles of the chart:
+	 *   not by the number, because when a logical is deleted the ones after it
+	 *   are numbered again, and the selection would go to another partition---*/
+	r.key = QString ( "%1 %2 %3" ).arg ( partinfo->isFree() ? "free" : "part" )
+								.arg ( ( int ) partinfo->type )
+								.arg ( partinfo->start );
+
+	r.partinfo = partinfo;
+	r.fsspec = partinfo->fsspec;
+	r.type = partinfo->type;
+	r.num = partinfo->num;
+	r.start = partinfo->start;
+	r.end = partinfo->end;
+	r.min_size = partinfo->min_size;
+	r.label = partinfo->label();
+	r.active = partinfo->isActive();
+	r.hidden = partinfo->isHidden();
+	return r;
+}
 
-	/*---get if user want to change selectior or want to popup a menu---*/
-	connect ( this, SIGNAL ( itemClicked ( QTreeWidgetItem *, int ) ),
-			  SLOT ( selectionChanged ( QTreeWidgetItem * ) ) );
-	connect ( this, SIGNAL ( customContextMenuRequested ( const QPoint & ) ),
-			  SLOT ( rightButtonClicked ( const QPoint & ) ) );
+void QP_ListModel::update ( QList<QP_PartInfo *> partlist, QList<QP_PartInfo *> logilist )
+{
+	QVector<QP_ListRow> primary;
+	QVector<QP_ListRow> logical;
+
+	foreach ( QP_PartInfo *p, partlist )
+		primary.append ( row ( p ) );
+	foreach ( QP_PartInfo *p, logilist )
+		logical.append ( row ( p ) );
+
+	_inserted = 0;
+	_removed = 0;
+	_changed = 0;
+
+	/*---read once here, not for every cell that is painted---*/
+	bool table = _device && _device->partitionTable();
+
+	/*---the logicals are compared only if the extended is the same---*/
+	int oldExtended = extendedRow();
+	int newExtended = -1;
+	for ( int i = 0; i < primary.count(); i++ )
+		if ( primary.at ( i ).type == QTParted::extended )
+			newExtended = i;
+
+	bool extendedKept = ( oldExtended != -1 ) && ( newExtended != -1 )
+						&& ( _primary.at ( oldExtended ).key == primary.at ( newExtended ).key );
+
+	/*---partitions that swapped their place (a move) or a new partition
+	 *   table: build it again---*/
+	if ( ( table != _table )
+	  || !sameOrder ( _primary, primary )
+	  || ( extendedKept && !sameOrder ( _logical, logical ) ) )
+	{
+		showDebug ( "%s", "listmodel::update, the order changed: reset\n" );
+		beginResetModel();
+		_table = table;
+		_primary = primary;
+		_logical = logical;
+		endResetModel();
+		return;
+	}
+
+	if ( extendedKept )
+		sync ( _logical, logical, false, logical );
+	sync ( _primary, primary, true, logical );
+
+	/*---a row inserted or removed change the number of the rows after it---*/
+	if ( _inserted + _removed )
+	{
+		if ( _primary.count() )
+			emit dataChanged ( index ( 0, 0 ), index ( _primary.count() - 1, 0 ) );
+		if ( _logical.count() )
+			emit dataChanged ( index ( 0, 0, extended() ), index ( _logical.count() - 1, 0, extended() ) );
+	}
+
+	showDebug ( "listmodel::update, %d rows inserted, %d removed, %d changed\n",
+				_inserted, _removed, _changed );
 }
 
-QP_RealListView::~QP_RealListView()
+/*---the rows that are in both lists are in the same order?---*/
+bool QP_ListModel::sameOrder ( const QVector<QP_ListRow> &rows, const QVector<QP_ListRow> &fresh )
 {
+	QSet<QString> oldKeys;
+	QSet<QString> newKeys;
+	foreach ( const QP_ListRow &r, rows )
+		oldKeys.insert ( r.key );
+	foreach ( const QP_ListRow &r, fresh )
+		newKeys.insert ( r.key );
+
+	int i = 0;
+	int j = 0;
+	while ( true )
+	{
+		while ( ( i < rows.count() ) && !newKeys.contains ( rows.at ( i ).key ) )
+			i++;
+		while ( ( j < fresh.count() ) && !oldKeys.contains ( fresh.at ( j ).key ) )
+			j++;
+
+		if ( ( i == rows.count() ) || ( j == fresh.count() ) )
+			return ( i == rows.count() ) && ( j == fresh.count() );
+		if ( rows.at ( i ).key != fresh.at ( j ).key )
+			return false;
+		i++;
+		j++;
+	}
 }
 
-void QP_RealListView::setDevice ( QP_Device *device )
+/*---make rows equal to fresh, telling the view every step: the rows that are
+ *   gone are removed, the new ones inserted and the others changed only if
+ *   something shown is different. An extended inserted take the logicals---*/
+void QP_ListModel::sync ( QVector<QP_ListRow> &rows, const QVector<QP_ListRow> &fresh, bool top, const QVector<QP_ListRow> &logicals )
 {
-	_device = device;
+	QModelIndex parent = top ? QModelIndex() : extended();
+	QSet<QString> keep;
+	QSet<QString> old;
+
+	foreach ( const QP_ListRow &r, fresh )
+		keep.insert ( r.key );
+
+	/*---remove the rows that are gone, a run at a time from the bottom---*/
+	for ( int last = rows.count() - 1; last >= 0; )
+	{
+		if ( keep.contains ( rows.at ( last ).key ) )
+		{
+			last--;
+			continue;
+		}
+
+		int first = last;
+		while ( ( first > 0 ) && !keep.contains ( rows.at ( first - 1 ).key ) )
+			first--;
+
+		int ext = top ? extendedRow() : -1;
+		beginRemoveRows ( parent, first, last );
+		rows.remove ( first, last - first + 1 );
+		if ( ( ext >= first ) && ( ext <= last ) )
+			_logical.clear();
+		endRemoveRows();
+
+		_removed += last - first + 1;
+		last = first - 1;
+	}
+
+	foreach ( const QP_ListRow &r, rows )
+		old.insert ( r.key );
+
+	/*---insert the new rows: the others are already in the same order---*/
+	for ( int first = 0; first < fresh.count(); )
+	{
+		if ( old.contains ( fresh.at ( first ).key ) )
+		{
+			first++;
+			continue;
+		}
+
+		int last = first;
+		while ( ( last + 1 < fresh.count() ) && !old.contains ( fresh.at ( last + 1 ).key ) )
+			last++;
+
+		beginInsertRows ( parent, first, last );
+		for ( int i = first; i <= last; i++ )
+		{
+			rows.insert ( i, fresh.at ( i ) );
+			if ( top && ( fresh.at ( i ).type == QTParted::extended ) )
+				_logical = logicals;
+		}
+		endInsertRows();
+
+		_inserted += last - first + 1;
+		first = last + 1;
+	}
+
+	/*---the rows kept: only the changed ones are repainted---*/
+	for ( int i = 0; i < rows.count(); i++ )
+	{
+		if ( rows.at ( i ) == fresh.at ( i ) )
+		{
+			rows[i].partinfo = fresh.at ( i ).partinfo;
+			continue;
+		}
+
+		rows[i] = fresh.at ( i );
+		emit dataChanged ( index ( i, 0, parent ), index ( i, LIST_COLUMNS - 1, parent ) );
+		_changed++;
+	}
 }
 
-void QP_RealListView::addPrimary ( QP_PartInfo *partinfo, int number )
+int QP_ListModel::extendedRow() const
 {
-	/*---get the filesystem---*/
-	QString fstype = partinfo->fsspec->name();
+	for ( int i = 0; i < _primary.count(); i++ )
+		if ( _primary.at ( i ).type == QTParted::extended )
+			return i;
 
-	/*---force "extended" label if the type is extended---*/
+	return -1;
+}
 
-	if ( partinfo->type == QTParted::extended ) fstype = "extended";
+QModelIndex QP_ListModel::extended() const
+{
+	int ext = extendedRow();
+	if ( ext == -1 )
+		return QModelIndex();
 
-	/*---set label for start, end and size---*/
-	QString startStr = MB2String ( partinfo->mb_start() );
+	return createIndex ( ext, 0, ( quintptr ) 0 );
+}
 
-	QString endStr = MB2String ( partinfo->mb_end() );
+/*---the internal id is 0 for a primary or an extended, 1 for a logical---*/
+QModelIndex QP_ListModel::index ( int r, int column, const QModelIndex &parent ) const
+{
+	if ( !hasIndex ( r, column, parent ) )
+		return QModelIndex();
 
-	QString sizeStr = MB2String ( partinfo->mb_end() - partinfo->mb_start() );
+	return createIndex ( r, column, ( quintptr ) ( parent.isValid() ? 1 : 0 ) );
+}
 
-	QString snumber;
+QModelIndex QP_ListModel::parent ( const QModelIndex &child ) const
+{
+	if ( !child.isValid() || ( child.internalId() == 0 ) )
+		return QModelIndex();
 
-	snumber.sprintf ( "%.2d", number );
+	return extended();
+}
 
-	QString name = partinfo->partname();
+int QP_ListModel::rowCount ( const QModelIndex &parent ) const
+{
+	if ( !parent.isValid() )
+		return _primary.count();
 
-	QString label = partinfo->label();
+	/*---only the extended has children---*/
+	if ( ( parent.internalId() == 0 ) && ( parent.column() == 0 ) && ( parent.row() == extendedRow() ) )
+		return _logical.count();
 
-	QString status;
+	return 0;
+}
 
-	if ( partinfo->isActive() ) status = QString ( tr ( "Active" ) );
-	else status = QString::null;
+int QP_ListModel::columnCount ( const QModelIndex & ) const
+{
+	return LIST_COLUMNS;
+}
 
-	if ( partinfo->isHidden() )
-	{
-		if ( !status.isNull() ) status += "/";
+const QP_ListRow *QP_ListModel::at ( const QModelIndex &index ) const
+{
+	if ( !index.isValid() )
+		return NULL;
 
-		status += QString ( tr ( "Hidden" ) );
-	}
+	const QVector<QP_ListRow> &rows = ( index.internalId() == 0 ) ? _primary : _logical;
+	if ( index.row() >= rows.count() )
+		return NULL;
 
-	QString usedStr;
+	return &rows.at ( index.row() );
+}
 
-	if ( partinfo->min_size == -1 )
-		usedStr = QString ( tr ( "N/A" ) );
-	else
-		usedStr = MB2String ( partinfo->mb_min_size() );
+QP_PartInfo *QP_ListModel::partInfo ( const QModelIndex &index ) const
+{
+	const QP_ListRow *r = at ( index );
+	return r ? r->partinfo : NULL;
+}
 
-	/*---if doesn't exit a partition table make "fake" listitem---*/
-	if ( !_device->partitionTable() )
-	{
-		fstype = QString::null;
-		startStr = QString::null;
-		endStr = QString::null;
-		sizeStr = QString::null;
-		usedStr = QString::null;
-		snumber = QString ( "01" );
-		status = QString ( tr ( "Empty" ) );
-		name = QString ( tr ( "Partition table" ) );
+QModelIndex QP_ListModel::indexOf ( QP_PartInfo *partinfo ) const
+{
+	for ( int i = 0; i < _primary.count(); i++ )
+		if ( _primary.at ( i ).partinfo == partinfo )
+			return index ( i, 0 );
 
-	}
+	for ( int i = 0; i < _logical.count(); i++ )
+		if ( _logical.at ( i ).partinfo == partinfo )
+			return index ( i, 0, extended() );
+
+	return QModelIndex();
+}
 
-	/*---make a new line (every line is a primary or an extended partition)---*/
+/*---the logicals are numbered just after the extended---*/
+int QP_ListModel::number ( const QModelIndex &index ) const
+{
+	int ext = extendedRow();
+
+	if ( index.internalId() != 0 )
+		return ext + 2 + index.row();
 
-	QP_ListViewItem *item = new QP_ListViewItem ( this,
-			snumber,
-			name,
-			fstype,
-			status,
-			sizeStr, usedStr, startStr, endStr,
-			label,
-			partinfo );
+	if ( ( ext != -1 ) && ( ext < index.row() ) )
+		return index.row() + 1 + _logical.count();
 
-	/*---if you add an extended... just save the pointer---*/
-	if ( partinfo->type == QTParted::extended ) itemextended = item;
+	return index.row() + 1;
 }
 
-void QP_RealListView::addLogical ( QP_PartInfo *partinfo, int number )
+QVariant QP_ListModel::data ( const QModelIndex &index, int role ) const
 {
-	// Not supported by DOS-style partition tables
-	//  const char *nameStr = ped_partition_get_name( part );
-	//  QString name( nameStr ? nameStr : "" );
+	const QP_ListRow *r = at ( index );
+	if ( !r )
+		return QVariant();
 
-	/*---set label for start, end and size---*/
-	QString startStr = MB2String ( partinfo->mb_start() );
-	QString endStr = MB2String ( partinfo->mb_end() );
-	QString sizeStr = MB2String ( partinfo->mb_end() - partinfo->mb_start() );
-	QString snumber;
-	snumber.sprintf ( "%.2d", number );
-	QString label = partinfo->label();
+	if ( ( role == Qt::DecorationRole ) && ( index.column() == 0 ) )
+		return r->fsspec->pixmap();
 
-	QString status;
+	if ( role == Qt::DisplayRole )
+		return text ( *r, index.column(), number ( index ) );
+
+	return QVariant();
+}
 
-	if ( partinfo->isActive() ) status = QString ( tr ( "Active" ) );
-	else status = QString::null;
+QVariant QP_ListModel::headerData ( int section, Qt::Orientation orientation, int role ) const
+{
+	if ( ( orientation != Qt::Horizontal ) || ( role != Qt::DisplayRole ) )
+		return QVariant();
 
-	if ( partinfo->isHidden() )
+	switch ( section )
 	{
-		if ( !status.isNull() ) status += "/";
+		case 0: return trList ( "Number" );
+		case 1: return trList ( "Partition" );
+		case 2: return trList ( "Type" );
+		case 3: return trList ( "Status" );
+		case 4: return trList ( "Size" );
+		case 5: return trList ( "Used Space" );
+		case 6: return trList ( "Start" );
+		case 7: return trList ( "End" );
+		case 8: return trList ( "Label" );
+	}
+
+	return QVariant();
+}
 
-		status += QString ( tr ( "Hidden" ) );
+/*---the text of a column: it is made only when the view paint the row---*/
+QString QP_ListModel::text ( const QP_ListRow &r, int column, int number ) const
+{
+	/*---if doesn't exit a partition table make "fake" line---*/
+	if ( !_table )
+	{
+		switch ( column )
+		{
+			case 0: return QString ( "01" );
+			case 1: return trList ( "Partition table" );
+			case 3: return trList ( "Empty" );
+			case 8: return r.label;
+		}
+		return QString::null;
 	}
 
-	QString usedStr;
+	switch ( column )
+	{
+		case 0:
+		{
+			QString snumber;
+			snumber.sprintf ( "%.2d", number );
+			return snumber;
+		}
 
-	if ( partinfo->min_size == -1 )
-		usedStr = QString ( tr ( "N/A" ) );
-	else
-		usedStr = MB2String ( partinfo->mb_min_size() );
+		case 1:
+			return r.partinfo->partname();
 
-	//printf("position: %2d %s\n", partinfo->position, partinfo->partname().toLatin1());
+		case 2:
+			/*---force "extended" label if the type is extended---*/
+			if ( r.type == QTParted::extended )
+				return QString ( "extended" );
+			return r.fsspec->name();
 
-	/*---make a new line (every line is a logical partition)---*/
+		case 3:
+		{
+			QString status;
 
-	new QP_ListViewItem ( itemextended,
-						  snumber,
-						  partinfo->partname(),
-						  partinfo->fsspec->name(),
-						  status,
-						  sizeStr, usedStr, startStr, endStr,
-						  label,
-						  partinfo );
+			if ( r.active ) status = trList ( "Active" );
 
-	/*---open the extended tree---*/
-	itemextended->setExpanded(true);
+			if ( r.hidden )
+			{
+				if ( !status.isEmpty() ) status += "/";
+
+				status += trList ( "Hidden" );
+			}
+			return status;
+		}
+
+		case 4:
+			return MB2String ( ( r.end - r.start ) * 1.0 / MEGABYTE_SECTORS );
+
+		case 5:
+			if ( r.min_size == -1 )
+				return trList ( "N/A" );
+			return MB2String ( r.min_size * 1.0 / MEGABYTE_SECTORS );
+
+		case 6:
+			return MB2String ( r.start * 1.0 / MEGABYTE_SECTORS );
+
+		case 7:
+			return MB2String ( r.end * 1.0 / MEGABYTE_SECTORS );
+
+		case 8:
+			return r.label;
+	}
+
+	return QString::null;
 }
 
+/*-----------------------------------------------------------------------------------*/
+
+
+
 
-void QP_RealListView::selectionChanged ( QTreeWidgetItem *i )
+
+/*----------QP_RealListView----------------------------------------------------------*/
+/*---																			 ---*/
+QP_RealListView::QP_RealListView ( QWidget *parent )
+		: QTreeView ( parent )
+{
+	setContextMenuPolicy(Qt::CustomContextMenu);
+
+	/*---all the rows have the same height: the view don't have to ask them---*/
+	setUniformRowHeights ( true );
+
+	_model = new QP_ListModel ( this );
+	setModel ( _model );
+
+	/*---get if user want to change selectior or want to popup a menu---*/
+	connect ( this, SIGNAL ( clicked ( const QModelIndex & ) ),
+			  SLOT ( itemClicked ( const QModelIndex & ) ) );
+	connect ( this, SIGNAL ( customContextMenuRequested ( const QPoint & ) ),
+			  SLOT ( rightButtonClicked ( const QPoint & ) ) );
+}
+
+QP_RealListView::~QP_RealListView()
+{
+}
+
+void QP_RealListView::setDevice ( QP_Device *device )
+{
+	_model->setDevice ( device );
+}
+
+QP_ListModel *QP_RealListView::listModel()
+{
+	return _model;
+}
+
+void QP_RealListView::itemClicked ( const QModelIndex &index )
 {
 	/*---emit the sigSelectPart signal---*/
-	QP_ListViewItem *di = static_cast<QP_ListViewItem *> ( i );
-	emit sigSelectPart ( di->partinfo );
+	QP_PartInfo *partinfo = _model->partInfo ( index );
+	if ( partinfo )
+		emit sigSelectPart ( partinfo );
 }
 
 
-void QP_RealListView::rightButtonClicked ( const QPoint &point )
+void QP_RealListView::rightButtonClicked ( const QPoint & )
 {
 	/*---emit the sigPopup signal---*/
 	emit sigPopup();
@@ -264,10 +534,6 @@ void QP_RealListView::rightButtonClicked ( const QPoint &point )
 QP_ListView::QP_ListView ( QWidget *parent, Qt::WindowFlags f )
 		: QP_PartList ( parent, f )
 {
-
-	/*---init progressive number---*/
-	number = 0;
-
 	/*---listview is the "real" listview!---*/
 	listview = new QP_RealListView ( this );
 
@@ -293,7 +559,7 @@ void QP_ListView::setselPartInfo ( QP_PartInfo *selpartinfo )
 	QP_PartList::setselPartInfo(selpartinfo);
 
 	/*---just a wrap to the QP_RealListView---*/
-	listview->setCurrentItem(selpartinfo->listviewitem);
+	listview->setCurrentIndex ( listview->listModel()->indexOf ( selpartinfo ) );
 }
 
 void QP_ListView::setDevice ( QP_Device *device )
@@ -304,26 +570,41 @@ void QP_ListView::setDevice ( QP_Device *device )
 
 void QP_ListView::clear()
 {
-	/*---init progressive number---*/
-	number = 0;
-
 	/*---call the ancestor to init the selected partinfo---*/
 	QP_PartList::setselPartInfo(NULL);
 
-	/*---just a wrap to the QP_RealListView---*/
-	listview->clear();
+	/*---the lines shown are kept until draw: see QP_ListModel::update---*/
+	_partlist.clear();
+	_logilist.clear();
 }
 
 void QP_ListView::addPrimary ( QP_PartInfo *partinfo )
 {
-	/*---just a wrap to the QP_RealListView---*/
-	listview->addPrimary ( partinfo, ++number );
+	_partlist.append ( partinfo );
 }
 
 void QP_ListView::addLogical ( QP_PartInfo *partinfo )
 {
-	/*---just a wrap to the QP_RealListView---*/
-	listview->addLogical ( partinfo, ++number );
+	_logilist.append ( partinfo );
+}
+
+void QP_ListView::draw()
+{
+	QP_ListModel *model = listview->listModel();
+	model->update ( _partlist, _logilist );
+
+	/*---open the extended tree---*/
+	if ( model->extended().isValid() )
+		listview->expand ( model->extended() );
+
+	/*---the partition selected before the refresh is still selected---*/
+	QModelIndex current = listview->currentIndex();
+	if ( current.isValid() && listview->selectionModel()->isSelected ( current ) )
+	{
+		QP_PartInfo *partinfo = model->partInfo ( current );
+		QP_PartList::setselPartInfo ( partinfo );
+		emit sigSelectPart ( partinfo );
+	}
 }
 
 void QP_ListView::resizeEvent ( QResizeEvent *event )
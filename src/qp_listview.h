@@ -23,49 +23,80 @@
  *
  * This is a widget derived from QP_PartList that display partitions as a list
  * Using methods "addPrimary" and "addLogical" you can easily display your hard drive;)
+ *
+ * The lines are not built again at every refresh: "draw" give the partitions
+ * added since "clear" to QP_ListModel, that compare them with the lines shown
+ * and tell the view just the lines inserted, removed or changed. So the
+ * selection and the scroll position survive a refresh (or an undo, or a new
+ * operation in the queue).
  */
 
 #ifndef QP_LISTVIEW_H
 #define QP_LISTVIEW_H
 
-#include <QTreeWidget>
+#include <QAbstractItemModel>
+#include <QTreeView>
+#include <QVector>
 #include "qp_devlist.h"
 #include "qp_partlist.h"
 
-/*----------QP_ListViewItem----------------------------------------------------------*/
-/*--- every item represents a partition. Use it adding a line in QP_ListView :)   ---*/
+/*----------QP_ListModel-------------------------------------------------------------*/
+/*--- every row is a partition: the logical partitions are the children of the    ---*/
+/*--- extended. The texts are made by "data", only for the rows that are shown.   ---*/
 /*																				---*/
-/* original author:															   ---*/
-/* Richard Moore, rich@kde.org													---*/
-/*																				---*/
-/* adaption to qtparted by Vanni Brutto										   ---*/
-/*																				---*/
-class QP_ListViewItem : public QTreeWidgetItem {
-public:
-	QP_ListViewItem(QTreeWidget *parent,
-			const QString &number,
-			const QString &diskName,
-			const QString &fstype,
-			const QString &status,
-			const QString &sizeStr,
-			const QString &usedStr,
-			const QString &startStr,
-			const QString &endStr,
-			const QString &label,
-			QP_PartInfo *pinfo);
-	QP_ListViewItem(QTreeWidgetItem *parent,
-			const QString &number,
-			const QString &diskName,
-			const QString &fstype,
-			const QString &status,
-			const QString &sizeStr,
-			const QString &usedStr,
-			const QString &startStr,
-			const QString &endStr,
-			const QString &label,
-			QP_PartInfo *pinfo);
-	~QP_ListViewItem() {}
+
+/*---a row of the model: what is shown of the partition when it was added---*/
+struct QP_ListRow {
+	QString key;				/*---same key: it is the same row		---*/
 	QP_PartInfo *partinfo;
+	QP_FileSystemSpec *fsspec;
+	QTParted::partType type;
+	int num;				/*---the logicals after a deleted one shift---*/
+	PedSector start;
+	PedSector end;
+	PedSector min_size;
+	QString label;
+	bool active;
+	bool hidden;
+
+	bool operator==(const QP_ListRow &) const;
+};
+
+class QP_ListModel : public QAbstractItemModel {
+	Q_OBJECT
+public:
+	QP_ListModel(QObject *parent=0);
+	~QP_ListModel();
+	void setDevice(QP_Device *);		/*---set the device (and empty the model)	   ---*/
+	void update(QList<QP_PartInfo *>, QList<QP_PartInfo *>); /*---the new primary and logical---*/
+	QP_PartInfo *partInfo(const QModelIndex &) const;	/*---the partition of a row	   ---*/
+	QModelIndex indexOf(QP_PartInfo *) const;	/*---the row of a partition			   ---*/
+	QModelIndex extended() const;		/*---the row of the extended partition		   ---*/
+
+	QModelIndex index(int, int, const QModelIndex &parent = QModelIndex()) const;
+	QModelIndex parent(const QModelIndex &) const;
+	int rowCount(const QModelIndex &parent = QModelIndex()) const;
+	int columnCount(const QModelIndex &parent = QModelIndex()) const;
+	QVariant data(const QModelIndex &, int role = Qt::DisplayRole) const;
+	QVariant headerData(int, Qt::Orientation, int role = Qt::DisplayRole) const;
+
+private:
+	QVector<QP_ListRow> _primary;		/*---primary and extended partitions		   ---*/
+	QVector<QP_ListRow> _logical;		/*---logical partitions, children of the extended---*/
+	QP_Device *_device;
+	bool _table;				/*---false: a fake row for a disk without table ---*/
+
+	int _inserted;				/*---statistics, logged by update		   ---*/
+	int _removed;
+	int _changed;
+
+	static QP_ListRow row(QP_PartInfo *);
+	const QP_ListRow *at(const QModelIndex &) const;
+	int extendedRow() const;
+	int number(const QModelIndex &) const;	/*---the progressive number shown		   ---*/
+	static bool sameOrder(const QVector<QP_ListRow> &, const QVector<QP_ListRow> &);
+	void sync(QVector<QP_ListRow> &, const QVector<QP_ListRow> &, bool, const QVector<QP_ListRow> &);
+	QString text(const QP_ListRow &, int, int) const;
 };
 /*-----------------------------------------------------------------------------------*/
 
@@ -75,7 +106,7 @@ public:
 
 /*----------QP_RealListView----------------------------------------------------------*/
 /* A widget that displays a list of all partitions on a disk.					 ---*/
-/* This is the "Real" widget. It is inherited by QListView... but you must not	---*/
+/* This is the "Real" widget. It is inherited by QTreeView... but you must not	---*/
 /* use this widget directly! You must use insteat QP_ListView (see below).		---*/
 /*																				---*/
 /* original author:															   ---*/
@@ -83,21 +114,17 @@ public:
 /*																				---*/
 /* adaption to qtparted by Vanni Brutto										   ---*/
 /*																				---*/
-class QP_RealListView : public QTreeWidget {
+class QP_RealListView : public QTreeView {
 	Q_OBJECT
 public:
 	QP_RealListView(QWidget *parent=0);
 	~QP_RealListView();
 
 	void setDevice(QP_Device *);		/*---set the device								   ---*/
-	void addPrimary(QP_PartInfo *, int);	/*---add a Primary or Extended partition			  ---*/
-	void addLogical(QP_PartInfo *, int);	/*---add a Logical partition						  ---*/
+	QP_ListModel *listModel();		/*---the partitions shown						  ---*/
 
 private:
-	QP_Device *_device;
-
-protected:
-	QP_ListViewItem *itemextended;		/*---this contain a pointer to the extended partition ---*/
+	QP_ListModel *_model;
 
 signals:
 	void sigSelectPart(QP_PartInfo *);		/*---emitted when you change the selection			---*/
@@ -105,7 +132,7 @@ signals:
 
 
 protected slots:
-	void selectionChanged(QTreeWidgetItem *);	/*---connected to get when user change a selected line---*/
+	void itemClicked(const QModelIndex &);		/*---connected to get when user change a selected line---*/
 	void rightButtonClicked(const QPoint &);	/*---the user want to popup a menu ---*/
 };
 /*-----------------------------------------------------------------------------------*/
@@ -129,9 +156,11 @@ public:
 	void clear();				/*---clear the chart						---*/
 	void addPrimary(QP_PartInfo *);		/*---add a Primary or Extended partition	---*/
 	void addLogical(QP_PartInfo *);		/*---add a Logical partition				---*/
+	void draw();				/*---give the partitions to the model	   ---*/
 
 private:
-	int number;				/*---just a prog. number for every partition---*/
+	QList<QP_PartInfo *> _partlist;		/*---partitions added since clear		 ---*/
+	QList<QP_PartInfo *> _logilist;
 
 protected:
 	QP_RealListView *listview;		/*---the real list view					 ---*/
@@ -0,0 +1,166 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <QMutexLocker>
+#include "qp_mounttable.h"
+#include "qp_debug.h"
+
+QP_MountTable::QP_MountTable() {
+	_lookups = 0;
+
+	/*---without the fd (no /proc?) the table is read at every lookup---*/
+	_fd = open(MOUNTINFO_FILE, O_RDONLY | O_CLOEXEC);
+	read();
+}
+
+QP_MountTable::~QP_MountTable() {
+	if (_fd >= 0)
+		close(_fd);
+}
+
+QP_MountTable *QP_MountTable::instance() {
+	static QP_MountTable table;
+	return &table;
+}
+
+QString QP_MountTable::mountPoint(QString device) {
+	QStringList mounts = instance()->lookup(device);
+
+	if (mounts.isEmpty())
+		return QString::null;
+	return mounts.first();
+}
+
+bool QP_MountTable::busy(QString device) {
+	return !instance()->lookup(device).isEmpty();
+}
+
+QStringList QP_MountTable::lookup(QString device) {
+	struct stat st;
+
+	/*---stat follow the links: every name of the device give the same number---*/
+	if ((stat(device.toLocal8Bit().constData(), &st) != 0) || !S_ISBLK(st.st_mode))
+		return QStringList();
+
+	QMutexLocker locker(&_mutex);
+	refresh();
+	_lookups++;
+
+	return _mounts.value(st.st_rdev);
+}
+
+/*---the kernel mark the mountinfo fd with POLLPRI|POLLERR when the table
+ *   change: only then it is read again---*/
+void QP_MountTable::refresh() {
+	if (_fd < 0) {
+		read();
+		return;
+	}
+
+	struct pollfd pfd;
+	pfd.fd = _fd;
+	pfd.events = POLLPRI;
+	pfd.revents = 0;
+
+	if ((poll(&pfd, 1, 0) > 0) && (pfd.revents & (POLLPRI | POLLERR)))
+		read();
+}
+
+/*---a line of mountinfo is:
+ *   id parent major:minor root mountpoint options [optional...] - fstype source superoptions---*/
+void QP_MountTable::read() {
+	QByteArray data;
+	char buffer[4096];
+	ssize_t len;
+
+	int fd = (_fd >= 0) ? _fd : open(MOUNTINFO_FILE, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return;
+
+	lseek(fd, 0, SEEK_SET);
+	while ((len = ::read(fd, buffer, sizeof(buffer))) > 0)
+		data.append(buffer, len);
+
+	if (fd != _fd)
+		close(fd);
+
+	_mounts.clear();
+
+	for (const QByteArray &line : data.split('\n')) {
+		QList<QByteArray> fields = line.split(' ');
+		if (fields.count() < 7)
+			continue;
+
+		unsigned int devMajor, devMinor;
+		if (sscanf(fields[2].constData(), "%u:%u", &devMajor, &devMinor) != 2)
+			continue;
+
+		QString root = unescape(fields[3]);
+		QString mountpoint = unescape(fields[4]);
+		dev_t devnum = makedev(devMajor, devMinor);
+
+		/*---the whole filesystem first, its bind mounts after---*/
+		QStringList &mounts = _mounts[devnum];
+		if (root == "/")
+			mounts.prepend(mountpoint);
+		else
+			mounts.append(mountpoint);
+
+		/*---btrfs (and others) show an anonymous device: use the source too---*/
+		int separator = fields.indexOf("-", 6);
+		if ((devMajor == 0) && (separator > 0) && (separator + 2 < fields.count())) {
+			struct stat st;
+			QString source = unescape(fields[separator + 2]);
+
+			if (source.startsWith('/')
+			 && (stat(source.toLocal8Bit().constData(), &st) == 0)
+			 && S_ISBLK(st.st_mode))
+				_mounts[st.st_rdev].append(mountpoint);
+		}
+	}
+
+	showDebug("mounttable::read, %d devices mounted (%ld lookups since the last read)\n",
+		  _mounts.count(), _lookups);
+	_lookups = 0;
+}
+
+/*---spaces, tabs, newlines and backslashes are written as \ooo---*/
+QString QP_MountTable::unescape(QByteArray field) {
+	QByteArray out;
+
+	for (int i = 0; i < field.size(); i++) {
+		if ((field[i] == '\\') && (i + 3 < field.size())) {
+			out.append((char)strtol(field.mid(i + 1, 3).constData(), NULL, 8));
+			i += 3;
+		} else
+			out.append(field[i]);
+	}
+
+	return QString::fromLocal8Bit(out);
+}
@@ -0,0 +1,68 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+/* About QP_MountTable class:
+ *
+ * Where (and if) a device is mounted. The mount table was read, all of it,
+ * every time a partition was asked about; now /proc/self/mountinfo is read
+ * once into a hash keyed by the device number (major:minor), and read again
+ * only when poll() on it say that something was mounted or unmounted.
+ *
+ * The device number is what mountinfo give, so a lookup with another name of
+ * the same device (a /dev/disk/by-uuid link, a devfs name...) find it as
+ * well, and every bind mount of it is there. Filesystems that show an
+ * anonymous device (btrfs) are indexed also by the number of their source.
+ *
+ * Just use the static functions: the table is shared by all the threads.
+ */
+
+#ifndef QP_MOUNTTABLE_H
+#define QP_MOUNTTABLE_H
+
+#include <sys/types.h>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+#define MOUNTINFO_FILE "/proc/self/mountinfo"
+
+class QP_MountTable {
+public:
+	static QString mountPoint(QString device);	/*---empty if not mounted---*/
+	static bool busy(QString device);		/*---mounted somewhere?---*/
+
+private:
+	QP_MountTable();
+	~QP_MountTable();
+	static QP_MountTable *instance();
+	QStringList lookup(QString);
+	void refresh();
+	void read();
+	static QString unescape(QByteArray);
+	int _fd;
+	QHash<dev_t, QStringList> _mounts;
+	QMutex _mutex;
+	long _lookups;				/*---since the last read---*/
+};
+
+#endif
@@ -49,6 +49,8 @@ QP_NavView::QP_NavView ( QWidget *parent, QP_Settings *settings )
     drivelist = new QP_DriveList ( this, settings );
     connect ( drivelist, SIGNAL ( deviceSelected ( QP_Device * ) ),
               this, SIGNAL ( deviceSelected ( QP_Device * ) ) );
+    connect ( drivelist, SIGNAL ( devicesChanged() ),
+              this, SIGNAL ( devicesChanged() ) );
     box->addWidget ( drivelist );
 
     connect ( drivelist, SIGNAL ( deviceSelected ( QP_Device * ) ),
@@ -94,9 +96,9 @@ void QP_NavView::setPopup ( QMenu *popup )
     drivelist->setPopup ( popup );
 }
 
-void QP_NavView::init()
+void QP_NavView::init ( bool fast )
 {
-    drivelist->buildView();
+    drivelist->buildView ( fast );
 }
 
 /*---fill the driveinfo details with info about the hard disk selected---*/
@@ -144,6 +146,11 @@ QActionGroup *QP_NavView::agDevices()
     return drivelist->agDevices();
 }
 
+QList<QAction *> QP_NavView::deviceActions()
+{
+    return drivelist->deviceActions();
+}
+
 QP_Device *QP_NavView::selDevice()
 {
     return drivelist->selDevice();
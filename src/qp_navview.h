@@ -43,8 +43,9 @@ public:
     QP_NavView(QWidget *parent=0, QP_Settings *settings=0);
     ~QP_NavView();
     void setPopup(QMenu *); /*---set the popup menu (right click)---*/
-    void init();
+    void init(bool fast = false);
     QActionGroup *agDevices();
+    QList<QAction *> deviceActions(); /*---the actions of the devices shown, in order---*/
     QP_Device *selDevice(); /*---return the selected device---*/
 
 protected:
@@ -53,6 +54,7 @@ protected:
 
 signals:
     void deviceSelected(QP_Device *);  /*---emitted when user select a hard disk---*/
+    void devicesChanged();             /*---emitted when a hard disk is added---*/
 
 protected slots:
     void displayInfo(QP_Device *);
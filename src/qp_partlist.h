@@ -22,8 +22,8 @@
 /* About QP_PartList class:
  *
  * This widget is used as a prototype: there are not any implementation here!
- * Actually there are two implementation: QP_ListChart and QP_ListView: see
- * the header of these two classes to have more info!
+ * Actually there are three implementation: QP_ListChart, QP_PartMap and
+ * QP_ListView: see the header of these classes to have more info!
  */
 
 #ifndef QP_PARTLIST_H
@@ -39,13 +39,13 @@ public:
 	QP_PartList(QWidget *parent=0, Qt::WindowFlags f = 0);
 	~QP_PartList();
 	QP_PartInfo *selPartInfo();		/*---return selected partition              ---*/
-	void setselPartInfo(QP_PartInfo *);	/*---change the selected partition          ---*/
-	void clear();				/*---clear the chart                        ---*/
+	virtual void setselPartInfo(QP_PartInfo *);	/*---change the selected partition          ---*/
+	virtual void clear();			/*---clear the chart                        ---*/
 	QP_Device *device();			/*---return the device                      ---*/
-	void setDevice(QP_Device *);		/*---set the Device                         ---*/
-	void addPrimary(QP_PartInfo *);		/*---add a Primary or Extended partition    ---*/
-	void addLogical(QP_PartInfo *);		/*---add a Logical partition                ---*/
-	void draw();				/*---repaint the widget                     ---*/
+	virtual void setDevice(QP_Device *);	/*---set the Device                         ---*/
+	virtual void addPrimary(QP_PartInfo *);	/*---add a Primary or Extended partition    ---*/
+	virtual void addLogical(QP_PartInfo *);	/*---add a Logical partition                ---*/
+	virtual void draw();			/*---repaint the widget                     ---*/
 	float mb_hdsize();			/*---return the size of the hardisk         ---*/
 	void set_mb_hdsize(float);		/*---set the size of the hardisk            ---*/
 
@@ -0,0 +1,422 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include <math.h>
+#include <algorithm>
+#include <QPainter>
+#include <QStyle>
+#include <QStyleOptionFocusRect>
+#include <QToolTip>
+#include <QHelpEvent>
+
+#include "qp_partmap.h"
+#include "qp_filesystem.h"
+#include "qp_debug.h"
+
+#define MAP_WIDTH	190	/*---same minimum size of QP_ListChart      ---*/
+#define MAP_HEIGHT	70
+#define MAP_BORDER	6	/*---white border around the partitions      ---*/
+#define MAP_EXTBORDER	6	/*---border of the extended around logicals  ---*/
+#define MAP_MIN_SEGMENT	4	/*---thinner partitions are merged in slivers---*/
+#define MAP_MIN_LABEL	16	/*---thinner partitions are just a color     ---*/
+#define MAP_MAX_ZOOM	65536.0
+#define MAP_ZOOM_STEP	1.25	/*---zoom of a step of the mouse wheel       ---*/
+#define MAP_DRAG	3	/*---pixels before a press become a drag     ---*/
+
+QP_PartMap::QP_PartMap(QWidget *parent, Qt::WindowFlags f)
+	:QP_PartList(parent, f) {
+	_selPartInfo = NULL;
+	_extended = NULL;
+	_first = 0;
+	_last = 0;
+	_offset = 0;
+	_zoom = 1;
+	_dragX = 0;
+	_dragged = false;
+	_paints = 0;
+	_drawn = 0;
+	_merged = 0;
+
+	setMinimumWidth(MAP_WIDTH);
+	setMinimumHeight(MAP_HEIGHT);
+}
+
+QP_PartMap::~QP_PartMap() {
+}
+
+void QP_PartMap::setselPartInfo(QP_PartInfo *partinfo) {
+	QP_PartList::setselPartInfo(partinfo);
+
+	/*---selected from the listview: bring it in the visible part---*/
+	if (partinfo && ((partinfo->end < _offset) || (partinfo->start >= _offset + span())))
+		scroll((partinfo->start + partinfo->end) / 2 - span() / 2);
+
+	update();
+}
+
+void QP_PartMap::setDevice(QP_Device *device) {
+	QP_PartList::setDevice(device);
+
+	/*---a new disk is shown whole---*/
+	_zoom = 1;
+	_offset = 0;
+}
+
+void QP_PartMap::clear() {
+	_selPartInfo = NULL;
+
+	if (_paints)
+		showDebug("partmap::clear, %d paints, %d partitions drawn, %d merged in slivers\n",
+			  _paints, _drawn, _merged);
+	_paints = 0;
+	_drawn = 0;
+	_merged = 0;
+
+	/*---the zoom is kept: refresh, undo and commit show the same part---*/
+	_primary.clear();
+	_logical.clear();
+	_extended = NULL;
+}
+
+void QP_PartMap::addPrimary(QP_PartInfo *partinfo) {
+	QP_MapSegment segment;
+	segment.start = partinfo->start;
+	segment.end = partinfo->end;
+	segment.partinfo = partinfo;
+	_primary.append(segment);
+
+	/*---there is not a widget for every partition---*/
+	partinfo->partwidget = NULL;
+
+	if (partinfo->type == QTParted::extended)
+		_extended = partinfo;
+}
+
+void QP_PartMap::addLogical(QP_PartInfo *partinfo) {
+	QP_MapSegment segment;
+	segment.start = partinfo->start;
+	segment.end = partinfo->end;
+	segment.partinfo = partinfo;
+	_logical.append(segment);
+
+	partinfo->partwidget = NULL;
+}
+
+void QP_PartMap::draw() {
+	auto byStart = [](const QP_MapSegment &a, const QP_MapSegment &b) { return a.start < b.start; };
+	std::sort(_primary.begin(), _primary.end(), byStart);
+	std::sort(_logical.begin(), _logical.end(), byStart);
+
+	/*---free space is a partition too: they cover the whole disk---*/
+	if (_primary.isEmpty())
+		return;
+	_first = _primary.first().start;
+	_last = _first;
+	foreach(const QP_MapSegment &segment, _primary)
+		_last = qMax(_last, segment.end);
+
+	/*---the disk may be smaller than before---*/
+	scroll(_offset);
+	update();
+}
+
+void QP_PartMap::setZoom(double zoom, PedSector sector) {
+	double x = sectorX(sector);
+
+	_zoom = qBound(1.0, zoom, MAP_MAX_ZOOM);
+
+	/*---the sector stay under the same x---*/
+	QRect r = area();
+	scroll(sector - (PedSector)((x - r.left()) * span() / r.width()));
+	update();
+}
+
+QRect QP_PartMap::area() {
+	return QRect(MAP_BORDER, MAP_BORDER, qMax(1, width() - 2*MAP_BORDER), MAP_HEIGHT - 2*MAP_BORDER);
+}
+
+PedSector QP_PartMap::span() {
+	return qMax((PedSector)1, (PedSector)((_last - _first + 1) / _zoom));
+}
+
+double QP_PartMap::sectorX(PedSector sector) {
+	QRect r = area();
+	return r.left() + (double)(sector - _offset) * r.width() / span();
+}
+
+PedSector QP_PartMap::xSector(int x) {
+	QRect r = area();
+	return _offset + (PedSector)((double)(x - r.left()) * span() / r.width());
+}
+
+void QP_PartMap::scroll(PedSector offset) {
+	_offset = qBound(_first, offset, qMax(_first, _last + 1 - span()));
+}
+
+/*---index of the last segment that start at or before the sector, -1 if none---*/
+int QP_PartMap::find(const QVector<QP_MapSegment> &segments, PedSector sector) {
+	auto it = std::upper_bound(segments.begin(), segments.end(), sector,
+				   [](PedSector s, const QP_MapSegment &segment) { return s < segment.start; });
+	return (it - segments.begin()) - 1;
+}
+
+QP_PartInfo *QP_PartMap::partAt(const QPoint &pt) {
+	QRect r = area();
+	if (!r.contains(pt))
+		return NULL;
+
+	PedSector sector = xSector(pt.x());
+
+	/*---inside the border of the extended there are the logicals---*/
+	if (_extended
+	&&  (sector >= _extended->start) && (sector <= _extended->end)
+	&&  (pt.y() >= r.top() + MAP_EXTBORDER) && (pt.y() <= r.bottom() - MAP_EXTBORDER)) {
+		int i = find(_logical, sector);
+		if ((i >= 0) && (sector <= _logical.at(i).end))
+			return _logical.at(i).partinfo;
+	}
+
+	int i = find(_primary, sector);
+	if ((i >= 0) && (sector <= _primary.at(i).end))
+		return _primary.at(i).partinfo;
+
+	return NULL;
+}
+
+void QP_PartMap::paintEvent(QPaintEvent *) {
+	QPainter paint(this);
+	paint.fillRect(2, 2, width()-4, MAP_HEIGHT-4, Qt::white);
+
+	if (_primary.isEmpty())
+		return;
+
+	QRect r = area();
+	paint.setClipRect(r);
+	drawRow(paint, _primary, r.top(), r.height());
+
+	_paints++;
+}
+
+/*---draw the visible segments of a row. The segments thinner than
+ *   MAP_MIN_SEGMENT are merged with the next ones, until the group is
+ *   large enough to be seen---*/
+void QP_PartMap::drawRow(QPainter &paint, const QVector<QP_MapSegment> &segments, int top, int height) {
+	PedSector visible = _offset + span();
+	int groupLeft = 0;
+	int groupRight = 0;
+	int groupCount = 0;
+	QP_PartInfo *groupPart = NULL;
+
+	/*---a group of a single partition is drawn as it is---*/
+	auto flush = [&]() {
+		QRect rect(groupLeft, top, qMax(1, groupRight - groupLeft), height);
+		if (groupCount == 1) {
+			drawPartition(paint, rect, groupPart);
+			_drawn++;
+		} else if (groupCount > 1) {
+			drawSliver(paint, rect, groupCount);
+			_merged += groupCount;
+		}
+		groupCount = 0;
+	};
+
+	for (int i = qMax(0, find(segments, _offset)); i < segments.count(); i++) {
+		const QP_MapSegment &segment = segments.at(i);
+		if (segment.start >= visible)
+			break;
+
+		int left = qRound(sectorX(segment.start));
+		int right = qRound(sectorX(segment.end + 1));
+
+		if (right - left < MAP_MIN_SEGMENT) {
+			if (groupCount == 0) {
+				groupLeft = left;
+				groupPart = segment.partinfo;
+			}
+			groupRight = right;
+			groupCount++;
+			if (groupRight - groupLeft >= MAP_MIN_SEGMENT)
+				flush();
+			continue;
+		}
+		flush();
+
+		QRect rect(left, top, right - left, height);
+		drawPartition(paint, rect, segment.partinfo);
+		_drawn++;
+
+		/*---the logicals are drawn inside the border of the extended---*/
+		if ((segment.partinfo == _extended) && !_logical.isEmpty()) {
+			paint.save();
+			paint.setClipRect(rect.adjusted(MAP_EXTBORDER, 0, -MAP_EXTBORDER, 0) & area());
+			drawRow(paint, _logical, top + MAP_EXTBORDER, height - 2*MAP_EXTBORDER);
+			paint.restore();
+		}
+	}
+	flush();
+}
+
+/*---the same drawing of QP_PartWidget::paintEvent, in a rectangle of the map---*/
+void QP_PartMap::drawPartition(QPainter &paint, const QRect &rect, QP_PartInfo *partinfo) {
+	int w = rect.width();
+	int h = rect.height();
+
+	if (partinfo->type == QTParted::extended) {
+		paint.fillRect(rect.adjusted(2, 2, -2, -2), Qt::cyan);
+	} else if (w < MAP_MIN_LABEL) {
+		/*---too thin for the border: just the color of the filesystem---*/
+		paint.fillRect(rect.adjusted(w > 2 ? 1 : 0, 1, w > 2 ? -1 : 0, -1), partinfo->fsspec->color());
+	} else {
+		int used_size = w-16;
+
+		paint.fillRect(rect.x()+5, rect.y()+5, w-10, h-10, partinfo->fsspec->color());
+		paint.fillRect(rect.x()+8, rect.y()+8, w-16, h-16, Qt::white);
+
+		if (partinfo->min_size != -1) {
+			float size = partinfo->mb_end()-partinfo->mb_start();
+			used_size = (int)(((w-16)*partinfo->mb_min_size()) / size);
+		}
+
+		if ((partinfo->isFree())
+		||  (partinfo->min_size == -1))
+			paint.fillRect(rect.x()+8, rect.y()+8, used_size, h-16, partinfo->fsspec->color());
+		else
+			paint.fillRect(rect.x()+8, rect.y()+8, used_size, h-16, Qt::yellow);
+
+		/*---the label, or just the name if there is not room for the size---*/
+		QFontMetrics fm = paint.fontMetrics();
+		QString label = partinfo->partname().mid(5);
+		if (partinfo->min_size != -1) {
+			QString sized = QString("%1 (%2)").arg(label).arg(MB2String(partinfo->mb_min_size()));
+			if (fm.width(sized) <= w-10)
+				label = sized;
+		}
+
+		if (fm.width(label) <= w-10) {
+			paint.setPen(QPen(Qt::black, 1));
+			paint.drawText(rect.x() + (w - fm.width(label))/2, rect.bottom() + 1 - fm.height(), label);
+		}
+
+		if (partinfo->fsspec->pixmap().width() < w-12)
+			paint.drawPixmap(rect.x()+3, rect.y()+3, partinfo->fsspec->pixmap());
+	}
+
+	if (partinfo == selPartInfo()) {
+		QStyleOptionFocusRect opt;
+		opt.initFrom(this);
+		opt.rect = rect;
+		opt.state = QStyle::State_Active|QStyle::State_Enabled|QStyle::State_HasFocus;
+		style()->drawPrimitive(QStyle::PE_FrameFocusRect, &opt, &paint, this);
+	}
+}
+
+/*---many partitions in a few pixels: a grey sliver with their number---*/
+void QP_PartMap::drawSliver(QPainter &paint, const QRect &rect, int count) {
+	paint.fillRect(rect.adjusted(0, 1, 0, -1), Qt::lightGray);
+	paint.fillRect(rect.adjusted(0, 1, 0, -1), QBrush(Qt::darkGray, Qt::Dense5Pattern));
+
+	QString label = QString::number(count);
+	QFontMetrics fm = paint.fontMetrics();
+	if (fm.width(label) <= rect.width()-4) {
+		paint.setPen(QPen(Qt::black, 1));
+		paint.drawText(rect, Qt::AlignCenter, label);
+	}
+}
+
+bool QP_PartMap::event(QEvent *e) {
+	if (e->type() != QEvent::ToolTip)
+		return QP_PartList::event(e);
+
+	/*---the name of the partition under the mouse, useful in a sliver---*/
+	QHelpEvent *help = (QHelpEvent *)e;
+	QP_PartInfo *partinfo = partAt(help->pos());
+	if (partinfo)
+		QToolTip::showText(help->globalPos(),
+				   QString("%1 (%2)\n%3")
+					.arg(partinfo->partname())
+					.arg(MB2String(partinfo->mb_end() - partinfo->mb_start()))
+					.arg(partinfo->fsspec->name()),
+				   this);
+	else
+		QToolTip::hideText();
+
+	return true;
+}
+
+void QP_PartMap::mousePressEvent(QMouseEvent *e) {
+	_dragX = e->x();
+	_dragged = false;
+
+	QP_PartInfo *partinfo = partAt(e->pos());
+	if (partinfo) {
+		emit sigSelectPart(partinfo);
+		if (e->button() == Qt::RightButton)
+			emit sigPopup();
+	} else if (device() && (e->button() == Qt::RightButton)) {
+		emit sigDevicePopup();
+	}
+}
+
+void QP_PartMap::mouseMoveEvent(QMouseEvent *e) {
+	if (!(e->buttons() & Qt::LeftButton) || (_zoom <= 1))
+		return;
+
+	int dx = e->x() - _dragX;
+	if (!_dragged && (qAbs(dx) < MAP_DRAG))
+		return;
+
+	if (!_dragged)
+		setCursor(Qt::ClosedHandCursor);
+	_dragged = true;
+
+	scroll(_offset - (PedSector)((double)dx * span() / area().width()));
+	_dragX = e->x();
+	update();
+}
+
+void QP_PartMap::mouseReleaseEvent(QMouseEvent *) {
+	if (_dragged)
+		unsetCursor();
+	_dragged = false;
+}
+
+void QP_PartMap::mouseDoubleClickEvent(QMouseEvent *e) {
+	/*---left zoom in, middle show the whole disk---*/
+	if (e->button() == Qt::LeftButton)
+		setZoom(_zoom * 2, xSector(e->x()));
+	else if (e->button() == Qt::MiddleButton)
+		setZoom(1, _first);
+}
+
+void QP_PartMap::wheelEvent(QWheelEvent *e) {
+	QPoint delta = e->angleDelta();
+
+	/*---a horizontal wheel pan, a vertical one zoom around the mouse---*/
+	if (delta.x() != 0) {
+		scroll(_offset - (PedSector)(delta.x() / 120.0 * span() / 10));
+		update();
+	} else if (delta.y() != 0) {
+		setZoom(_zoom * pow(MAP_ZOOM_STEP, delta.y() / 120.0), xSector(e->pos().x()));
+	}
+
+	e->accept();
+}
@@ -0,0 +1,105 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+/* About QP_PartMap class:
+ *
+ * This is a widget derived from QP_PartList that display the same "chart" of
+ * QP_ListChart, but it is a single widget that draw every partition with
+ * QPainter: there are not a QP_PartWidget for every partition. It is used
+ * by QP_DiskView when a disk has many partitions (see PARTMAP_PARTITIONS).
+ *
+ * Only the partitions in the visible part of the disk are drawn. With the
+ * mouse wheel you zoom around the mouse pointer, dragging pan the map.
+ * Partitions that are too thin to be drawn are merged in a grey sliver, that
+ * show how many partitions it hide (zoom in to see them).
+ *
+ * The partitions are kept sorted by start sector: the first visible and the
+ * partition under the mouse are found with a binary search.
+ */
+
+#ifndef QP_PARTMAP_H
+#define QP_PARTMAP_H
+
+#include <QVector>
+#include <QPaintEvent>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include "qp_partlist.h"
+
+#define PARTMAP_PARTITIONS 32		/*---more partitions than this use the map---*/
+
+/*---a partition on the map, in sectors---*/
+struct QP_MapSegment {
+	PedSector start;
+	PedSector end;
+	QP_PartInfo *partinfo;
+};
+
+class QP_PartMap : public QP_PartList {
+	Q_OBJECT
+public:
+	QP_PartMap(QWidget *parent=0, Qt::WindowFlags f = 0);
+	~QP_PartMap();
+	void setselPartInfo(QP_PartInfo *);	/*---change the selected partition          ---*/
+	void setDevice(QP_Device *);		/*---set the device and show the whole disk ---*/
+	void clear();				/*---clear the map                          ---*/
+	void addPrimary(QP_PartInfo *);		/*---add a Primary or Extended partition    ---*/
+	void addLogical(QP_PartInfo *);		/*---add a Logical partition                ---*/
+	void draw();				/*---sort the partitions and repaint        ---*/
+	void setZoom(double, PedSector);	/*---zoom keeping a sector under the same x ---*/
+
+protected:
+	bool event(QEvent *);			/*---reimplemented to show a tooltip        ---*/
+	void paintEvent(QPaintEvent *);
+	void mousePressEvent(QMouseEvent *);
+	void mouseMoveEvent(QMouseEvent *);
+	void mouseReleaseEvent(QMouseEvent *);
+	void mouseDoubleClickEvent(QMouseEvent *);
+	void wheelEvent(QWheelEvent *);
+
+private:
+	QVector<QP_MapSegment> _primary;	/*---primary and extended, sorted by start  ---*/
+	QVector<QP_MapSegment> _logical;	/*---logical partitions, sorted by start    ---*/
+	QP_PartInfo *_extended;			/*---the extended, if any                   ---*/
+	PedSector _first;			/*---first and last sector of the disk      ---*/
+	PedSector _last;
+	PedSector _offset;			/*---first visible sector                   ---*/
+	double _zoom;				/*---1 show the whole disk                  ---*/
+	int _dragX;				/*---x of the last mouse move when dragging ---*/
+	bool _dragged;
+	int _paints;				/*---statistics, logged by clear            ---*/
+	int _drawn;
+	int _merged;
+
+	QRect area();				/*---the rectangle where partitions are drawn---*/
+	PedSector span();			/*---sectors visible in the area            ---*/
+	double sectorX(PedSector);		/*---x of a sector                          ---*/
+	PedSector xSector(int);			/*---sector under a x                       ---*/
+	void scroll(PedSector);			/*---set _offset, kept inside the disk      ---*/
+	QP_PartInfo *partAt(const QPoint &);	/*---partition under a point, if any        ---*/
+	void drawRow(QPainter &, const QVector<QP_MapSegment> &, int, int);
+	void drawPartition(QPainter &, const QRect &, QP_PartInfo *);
+	void drawSliver(QPainter &, const QRect &, int);
+	static int find(const QVector<QP_MapSegment> &, PedSector);
+};
+
+#endif
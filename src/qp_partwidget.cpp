@@ -25,6 +25,7 @@
 #include <QStyle>
 #include <QStyleOption>
 #include <QPixmap>
+#include <QElapsedTimer>
 
 #include "qp_partwidget.h"
 #include "qp_filesystem.h"
@@ -33,6 +34,12 @@ QP_PartWidget::QP_PartWidget(QP_PartInfo *pinfo, QWidget *parent, Qt::WindowFlag
 	:QWidget(parent, f) {
 	_Selected = false;
 	partinfo = pinfo;   //Pointer to the QP_PartInfo class wich contain info about the partition
+
+	_tileValid = false;
+	_renders = 0;
+	_blits = 0;
+	_nsecs = 0;
+	_lastNsecs = 0;
 }
 
 QP_PartWidget::~QP_PartWidget() {
@@ -48,6 +55,65 @@ bool QP_PartWidget::Selected() {
 	return _Selected;
 }
 
+/*---the tile is compared with the new partinfo at the next paint---*/
+void QP_PartWidget::setPartInfo(QP_PartInfo *pinfo) {
+	partinfo = pinfo;
+	update();
+}
+
+int QP_PartWidget::renders() {
+	return _renders;
+}
+
+int QP_PartWidget::blits() {
+	return _blits;
+}
+
+qint64 QP_PartWidget::nsecs() {
+	return _nsecs;
+}
+
+void QP_PartWidget::resetStatistics() {
+	_renders = 0;
+	_blits = 0;
+	_nsecs = 0;
+}
+
+bool QP_TileKey::operator==(const QP_TileKey &key) const {
+	return (size == key.size)
+	    && (ratio == key.ratio)
+	    && (fsspec == key.fsspec)
+	    && (type == key.type)
+	    && (partname == key.partname)
+	    && (length == key.length)
+	    && (min_size == key.min_size)
+	    && (free == key.free)
+	    && (selected == key.selected);
+}
+
+QP_TileKey QP_PartWidget::tileKey() {
+	QP_TileKey key;
+	key.size = size();
+	key.ratio = devicePixelRatioF();
+	key.fsspec = partinfo->fsspec;
+	key.type = partinfo->type;
+	key.partname = partinfo->partname();
+	key.length = partinfo->end - partinfo->start;
+	key.min_size = partinfo->min_size;
+	key.free = partinfo->isFree();
+	key.selected = _Selected;
+	return key;
+}
+
+void QP_PartWidget::changeEvent(QEvent *e) {
+	if ((e->type() == QEvent::FontChange)
+	||  (e->type() == QEvent::StyleChange)
+	||  (e->type() == QEvent::PaletteChange))
+		_tileValid = false;
+
+	QWidget::changeEvent(e);
+}
+
 void QP_PartWidget::mousePressEvent(QMouseEvent *e) {
 	emit sigSelectPart(partinfo);
 
@@ -56,9 +122,48 @@ void QP_PartWidget::mousePressEvent(QMouseEvent *e) {
 	setFocus(); //If the widget that has focus it is draw with a border around
 }
 
-void QP_PartWidget::paintEvent(QPaintEvent *) {
-	/*---the paint area---*/
+void QP_PartWidget::paintEvent(QPaintEvent *e) {
+	QElapsedTimer elapsed;
+	elapsed.start();
+
+	/*---draw the tile again only if the partition changed---*/
+	QP_TileKey key = tileKey();
+	if (!_tileValid || !(key == _tileKey)) {
+		drawTile();
+		_tileKey = key;
+		_tileValid = true;
+		_renders++;
+	} else {
+		_blits++;
+	}
+
+	/*---copy just the part that need a repaint: the tile is in device pixels---*/
 	QPainter paint(this);
+	QRectF source(QPointF(e->rect().topLeft()) * key.ratio, QSizeF(e->rect().size()) * key.ratio);
+	paint.drawPixmap(QRectF(e->rect()), _tile, source);
+
+	_lastNsecs = elapsed.nsecsElapsed();
+	_nsecs += _lastNsecs;
+
+#ifndef QT_NO_DEBUG
+	/*---the time of this paint, over the tile---*/
+	paint.setPen(QPen(Qt::red, 1));
+	paint.drawText(rect().adjusted(0, 0, -3, 0), Qt::AlignRight | Qt::AlignTop,
+		       QString("%1us").arg(_lastNsecs / 1000));
+#endif
+}
+
+void QP_PartWidget::drawTile() {
+	/*---a pixel of the tile for every pixel of the screen: the painter keep
+	 *   drawing in the coordinates of the widget---*/
+	qreal ratio = devicePixelRatioF();
+	_tile = QPixmap(size() * ratio);
+	_tile.setDevicePixelRatio(ratio);
+	_tile.fill(Qt::transparent);
+
+	/*---the paint area, with the font of the widget---*/
+	QPainter paint(&_tile);
+	paint.setFont(font());
 
 	if (partinfo->type == QTParted::extended) {
 		QColor color = Qt::cyan;
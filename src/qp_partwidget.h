@@ -26,6 +26,15 @@
  * QP_Extended (for draw extended partition)
  *
  * You must not use this widget, you must use QP_Partition or QP_Extended insteed!
+ *
+ * The partition is drawn in a pixmap (the "tile") that is kept until something
+ * that is drawn change (see QP_TileKey): the other repaints just copy the part
+ * of the tile that need it. The tile has the pixels of the screen (see
+ * devicePixelRatioF), so it is sharp on a HiDPI screen too. In a debug build
+ * the time of the last paint is drawn over the tile.
+ *
+ * A widget can be given the QP_PartInfo of a new scan (see "setPartInfo"):
+ * if the partition is drawn the same, the tile is kept.
  */
 
 #ifndef QP_PARTWIDGET_H
@@ -34,9 +43,24 @@
 #include <QPaintEvent>
 #include <QMouseEvent>
 #include <QWidget>
+#include <QPixmap>
 #include "qparted.h"
 #include "qp_libparted.h"
 
+/*---what the tile depend on: if one of these change the tile is drawn again---*/
+struct QP_TileKey {
+	QSize size;
+	qreal ratio;				/*---device pixels for a pixel of the widget---*/
+	QP_FileSystemSpec *fsspec;		/*---color and pixmap of the filesystem ---*/
+	QTParted::partType type;
+	QString partname;			/*---the label: the device and the number---*/
+	PedSector length;
+	PedSector min_size;			/*---the used space---*/
+	bool free;
+	bool selected;
+
+	bool operator==(const QP_TileKey &) const;
+};
 
 class QP_PartWidget : public QWidget {
 	Q_OBJECT
@@ -45,14 +69,31 @@ public:
 	~QP_PartWidget();
 	void setSelected(bool);			/*---this give the focus to the partition---*/
 	bool Selected();			/*---return if the partition was selected---*/
+	void setPartInfo(QP_PartInfo *);	/*---the same partition, from a new scan ---*/
+	int renders();				/*---statistics: tiles drawn             ---*/
+	int blits();				/*---statistics: paints from the tile    ---*/
+	qint64 nsecs();				/*---statistics: time spent painting     ---*/
+	void resetStatistics();
 
 protected:
 	QP_PartInfo *partinfo;			/*---pointer to the class with info about ---*
 						 *---the partition			  ---*/
 	void mousePressEvent(QMouseEvent *);
-	void paintEvent(QPaintEvent *);				 
+	void paintEvent(QPaintEvent *);
+	void changeEvent(QEvent *);		/*---a new font or style: draw the tile again---*/
 	bool _Selected;
 
+private:
+	QP_TileKey tileKey();
+	void drawTile();			/*---draw the partition in _tile         ---*/
+	QPixmap _tile;
+	QP_TileKey _tileKey;
+	bool _tileValid;
+	int _renders;
+	int _blits;
+	qint64 _nsecs;
+	qint64 _lastNsecs;
+
 signals:
 	void sigSelectPart(QP_PartInfo *);	/*---emitted when you change the selection  ---*/
 	void sigPopup();			/*---emitted when you want to popup a menu  ---*/
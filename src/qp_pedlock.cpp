@@ -0,0 +1,51 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <QMutex>
+#include "qp_pedlock.h"
+
+static QMutex pedMutex;
+static thread_local int pedDepth = 0;	/*---how many QP_PedLock this thread hold---*/
+
+QP_PedLock::QP_PedLock() {
+	if (pedDepth++ == 0)
+		pedMutex.lock();
+}
+
+QP_PedLock::~QP_PedLock() {
+	if (--pedDepth == 0)
+		pedMutex.unlock();
+}
+
+QP_PedUnlock::QP_PedUnlock() {
+	_depth = pedDepth;
+	if (_depth) {
+		pedDepth = 0;
+		pedMutex.unlock();
+	}
+}
+
+QP_PedUnlock::~QP_PedUnlock() {
+	if (_depth) {
+		pedMutex.lock();
+		pedDepth = _depth;
+	}
+}
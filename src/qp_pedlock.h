@@ -0,0 +1,57 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+/* About QP_PedLock class:
+ *
+ * libparted keep its exception in globals (ped_exception_throw, the handler,
+ * ped_exception_fetch_all): two threads that throw together mix their errors
+ * or lose them. The commits of more devices run together (see
+ * QP_CommitScheduler), so a commit hold this lock while it call libparted.
+ *
+ * The lock is recursive in a thread. What is long and doesn't call libparted
+ * (an external tool, the copy of the data of a partition) release it with
+ * QP_PedUnlock: these parts of the commits run in parallel.
+ *
+ * The list of the devices of libparted has its own lock (see
+ * QP_DevList::pedListMutex), taken after this one and only for a moment.
+ * Don't wait for any other lock while holding this one.
+ */
+
+#ifndef QP_PEDLOCK_H
+#define QP_PEDLOCK_H
+
+class QP_PedLock {
+public:
+	QP_PedLock();
+	~QP_PedLock();
+};
+
+class QP_PedUnlock {
+public:
+	QP_PedUnlock();			/*---release it, if this thread hold it---*/
+	~QP_PedUnlock();		/*---and take it back---*/
+
+private:
+	int _depth;
+};
+
+#endif
@@ -0,0 +1,174 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include "qp_probecache.h"
+#include "qp_fswrap.h"
+#include "qp_debug.h"
+#include "statistics.h"
+
+#define SUPERBLOCK_BYTES 4096		/*---boot sector, fat, ntfs, ext*, xfs---*/
+#define SUPERBLOCK_BTRFS 65536		/*---btrfs keep it at 64KiB           ---*/
+
+QP_ProbeCache::QP_ProbeCache(PedDevice *dev) {
+	QDir().mkpath(PROBECACHE_DIR);
+
+	_cache = new QSettings(fileName(dev), QSettings::IniFormat);
+	_hits = 0;
+	_misses = 0;
+}
+
+QP_ProbeCache::~QP_ProbeCache() {
+	showDebug("probecache::~probecache, %d hits, %d misses\n", _hits, _misses);
+
+	_cache->sync();
+	delete _cache;
+}
+
+bool QP_ProbeCache::lookup(PedPartition *part, QP_PartInfo *partinfo) {
+	QString group = key(part);
+
+	if (!_cache->childGroups().contains(group))
+		goto miss;
+
+	/*---the used space of a mounted filesystem change every time---*/
+	if (!stamped(partinfo) || isMounted(partinfo))
+		goto miss;
+
+	_cache->beginGroup(group);
+
+	if ((_cache->value("fs").toString() != partinfo->fsspec->name())
+	 || (_cache->value("min_size", -1).toLongLong() < 0)
+	 || (_cache->value("hash").toByteArray() != superblockHash(part))) {
+		_cache->endGroup();
+		goto miss;
+	}
+
+	partinfo->_label = _cache->value("label").toString();
+	partinfo->min_size = _cache->value("min_size", -1).toLongLong();
+	_cache->endGroup();
+
+	_hits++;
+	return true;
+
+miss:
+	_misses++;
+	return false;
+}
+
+void QP_ProbeCache::store(PedPartition *part, QP_PartInfo *partinfo) {
+	/*---a failed probe (-1) must be done again the next time---*/
+	if ((partinfo->min_size < 0) || !stamped(partinfo) || isMounted(partinfo))
+		return;
+
+	/*---hash it now: the probe itself may have touched the superblock---*/
+	QByteArray hash = superblockHash(part);
+	if (hash.isEmpty())
+		return;
+
+	_cache->beginGroup(key(part));
+	_cache->setValue("fs", partinfo->fsspec->name());
+	_cache->setValue("hash", hash);
+	_cache->setValue("label", partinfo->_label);
+	_cache->setValue("min_size", (qlonglong)partinfo->min_size);
+	_cache->endGroup();
+}
+
+void QP_ProbeCache::invalidate(QString device) {
+	/*---ped_device_get doesn't open the device: it is cheap---*/
+	QP_DevList::pedListMutex()->lock();
+	PedDevice *dev = ped_device_get(device.toLatin1().constData());
+	QP_DevList::pedListMutex()->unlock();
+	if (!dev)
+		return;
+
+	showDebug("probecache::invalidate, %s\n", device.toLatin1().data());
+	QFile::remove(fileName(dev));
+}
+
+/*---WWN or serial number of the disk, so the cache follow the disk and not
+ *   the /dev name (that can change between two boot)---*/
+QString QP_ProbeCache::deviceId(PedDevice *dev) {
+	QString name = QString(dev->path).section('/', -1);
+	QString id;
+
+	QStringList files;
+	files << "/sys/block/" + name + "/wwid"
+	      << "/sys/block/" + name + "/device/wwid"
+	      << "/sys/block/" + name + "/device/serial";
+
+	for (const QString &file : files) {
+		QFile f(file);
+		if (f.open(QIODevice::ReadOnly)) {
+			id = QString(f.readAll()).trimmed();
+			if (!id.isEmpty())
+				break;
+		}
+	}
+
+	/*---no identity in sysfs: model and size is better than nothing---*/
+	if (id.isEmpty())
+		id = QString("%1-%2-%3").arg(dev->model).arg(dev->length).arg(dev->sector_size);
+
+	id.replace(QRegExp("[^A-Za-z0-9._-]"), "_");
+	return id;
+}
+
+QString QP_ProbeCache::fileName(PedDevice *dev) {
+	return QString("%1/%2.cache").arg(PROBECACHE_DIR).arg(deviceId(dev));
+}
+
+QString QP_ProbeCache::key(PedPartition *part) {
+	return QString("%1-%2-%3")
+		.arg(part->geom.start)
+		.arg(part->geom.end)
+		.arg(part->geom.length);
+}
+
+/*---ext*, xfs, btrfs, reiserfs and jfs keep free counts (or a generation) in
+ *   the superblock, updated by every write: ntfs and fat don't---*/
+bool QP_ProbeCache::stamped(QP_PartInfo *partinfo) {
+	QString name = partinfo->fsspec->name();
+
+	return (name != "ntfs") && !name.startsWith("fat");
+}
+
+QByteArray QP_ProbeCache::superblockHash(PedPartition *part) {
+	long long sector_size = part->disk->dev->sector_size;
+	PedSector count = (SUPERBLOCK_BYTES + sector_size - 1) / sector_size;
+	QByteArray buffer(count * sector_size, 0);
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+
+	if (!QP_FSWrap::read_sector(part, 0, count, buffer.data()))
+		return QByteArray();
+	hash.addData(buffer);
+
+	PedSector btrfs = SUPERBLOCK_BTRFS / sector_size;
+	if (btrfs + count <= part->geom.length) {
+		if (!QP_FSWrap::read_sector(part, btrfs, count, buffer.data()))
+			return QByteArray();
+		hash.addData(buffer);
+	}
+
+	return hash.result();
+}
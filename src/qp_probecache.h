@@ -0,0 +1,65 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* About QP_ProbeCache class:
+ *
+ * The label and the used space of a partition cost a mount or an external
+ * tool run. QP_ProbeCache keep them on disk (under PROBECACHE_DIR), one file
+ * for every device. The device is identified by its WWN/serial (from sysfs),
+ * the partition by start/end/length, and the entry is valid only while the
+ * hash of the superblock area is the same that was saved with it.
+ *
+ * Mounted partitions are never cached: their used space change every time.
+ * Neither are ntfs and fat: nothing in their superblock change when a file
+ * is written, so the hash would not see that the used space is different.
+ */
+
+#ifndef QP_PROBECACHE_H
+#define QP_PROBECACHE_H
+
+#include <QByteArray>
+#include <QSettings>
+#include <QString>
+#include <parted/parted.h>
+#include "qp_libparted.h"
+
+#define PROBECACHE_DIR "/var/cache/qparted"
+
+class QP_ProbeCache {
+public:
+	QP_ProbeCache(PedDevice *);
+	~QP_ProbeCache();
+	bool lookup(PedPartition *, QP_PartInfo *);	/*---fill label and min_size if cached---*/
+	void store(PedPartition *, QP_PartInfo *);	/*---save label and min_size           ---*/
+	static void invalidate(QString);		/*---forget everything about a device   ---*/
+
+private:
+	static QString deviceId(PedDevice *);
+	static QString fileName(PedDevice *);
+	static QString key(PedPartition *);
+	static QByteArray superblockHash(PedPartition *);
+	static bool stamped(QP_PartInfo *);
+	QSettings *_cache;
+	int _hits;
+	int _misses;
+};
+
+#endif
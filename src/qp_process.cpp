@@ -0,0 +1,309 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <QVector>
+#include "qp_process.h"
+#include "qp_debug.h"
+
+extern char **environ;
+
+QP_Process::QP_Process() {
+	_pid = -1;
+	_fd[Stdout] = -1;
+	_fd[Stderr] = -1;
+	_epoll = -1;
+	_next = Stdout;
+	_timeout = 0;
+	_cancel = NULL;
+	_stopped = false;
+}
+
+QP_Process::~QP_Process() {
+	if (_pid > 0) {
+		stop(QString("destroyed while running"));
+		wait();
+	}
+	closePipes();
+}
+
+void QP_Process::setTimeout(int msecs) {
+	_timeout = msecs;
+}
+
+void QP_Process::setCancel(const QAtomicInt *cancel) {
+	_cancel = cancel;
+}
+
+bool QP_Process::stopped() {
+	return _stopped;
+}
+
+QString QP_Process::message() {
+	return _message;
+}
+
+bool QP_Process::start(QStringList args, bool localized) {
+	int out[2], err[2];
+
+	_buffer[Stdout].clear();
+	_buffer[Stderr].clear();
+	_stopped = false;
+	_message = QString::null;
+
+	if (args.isEmpty())
+		return false;
+
+	showDebug("process::start, %s\n", args.join(" ").toLatin1().data());
+
+	/*---the read ends are not inherited by the tool (and by the tools other
+	 *   threads are starting at the same time)---*/
+	if (pipe2(out, O_CLOEXEC | O_NONBLOCK) != 0)
+		return false;
+	if (pipe2(err, O_CLOEXEC | O_NONBLOCK) != 0) {
+		close(out[0]);
+		close(out[1]);
+		return false;
+	}
+
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+	posix_spawn_file_actions_adddup2(&actions, out[1], 1);
+	posix_spawn_file_actions_adddup2(&actions, err[1], 2);
+
+	/*---a parsable language, unless the output is shown to the user---*/
+	QList<QByteArray> env;
+	for (char **e = environ; *e; e++)
+		if (localized || strncmp(*e, "LC_ALL=", 7) != 0)
+			env.append(QByteArray(*e));
+	if (!localized)
+		env.append("LC_ALL=POSIX");
+
+	QList<QByteArray> argList;
+	for (const QString &arg : args)
+		argList.append(arg.toLocal8Bit());
+
+	QVector<char *> argv, envp;
+	for (QByteArray &a : argList)
+		argv.append(a.data());
+	argv.append(NULL);
+	for (QByteArray &e : env)
+		envp.append(e.data());
+	envp.append(NULL);
+
+	int rc = posix_spawnp(&_pid, argv[0], &actions, NULL, argv.data(), envp.data());
+	posix_spawn_file_actions_destroy(&actions);
+	close(out[1]);
+	close(err[1]);
+
+	if (rc != 0) {
+		showDebug("process::start, %s: %s\n", argv[0], strerror(rc));
+		_message = QString(strerror(rc));
+		_pid = -1;
+		close(out[0]);
+		close(err[0]);
+		return false;
+	}
+
+	_fd[Stdout] = out[0];
+	_fd[Stderr] = err[0];
+
+	_epoll = epoll_create1(EPOLL_CLOEXEC);
+	for (int s = Stdout; s <= Stderr; s++) {
+		struct epoll_event ev;
+		memset(&ev, 0, sizeof ev);
+		ev.events = EPOLLIN;
+		ev.data.u32 = s;
+		epoll_ctl(_epoll, EPOLL_CTL_ADD, _fd[s], &ev);
+	}
+
+	_elapsed.start();
+	return true;
+}
+
+/*---a line (without its end) from the buffer of a stream, if there is one---*/
+bool QP_Process::takeLine(int s, QByteArray *line) {
+	QByteArray &buffer = _buffer[s];
+	const char *data = buffer.constData();
+	int size = buffer.size();
+	int look = (size < PROCESS_MAXLINE) ? size : PROCESS_MAXLINE;
+	int i;
+
+	for (i = 0; i < look; i++)
+		if ((data[i] == '\n') || (data[i] == '\r') || (data[i] == '\b'))
+			break;
+
+	if (i == look) {
+		/*---no end: give it back only if it is too long, or the pipe is closed---*/
+		if ((size < PROCESS_MAXLINE) && (_fd[s] >= 0))
+			return false;
+		if (size == 0)
+			return false;
+		*line = buffer.left(PROCESS_MAXLINE);
+		buffer.remove(0, line->size());
+		return true;
+	}
+
+	*line = buffer.left(i);
+
+	/*---"\r\n" and a run of \b are a single end---*/
+	int end = i + 1;
+	if ((data[i] == '\r') && (end < size) && (data[end] == '\n'))
+		end++;
+	else if (data[i] == '\b')
+		while ((end < size) && (data[end] == '\b'))
+			end++;
+
+	buffer.remove(0, end);
+	return true;
+}
+
+/*---wait for something to read; false when both the pipes are closed---*/
+bool QP_Process::fill() {
+	while ((_fd[Stdout] >= 0) || (_fd[Stderr] >= 0)) {
+		if (_cancel && (_cancel->load() != 0) && !_stopped)
+			stop(QString("canceled"));
+		if ((_timeout > 0) && (_elapsed.elapsed() > _timeout) && !_stopped)
+			stop(QString("timed out after %1 ms").arg(_timeout));
+
+		/*---a child of the tool could keep the pipes open: don't wait for it---*/
+		if (_stopped) {
+			closePipes();
+			return true;
+		}
+
+		struct epoll_event events[2];
+		int n = epoll_wait(_epoll, events, 2, PROCESS_POLL);
+
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			closePipes();
+			return false;
+		}
+
+		bool got = false;
+		for (int e = 0; e < n; e++) {
+			int s = events[e].data.u32;
+			char chunk[4096];
+
+			ssize_t r;
+			while ((r = read(_fd[s], chunk, sizeof chunk)) > 0) {
+				_buffer[s].append(chunk, r);
+				got = true;
+			}
+
+			/*---EOF (or an error): no more data on this stream---*/
+			if ((r == 0) || ((r < 0) && (errno != EAGAIN) && (errno != EINTR))) {
+				epoll_ctl(_epoll, EPOLL_CTL_DEL, _fd[s], NULL);
+				close(_fd[s]);
+				_fd[s] = -1;
+				got = true;
+			}
+		}
+
+		if (got)
+			return true;
+	}
+
+	return false;
+}
+
+bool QP_Process::getLine(QByteArray *line, Stream *stream) {
+	if (_pid <= 0)
+		return false;
+
+	while (true) {
+		/*---take turns between stdout and stderr---*/
+		for (int k = 0; k < 2; k++) {
+			int s = (_next + k) % 2;
+			if (takeLine(s, line)) {
+				_next = (s + 1) % 2;
+				if (stream)
+					*stream = (Stream)s;
+				return true;
+			}
+		}
+
+		if (!fill())
+			return false;
+	}
+}
+
+int QP_Process::wait() {
+	int status = -1;
+
+	if (_pid <= 0)
+		return -1;
+
+	/*---nobody read the rest: the tool must not block on a full pipe---*/
+	closePipes();
+
+	while ((waitpid(_pid, &status, 0) < 0) && (errno == EINTR))
+		;
+	_pid = -1;
+
+	showDebug("process::wait, status %d%s\n", status, _stopped ? ", stopped" : "");
+	return _stopped ? -1 : status;
+}
+
+/*---SIGTERM, and SIGKILL if it doesn't exit in a couple of seconds---*/
+void QP_Process::stop(QString reason) {
+	if (_pid <= 0)
+		return;
+
+	showDebug("process::stop, %s\n", reason.toLatin1().data());
+	_stopped = true;
+	_message = reason;
+
+	kill(_pid, SIGTERM);
+	for (int i = 0; i < 20; i++) {
+		siginfo_t info;
+		info.si_pid = 0;
+
+		/*---WNOWAIT: it is reaped by "wait"---*/
+		if ((waitid(P_PID, _pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0) && (info.si_pid != 0))
+			return;
+		usleep(100 * 1000);
+	}
+	kill(_pid, SIGKILL);
+}
+
+void QP_Process::closePipes() {
+	for (int s = Stdout; s <= Stderr; s++) {
+		if (_fd[s] >= 0) {
+			close(_fd[s]);
+			_fd[s] = -1;
+		}
+	}
+	if (_epoll >= 0) {
+		close(_epoll);
+		_epoll = -1;
+	}
+}
@@ -0,0 +1,81 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* About QP_Process class:
+ *
+ * Run an external tool (mkfs, ntfsresize, mount...) and read what it print.
+ * The tool is started with posix_spawnp from an argument list (no shell, so
+ * a label with spaces is one argument), stdout and stderr are two pipes
+ * watched with epoll in the thread that call getLine: no thread is spent
+ * for a tool, so many of them can run together.
+ *
+ * A line end with \n, \r or a run of \b: mkfs and ntfsresize redraw their
+ * progress with \r and \b, and every redraw is a line. A line longer than
+ * PROCESS_MAXLINE is cut in pieces, it is never lost.
+ *
+ * The tool is stopped (SIGTERM, then SIGKILL) after "setTimeout" msecs or
+ * as soon as the flag given to "setCancel" is set.
+ */
+
+#ifndef QP_PROCESS_H
+#define QP_PROCESS_H
+
+#include <sys/types.h>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QStringList>
+
+#define PROCESS_MAXLINE (64 * 1024)	/*---longest line given back in one piece---*/
+#define PROCESS_POLL    250		/*---msecs between two checks of the cancel flag---*/
+
+class QP_Process {
+public:
+	enum Stream { Stdout = 0, Stderr = 1 };
+
+	QP_Process();
+	~QP_Process();				/*---stop the tool if it is still running---*/
+	bool start(QStringList, bool localized = false); /*---args[0] is the tool---*/
+	bool getLine(QByteArray *, Stream *stream = NULL); /*---false when the tool closed both---*/
+	int wait();				/*---exit status like pclose, -1 if stopped---*/
+	void setTimeout(int);			/*---msecs, 0 for never---*/
+	void setCancel(const QAtomicInt *);	/*---stop the tool when it is not 0---*/
+	bool stopped();				/*---canceled or timed out---*/
+	QString message();
+
+private:
+	bool takeLine(int, QByteArray *);
+	bool fill();
+	void stop(QString);
+	void closePipes();
+	pid_t _pid;
+	int _fd[2];
+	int _epoll;
+	QByteArray _buffer[2];
+	int _next;			/*---stream to look at first, so none starve---*/
+	int _timeout;
+	const QAtomicInt *_cancel;
+	QElapsedTimer _elapsed;
+	bool _stopped;
+	QString _message;
+};
+
+#endif
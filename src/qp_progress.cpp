@@ -0,0 +1,157 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QThread>
+#include <QTimer>
+#include "qp_progress.h"
+#include "qp_debug.h"
+
+QP_Progress::QP_Progress(QObject *parent)
+	: QObject(parent) {
+	_pending.percent = 0;
+	_pending.bytesDone = 0;
+	_pending.bytesTotal = 0;
+	_pending.rate = 0;
+	_pending.eta = -1;
+	_dirty = false;
+	_restart = true;
+	_last = _pending;
+	_lastDone = 0;
+	_lastMsecs = 0;
+	_rate = 0;
+	_updates = 0;
+}
+
+QP_Progress::~QP_Progress() {
+	if (_updates)
+		showDebug("progress::~progress, %d reports, %d updates sent\n",
+			  _reports.load(), _updates);
+}
+
+void QP_Progress::begin(qint64 bytes) {
+	QMutexLocker locker(&_mutex);
+	_pending.percent = 0;
+	_pending.bytesTotal = bytes;
+	_restart = true;
+}
+
+void QP_Progress::report(int percent, QString state, QString timeleft) {
+	_reports.ref();
+
+	_mutex.lock();
+	_pending.percent = percent;
+	_pending.state = state;
+	_pending.timeleft = timeleft;
+	_dirty = true;
+	_mutex.unlock();
+
+	/*---in its own thread (a scan without event loop): send it if it's time---*/
+	if (QThread::currentThread() == thread()) {
+		if ((percent >= 100) || !_frame.isValid() || (_frame.elapsed() >= PROGRESS_FRAME))
+			flush();
+		return;
+	}
+
+	/*---from another thread: one flush for every frame, not one every report---*/
+	if (_scheduled.testAndSetOrdered(0, 1))
+		QMetaObject::invokeMethod(this, "schedule", Qt::QueuedConnection);
+}
+
+void QP_Progress::schedule() {
+	int wait = 0;
+
+	_mutex.lock();
+	bool done = (_pending.percent >= 100);
+	_mutex.unlock();
+
+	/*---the end of a step is not delayed---*/
+	if (!done && _frame.isValid())
+		wait = qMax((qint64)0, PROGRESS_FRAME - _frame.elapsed());
+
+	QTimer::singleShot(wait, this, SLOT(flush()));
+}
+
+QP_ProgressInfo QP_Progress::last() {
+	return _last;
+}
+
+void QP_Progress::flush() {
+	_mutex.lock();
+	QP_ProgressInfo info = _pending;
+	bool dirty = _dirty;
+	bool restart = _restart;
+	_dirty = false;
+	_restart = false;
+	_scheduled.store(0);
+	_mutex.unlock();
+
+	if (!dirty)
+		return;
+
+	if (restart || !_clock.isValid()) {
+		_clock.start();
+		_lastDone = 0;
+		_lastMsecs = 0;
+		_rate = 0;
+	}
+
+	/*---without the size of the step the average is on the percent---*/
+	qint64 total = info.bytesTotal ? info.bytesTotal : 100;
+	qint64 done = total * qBound(0, info.percent, 100) / 100;
+	qint64 msecs = _clock.elapsed();
+
+	if (done < _lastDone) {
+		/*---a new phase of the timer started from 0---*/
+		_rate = 0;
+		_lastDone = done;
+		_lastMsecs = msecs;
+	} else if (msecs > _lastMsecs) {
+		double rate = (done - _lastDone) * 1000.0 / (msecs - _lastMsecs);
+		_rate = (_rate == 0) ? rate : PROGRESS_EMA * rate + (1 - PROGRESS_EMA) * _rate;
+		_lastDone = done;
+		_lastMsecs = msecs;
+	}
+
+	info.bytesDone = info.bytesTotal ? done : 0;
+	info.rate = info.bytesTotal ? _rate : 0;
+	info.eta = (_rate > 0) ? (int)((total - done) / _rate) : -1;
+
+	/*---the average is steadier than the prediction of the timer---*/
+	if ((info.eta >= 0) && (info.percent > 0) && (info.percent < 100))
+		info.timeleft.sprintf("%.2d:%.2d", info.eta / 60, info.eta % 60);
+
+	_last = info;
+	_updates++;
+	_frame.start();
+
+	emit sigTimer(info.percent, info.state, info.timeleft);
+	emit sigProgress(info);
+
+	if (!_log.isValid() || (_log.elapsed() >= PROGRESS_LOG) || (info.percent >= 100)) {
+		_log.start();
+		showDebug("progress::flush, %d%% %s, %lld of %lld bytes, %.0f bytes/s, eta %d s\n",
+			  info.percent, info.state.toLatin1().data(),
+			  info.bytesDone, info.bytesTotal, info.rate, info.eta);
+	}
+}
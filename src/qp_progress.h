@@ -0,0 +1,101 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+/* About QP_Progress class:
+ *
+ * The progress of the operation in progress on a device. Libparted's timer
+ * and the output parsers of the wrappers (ntfsresize, mkfs.ext*...) report
+ * here as often as they like, from any thread: "report" just keep the last
+ * value and never wait for the GUI.
+ *
+ * The updates are sent at most every PROGRESS_FRAME msecs, in the thread of
+ * the QP_Progress: "sigTimer" (the old signal of QP_LibParted) and
+ * "sigProgress", with the bytes done, the throughput (an exponential moving
+ * average) and the time left. The GUI, the JSON of the batch mode and the
+ * debug log all read the same updates.
+ */
+
+#ifndef QP_PROGRESS_H
+#define QP_PROGRESS_H
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QMetaType>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+
+#define PROGRESS_FRAME 100	/*---msecs between two updates        ---*/
+#define PROGRESS_EMA   0.3	/*---weight of the last throughput    ---*/
+#define PROGRESS_LOG   1000	/*---msecs between two lines of log   ---*/
+
+struct QP_ProgressInfo {
+	int percent;
+	QString state;
+	QString timeleft;	/*---"mm:ss", empty if not known      ---*/
+	qint64 bytesDone;
+	qint64 bytesTotal;	/*---0 if the size of the step is not known---*/
+	double rate;		/*---bytes per second, 0 if not known ---*/
+	int eta;		/*---seconds left, -1 if not known    ---*/
+};
+
+Q_DECLARE_METATYPE(QP_ProgressInfo)
+
+class QP_Progress : public QObject {
+	Q_OBJECT
+public:
+	QP_Progress(QObject *parent = 0);
+	~QP_Progress();
+	void begin(qint64);			/*---a new step, of some bytes (0: not known)---*/
+	void report(int, QString, QString);	/*---percent, state, time left: any thread---*/
+	QP_ProgressInfo last();			/*---the last update sent            ---*/
+
+public slots:
+	void flush();				/*---send the last value now         ---*/
+
+signals:
+	void sigTimer(int, QString, QString);
+	void sigProgress(const QP_ProgressInfo &);
+
+private slots:
+	void schedule();
+
+private:
+	QMutex _mutex;				/*---guard _pending, _dirty and _restart---*/
+	QP_ProgressInfo _pending;
+	bool _dirty;
+	bool _restart;
+	QAtomicInt _scheduled;			/*---a flush is already on its way   ---*/
+
+	QP_ProgressInfo _last;			/*---only in the thread of the object---*/
+	QElapsedTimer _frame;			/*---since the last update           ---*/
+	QElapsedTimer _clock;			/*---since the start of the step     ---*/
+	QElapsedTimer _log;
+	qint64 _lastDone;
+	qint64 _lastMsecs;
+	double _rate;
+
+	QAtomicInt _reports;			/*---statistics, logged at the end   ---*/
+	int _updates;
+};
+
+#endif
@@ -0,0 +1,92 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <QMutexLocker>
+#include "qp_scanpool.h"
+#include "qp_actlist.h"
+#include "qp_debug.h"
+
+/*----------QP_ScanJob---------------------------------------------------------------*/
+QP_ScanJob::QP_ScanJob(QP_ScanPool *pool, QP_PartInfo *partinfo)
+	: _pool(pool), _partinfo(partinfo) {
+	setAutoDelete(true);
+}
+
+void QP_ScanJob::run() {
+	showDebug("scanjob::run, probing %s\n", _partinfo->partname().toLatin1().data());
+
+	QString error;
+
+	/*---the partinfo is not touched by the caller until "next" return it---*/
+	_partinfo->min_size = QP_ActionList::probe_min_size(_partinfo, &error);
+
+	_pool->done(_partinfo, error);
+}
+
+/*----------QP_ScanPool--------------------------------------------------------------*/
+QP_ScanPool::QP_ScanPool(int maxJobs) {
+	_pending = 0;
+
+	if (maxJobs < 1)
+		maxJobs = 1;
+	_threads.setMaxThreadCount(maxJobs);
+
+	showDebug("scanpool::scanpool, %d jobs\n", maxJobs);
+}
+
+QP_ScanPool::~QP_ScanPool() {
+	/*---never leave a thread writing into a partinfo---*/
+	_threads.waitForDone();
+}
+
+void QP_ScanPool::add(QP_PartInfo *partinfo) {
+	_mutex.lock();
+	_pending++;
+	_mutex.unlock();
+
+	_threads.start(new QP_ScanJob(this, partinfo));
+}
+
+QP_PartInfo *QP_ScanPool::next() {
+	QMutexLocker locker(&_mutex);
+
+	while (_done.isEmpty() && _pending > 0)
+		_cond.wait(&_mutex);
+
+	if (_done.isEmpty())
+		return NULL;
+
+	_pending--;
+	_error = _errors.takeFirst();
+	return _done.takeFirst();
+}
+
+QString QP_ScanPool::error() {
+	return _error;
+}
+
+void QP_ScanPool::done(QP_PartInfo *partinfo, QString error) {
+	QMutexLocker locker(&_mutex);
+
+	_done.append(partinfo);
+	_errors.append(error);
+	_cond.wakeOne();
+}
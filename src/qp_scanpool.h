@@ -0,0 +1,77 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* About QP_ScanPool class:
+ *
+ * Getting the used space of a partition means mounting it (or running an
+ * external tool like ntfsresize), and that is slow. QP_ScanPool run these
+ * probes in a small pool of threads, so a disk with many partitions is
+ * scanned in parallel. The caller queue the partitions with "add" and then
+ * collect them, one by one as they finish, with "next".
+ *
+ * Only the probe of the used space is done in the threads: everything that
+ * touch libparted (PedDevice/PedDisk are not thread safe) stay in the caller.
+ */
+
+#ifndef QP_SCANPOOL_H
+#define QP_SCANPOOL_H
+
+#include <QList>
+#include <QMutex>
+#include <QRunnable>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include "qp_libparted.h"
+
+class QP_ScanPool;
+
+class QP_ScanJob : public QRunnable {
+public:
+	QP_ScanJob(QP_ScanPool *, QP_PartInfo *);
+	void run();
+
+private:
+	QP_ScanPool *_pool;
+	QP_PartInfo *_partinfo;
+};
+
+class QP_ScanPool {
+	friend class QP_ScanJob;
+public:
+	QP_ScanPool(int maxJobs);
+	~QP_ScanPool();
+	void add(QP_PartInfo *);	/*---queue the probe of a partition            ---*/
+	QP_PartInfo *next();		/*---wait for a probe, NULL if none is pending ---*/
+	QString error();		/*---error of the last partition returned      ---*/
+
+private:
+	void done(QP_PartInfo *, QString);
+	QThreadPool _threads;
+	QMutex _mutex;
+	QWaitCondition _cond;
+	QList<QP_PartInfo *> _done;
+	QList<QString> _errors;
+	QString _error;
+	int _pending;
+};
+
+#endif
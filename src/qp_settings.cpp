@@ -21,34 +21,38 @@
 
 #include "qp_settings.h"
 #include "qp_common.h"
+#include "qp_probecache.h"
 #include <QStringList>
-#include <QFile>
+#include <QThread>
+#include <QMutexLocker>
 #include <cstdio>
-#include <cstdlib>
-
-static QString findApp(QString const &name) {
-	QStringList s=QString(getenv("PATH")).split(':');
-	// Add locations where external applications are commonly found...
-	s << "/sbin" << "/usr/sbin" << "/usr/local/sbin" << "/opt/local/sbin" << "/bin" << "/usr/bin" << "/usr/local/bin" << "/opt/local/bin";
-	foreach(QString const p, s) {
-		QString const guess=p + "/" + name;
-		if(QFile::exists(guess))
-			return guess;
-	}
-	return QString::null;
-}
 
 QP_Settings::QP_Settings():settings(QSettings::SystemScope, "QtParted", "QtParted") {
 	_layout = settings.value("/qtparted/layout", 0).toInt();
-
-	QString mkntfs_path = settings.value("/qtparted/mkntfs", findApp("mkntfs")).toString();
-	QString ntfsresize_path = settings.value("/qtparted/ntfsresize", findApp("ntfsresize")).toString();
-	QString mkfs_ext3_path = settings.value("/qtparted/mkfs.ext3", findApp("mkfs.ext3")).toString();
-	QString mkfs_jfs_path = settings.value("/qtparted/mkfs.jfs", findApp("mkfs.jfs")).toString();
-	QString mkfs_xfs_path = settings.value("/qtparted/mkfs.xfs", findApp("mkfs.xfs")).toString();
-	QString mount_path = settings.value("/qtparted/mount", findApp("mount")).toString();
-	QString umount_path = settings.value("/qtparted/umount", findApp("umount")).toString();
-	QString xfs_growfs_path = settings.value("/qtparted/xfs_growfs", findApp("xfs_growfs")).toString();
+	_scanJobs = settings.value("/qtparted/scan_jobs", QThread::idealThreadCount()).toInt();
+	if (_scanJobs < 1)
+		_scanJobs = 1;
+	_copyQueueDepth = qBound(1, settings.value("/qtparted/copy_queue_depth", 8).toInt(), 64);
+	_copyBlockSize = settings.value("/qtparted/copy_block_size", 1024).toInt();
+	_copyBlockSize = qBound(64, _copyBlockSize - (_copyBlockSize % 4), 65536);
+	_commitJobs = qBound(1, settings.value("/qtparted/commit_jobs", 4).toInt(), 64);
+	_commitSerializeBus = settings.value("/qtparted/commit_serialize_bus", false).toBool();
+
+	QString mkntfs_path = settings.value("/qtparted/mkntfs").toString();
+	QString ntfsresize_path = settings.value("/qtparted/ntfsresize").toString();
+	QString mkfs_ext3_path = settings.value("/qtparted/mkfs.ext3").toString();
+	QString mkfs_jfs_path = settings.value("/qtparted/mkfs.jfs").toString();
+	QString mkfs_xfs_path = settings.value("/qtparted/mkfs.xfs").toString();
+	QString mount_path = settings.value("/qtparted/mount").toString();
+	QString umount_path = settings.value("/qtparted/umount").toString();
+	QString xfs_growfs_path = settings.value("/qtparted/xfs_growfs").toString();
+	QString mkswap_path = settings.value("/qtparted/mkswap").toString();
+	QString mkfs_ext2_path = settings.value("/qtparted/mkfs.ext2").toString();
+	QString mkfs_ext4_path = settings.value("/qtparted/mkfs.ext4").toString();
+	QString mkfs_btrfs_path = settings.value("/qtparted/mkfs.btrfs").toString();
+	QString mkdosfs_path = settings.value("/qtparted/mkdosfs").toString();
+
+	/*---an empty path is looked for the first time the tool is needed---*/
 
 	lstExternalTools->add("mkntfs", 
 			  mkntfs_path,
@@ -74,6 +78,21 @@ QP_Settings::QP_Settings():settings(QSettings::SystemScope, "QtParted", "QtParte
 	lstExternalTools->add("xfs_growfs",
 			  xfs_growfs_path,
 			  QObject::tr("Utility for grow a xfs filesystem."));
+	lstExternalTools->add("mkswap",
+			  mkswap_path,
+			  QObject::tr("A program that create swap partitions."));
+	lstExternalTools->add("mkfs.ext2",
+			  mkfs_ext2_path,
+			  QObject::tr("A program that create EXT2 partitions."));
+	lstExternalTools->add("mkfs.ext4",
+			  mkfs_ext4_path,
+			  QObject::tr("A program that create EXT4 partitions."));
+	lstExternalTools->add("mkfs.btrfs",
+			  mkfs_btrfs_path,
+			  QObject::tr("A program that create BTRFS partitions."));
+	lstExternalTools->add("mkdosfs",
+			  mkdosfs_path,
+			  QObject::tr("A program that create FAT partitions."));
 }
 
 QP_Settings::~QP_Settings() {
@@ -95,6 +114,11 @@ void QP_Settings::setLayout(int layout) {
 	QString mount_path = lstExternalTools->getPath("mount");
 	QString umount_path = lstExternalTools->getPath("umount");
 	QString xfs_growfs_path = lstExternalTools->getPath("xfs_growfs");
+	QString mkswap_path = lstExternalTools->getPath("mkswap");
+	QString mkfs_ext2_path = lstExternalTools->getPath("mkfs.ext2");
+	QString mkfs_ext4_path = lstExternalTools->getPath("mkfs.ext4");
+	QString mkfs_btrfs_path = lstExternalTools->getPath("mkfs.btrfs");
+	QString mkdosfs_path = lstExternalTools->getPath("mkdosfs");
 
 	settings.setValue("/qtparted/mkntfs", mkntfs_path);
 	settings.setValue("/qtparted/ntfsresize", ntfsresize_path);
@@ -104,9 +128,70 @@ void QP_Settings::setLayout(int layout) {
 	settings.setValue("/qtparted/mount", mount_path);
 	settings.setValue("/qtparted/umount", umount_path);
 	settings.setValue("/qtparted/xfs_growfs", xfs_growfs_path);
+	settings.setValue("/qtparted/mkswap", mkswap_path);
+	settings.setValue("/qtparted/mkfs.ext2", mkfs_ext2_path);
+	settings.setValue("/qtparted/mkfs.ext4", mkfs_ext4_path);
+	settings.setValue("/qtparted/mkfs.btrfs", mkfs_btrfs_path);
+	settings.setValue("/qtparted/mkdosfs", mkdosfs_path);
+}
+
+int QP_Settings::scanJobs() {
+	return _scanJobs;
+}
+
+void QP_Settings::setScanJobs(int jobs) {
+	if (jobs < 1)
+		jobs = 1;
+
+	settings.setValue("/qtparted/scan_jobs", jobs);
+	_scanJobs = jobs;
+}
+
+int QP_Settings::copyQueueDepth() {
+	return _copyQueueDepth;
+}
+
+void QP_Settings::setCopyQueueDepth(int depth) {
+	depth = qBound(1, depth, 64);
+
+	settings.setValue("/qtparted/copy_queue_depth", depth);
+	_copyQueueDepth = depth;
+}
+
+int QP_Settings::copyBlockSize() {
+	return _copyBlockSize;
+}
+
+void QP_Settings::setCopyBlockSize(int kbytes) {
+	/*---O_DIRECT want multiples of 4KiB---*/
+	kbytes = qBound(64, kbytes - (kbytes % 4), 65536);
+
+	settings.setValue("/qtparted/copy_block_size", kbytes);
+	_copyBlockSize = kbytes;
+}
+
+int QP_Settings::commitJobs() {
+	return _commitJobs;
+}
+
+void QP_Settings::setCommitJobs(int jobs) {
+	jobs = qBound(1, jobs, 64);
+
+	settings.setValue("/qtparted/commit_jobs", jobs);
+	_commitJobs = jobs;
+}
+
+bool QP_Settings::commitSerializeBus() {
+	return _commitSerializeBus;
+}
+
+void QP_Settings::setCommitSerializeBus(bool serialize) {
+	settings.setValue("/qtparted/commit_serialize_bus", serialize);
+	_commitSerializeBus = serialize;
 }
 
 time_t QP_Settings::getDevUpdate(QString device) {
+	QMutexLocker locker(&_devUpdateMutex);
 	QString entry = QString("%1%2")
 			.arg("/qtparted")
 			.arg(device);
@@ -120,6 +205,7 @@ time_t QP_Settings::getDevUpdate(QString device) {
 }
 
 void QP_Settings::setDevUpdate(QString device, time_t time) {
+	QMutexLocker locker(&_devUpdateMutex);
 	QString entry = QString("%1%2")
 					.arg("/qtparted")
 					.arg(device);
@@ -128,4 +214,7 @@ void QP_Settings::setDevUpdate(QString device, time_t time) {
 	sprintf(buf, "%lld", (long long)time);
 
 	settings.setValue(entry, buf);
+
+	/*---the device was changed: the probe cache is stale---*/
+	QP_ProbeCache::invalidate(device);
 }
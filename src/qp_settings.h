@@ -27,6 +27,7 @@
 #include <time.h>
 #include <qobject.h>
 #include <QSettings>
+#include <QMutex>
 #ifndef QP_SETTINGS_H
 #define QP_SETTINGS_H
 
@@ -39,8 +40,24 @@ public:
 	void setLayout(int);
 	time_t getDevUpdate(QString);	   //get the last time that a device was updated (ie commited)
 	void setDevUpdate(QString, time_t); //the device was commit, so save the time!
+	int scanJobs();			    //how many partitions can be probed at the same time
+	void setScanJobs(int);
+	int copyQueueDepth();		    //how many blocks a move/copy keep in flight
+	void setCopyQueueDepth(int);
+	int copyBlockSize();		    //KiB read/written at a time by a move/copy
+	void setCopyBlockSize(int);
+	int commitJobs();		    //how many devices can be committed at the same time
+	void setCommitJobs(int);
+	bool commitSerializeBus();	    //commit one device at a time on every controller
+	void setCommitSerializeBus(bool);
 private:
 	QSettings settings;
+	QMutex _devUpdateMutex;		    //devices committed together update it from their threads
 	int _layout;
+	int _scanJobs;
+	int _copyQueueDepth;
+	int _copyBlockSize;
+	int _commitJobs;
+	bool _commitSerializeBus;
 };
 #endif
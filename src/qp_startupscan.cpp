@@ -0,0 +1,98 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include <QMutexLocker>
+#include "qp_startupscan.h"
+#include "qp_debug.h"
+
+QP_StartupScan::QP_StartupScan(QList<QP_Device *> devices) {
+	_devices = devices;
+	_current = NULL;
+	_libparted = NULL;
+	_stop = false;
+}
+
+QP_StartupScan::~QP_StartupScan() {
+	_mutex.lock();
+	_stop = true;
+	if (_libparted)
+		_libparted->cancel();
+	_mutex.unlock();
+
+	wait();
+}
+
+void QP_StartupScan::claim(QP_Device *device) {
+	QMutexLocker locker(&_mutex);
+
+	_claimed.insert(device);
+	while (_current == device)
+		_cond.wait(&_mutex);
+}
+
+void QP_StartupScan::run() {
+	showTrace("startupscan::run, %d devices\n", _devices.count());
+
+	for (QP_Device *device : _devices) {
+		_mutex.lock();
+		if (_stop) {
+			_mutex.unlock();
+			break;
+		}
+		if (_claimed.contains(device)) {
+			_mutex.unlock();
+			continue;
+		}
+		_current = device;
+		_mutex.unlock();
+
+		device->probe();
+		showTrace("startupscan::run, %s probed\n", device->shortname().toLatin1().data());
+
+		/*---the scan is done by the QP_ActionList that setDevice make---*/
+		if (device->partitionTable()) {
+			QP_LibParted *libparted = new QP_LibParted();
+
+			_mutex.lock();
+			_libparted = _stop ? NULL : libparted;
+			_mutex.unlock();
+
+			if (_libparted) {
+				libparted->setDevice(device);
+				showTrace("startupscan::run, %s scanned\n", device->shortname().toLatin1().data());
+			}
+
+			_mutex.lock();
+			_libparted = NULL;
+			_mutex.unlock();
+
+			delete libparted;
+		}
+
+		_mutex.lock();
+		_current = NULL;
+		_cond.wakeAll();
+		_mutex.unlock();
+	}
+
+	showTrace("%s", "startupscan::run, done\n");
+}
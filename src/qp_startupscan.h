@@ -0,0 +1,65 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+/* About QP_StartupScan class:
+ *
+ * With --fast-start the main window is shown as soon as the devices are
+ * listed. This thread then, one device at a time, probe the partition table
+ * and scan the partitions with its own QP_LibParted: what the scan find
+ * (labels, used space) go in the QP_ProbeCache, so when the user open the
+ * device its scan is served from the cache.
+ *
+ * Before the GUI scan a device it must "claim" it: a device that is being
+ * scanned is waited for, a device not yet scanned is skipped.
+ */
+
+#ifndef QP_STARTUPSCAN_H
+#define QP_STARTUPSCAN_H
+
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QThread>
+#include <QWaitCondition>
+#include "qp_devlist.h"
+#include "qp_libparted.h"
+
+class QP_StartupScan : public QThread {
+public:
+	QP_StartupScan(QList<QP_Device *>);
+	~QP_StartupScan();		/*---stop the scan and wait for the thread---*/
+	void claim(QP_Device *);	/*---the GUI is going to scan this device---*/
+
+protected:
+	void run() override;
+
+private:
+	QList<QP_Device *> _devices;
+	QSet<QP_Device *> _claimed;
+	QP_Device *_current;		/*---the device being scanned---*/
+	QP_LibParted *_libparted;	/*---and its scanner, to cancel the tools---*/
+	bool _stop;
+	QMutex _mutex;
+	QWaitCondition _cond;
+};
+
+#endif
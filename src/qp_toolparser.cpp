@@ -0,0 +1,225 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <string.h>
+#include <QCoreApplication>
+#include <QHash>
+#include <QRegularExpression>
+#include "qp_toolparser.h"
+#include "qp_debug.h"
+
+#define TR(text) QT_TRANSLATE_NOOP("QP_ToolParser", text)
+
+/*---the grammars of the tools: the first rule that match a line win---*/
+
+static const QP_ToolRule mountRules[] = {
+	{ -1, "mount: ", "^mount: (.*)$", ToolFailure, 0, 0, -1, "%1" },
+	{ 0, NULL, NULL, ToolProgress, 0, 0, -1, NULL }
+};
+
+static const QP_ToolRule ntfsresizeRules[] = {
+	/*---" 34.72 percent completed", redrawn with \r: never 100% before the end---*/
+	{ -1, "percent completed", "(\\d+)[.,]\\d+ percent completed", ToolProgress, 0, 99, -1,
+	  TR("Resizing in progress.") },
+	{ -1, "ERROR", "^ERROR.*: (.*)", ToolFailure, 0, 0, -1, "%1" },
+	{ -1, "The volume end is fragmented", NULL, ToolFailure, 0, 0, -1,
+	  TR("The partition is fragmented.") },
+	{ -1, "resize at", "You ..... resize at \\d* bytes or (\\d*) ", ToolFailure, 0, 0, -1,
+	  TR("The partition is fragmented. Try to defragment it, or resize to %1MB") },
+	{ -1, "Syncing device", NULL, ToolProgress, 99, 99, -1, TR("Syncing device.") },
+	{ -1, "uccessfully", "[Ss]uccessfully", ToolSuccess, 0, 0, -1, NULL },
+	{ -1, "Nothing to do: NTFS volume size is already OK.", NULL, ToolSuccess, 0, 0, -1, NULL },
+	{ 0, NULL, NULL, ToolProgress, 0, 0, -1, NULL }
+};
+
+/*---ntfsresize -i: the smallest size, in bytes---*/
+static const QP_ToolRule ntfsinfoRules[] = {
+	{ -1, "resize at", "You ..... resize at (\\d*) bytes", ToolValue, 0, 0, -1, "%1" },
+	{ 0, NULL, NULL, ToolProgress, 0, 0, -1, NULL }
+};
+
+static const QP_ToolRule mkntfsRules[] = {
+	{ -1, "mkntfs completed successfully. Have a nice day.", NULL, ToolSuccess, 0, 0, -1, NULL },
+	{ -1, "ERROR", "^ERROR.*: (.*)", ToolFailure, 0, 0, -1, "%1" },
+	{ 0, NULL, NULL, ToolProgress, 0, 0, -1, NULL }
+};
+
+/*---"Writing inode tables:  3/40" then every redraw (after the \b) alone:
+ *   phase 1 is the inode tables, phase 2 the superblocks---*/
+static const QP_ToolRule mke2fsRules[] = {
+	{ -1, "Writing inode tables", "(\\d+)/(\\d+)", ToolProgress, 0, 80, 1,
+	  TR("Writing inode tables.") },
+	{ -1, "Writing inode tables", NULL, ToolProgress, 0, 0, 1, TR("Writing inode tables.") },
+	{ 1, "/", "^\\s*(\\d+)/(\\d+)\\s*$", ToolProgress, 0, 80, -1, TR("Writing inode tables.") },
+	{ -1, "Creating journal", NULL, ToolProgress, 90, 90, 0,
+	  TR("Writing superblocks and filesystem.") },
+	{ -1, "Writing superblocks and filesystem accounting information", "done\\s*$", ToolSuccess,
+	  0, 0, 0, NULL },
+	{ -1, "Writing superblocks and filesystem accounting information", NULL, ToolProgress, 95, 95, 2,
+	  TR("Writing superblocks and filesystem.") },
+	{ 2, "done", NULL, ToolSuccess, 0, 0, 0, NULL },
+	{ 0, NULL, NULL, ToolProgress, 0, 0, -1, NULL }
+};
+
+static const QP_ToolRule mkjfsRules[] = {
+	{ -1, "Format completed successfully.", NULL, ToolSuccess, 0, 0, -1, NULL },
+	{ 0, NULL, NULL, ToolProgress, 0, 0, -1, NULL }
+};
+
+/*---mkfs.xfs and xfs_growfs print the geometry at the end---*/
+static const QP_ToolRule xfsRules[] = {
+	{ -1, "realtime =", NULL, ToolSuccess, 0, 0, -1, NULL },
+	{ 0, NULL, NULL, ToolProgress, 0, 0, -1, NULL }
+};
+
+static const QP_ToolRule mkbtrfsRules[] = {
+	{ -1, "ERROR: ", "^ERROR: (.*)$", ToolFailure, 0, 0, -1, "%1" },
+	{ 0, NULL, NULL, ToolProgress, 0, 0, -1, NULL }
+};
+
+static const QP_ToolRule noRules[] = {
+	{ 0, NULL, NULL, ToolProgress, 0, 0, -1, NULL }
+};
+
+static const struct {
+	const char *tool;
+	const QP_ToolRule *rules;
+} grammars[] = {
+	{ "mount", mountRules },
+	{ "ntfsresize", ntfsresizeRules },
+	{ "ntfsresize-info", ntfsinfoRules },
+	{ "mkntfs", mkntfsRules },
+	{ "mke2fs", mke2fsRules },
+	{ "mkfs.jfs", mkjfsRules },
+	{ "mkfs.btrfs", mkbtrfsRules },
+	{ "mkfs.xfs", xfsRules },
+	{ "xfs_growfs", xfsRules },
+	{ NULL, NULL }
+};
+
+/*---all the patterns, compiled the first time (the init of a local static
+ *   is thread safe); QRegularExpression::match is const, so they can be
+ *   used by more commits at the same time---*/
+static const QHash<const QP_ToolRule *, QRegularExpression> &patterns() {
+	static const QHash<const QP_ToolRule *, QRegularExpression> compiled = [] {
+		QHash<const QP_ToolRule *, QRegularExpression> hash;
+
+		for (int g = 0; grammars[g].tool; g++) {
+			for (const QP_ToolRule *rule = grammars[g].rules; rule->key; rule++) {
+				if (!rule->pattern)
+					continue;
+
+				QRegularExpression rx(rule->pattern);
+				rx.optimize();
+				if (!rx.isValid())
+					showDebug("toolparser::patterns, %s: %s\n", rule->pattern,
+						  rx.errorString().toLatin1().data());
+				hash.insert(rule, rx);
+			}
+		}
+
+		return hash;
+	}();
+
+	return compiled;
+}
+
+QP_ToolParser::QP_ToolParser(const char *tool) {
+	_rules = noRules;
+	_phase = 0;
+	_lines = 0;
+	_regexps = 0;
+	_matches = 0;
+
+	for (int g = 0; grammars[g].tool; g++)
+		if (strcmp(grammars[g].tool, tool) == 0)
+			_rules = grammars[g].rules;
+
+	if (_rules == noRules)
+		showDebug("toolparser::toolparser, no grammar for %s\n", tool);
+}
+
+QP_ToolParser::~QP_ToolParser() {
+	showDebug("toolparser::~toolparser, %ld lines, %ld regexps run, %ld matches\n",
+		  _lines, _regexps, _matches);
+}
+
+bool QP_ToolParser::parse(const char *line, QP_ToolMatch *match) {
+	const char *start = line;
+	_lines++;
+
+	while ((*start == ' ') || (*start == '\t'))
+		start++;
+
+	for (const QP_ToolRule *rule = _rules; rule->key; rule++) {
+		if ((rule->phase >= 0) && (rule->phase != _phase))
+			continue;
+
+		/*---the cheap check first---*/
+		const char *found = strstr(line, rule->key);
+		if (!found)
+			continue;
+
+		QString cap1, cap2;
+
+		if (!rule->pattern) {
+			if (found != start)
+				continue;
+		} else {
+			_regexps++;
+			QRegularExpressionMatch m = patterns().value(rule)
+						    .match(QString::fromLocal8Bit(line));
+			if (!m.hasMatch())
+				continue;
+			cap1 = m.captured(1);
+			cap2 = m.captured(2);
+		}
+
+		_matches++;
+		if (rule->next >= 0)
+			_phase = rule->next;
+
+		match->event = rule->event;
+		match->percent = rule->from;
+
+		if (rule->event == ToolProgress) {
+			int span = rule->to - rule->from;
+			long long actual = cap1.toLongLong();
+			long long total = cap2.isEmpty() ? 100 : cap2.toLongLong();
+
+			if (!cap1.isEmpty() && (total > 0))
+				match->percent = rule->from + (int)(span * qBound(0LL, actual, total) / total);
+		}
+
+		if (!rule->text)
+			match->text = QString::null;
+		else if (strcmp(rule->text, "%1") == 0)
+			match->text = cap1;
+		else if (strstr(rule->text, "%1"))
+			match->text = QCoreApplication::translate("QP_ToolParser", rule->text).arg(cap1);
+		else
+			match->text = QCoreApplication::translate("QP_ToolParser", rule->text);
+
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,87 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* About QP_ToolParser class:
+ *
+ * Understand the lines printed by the external tools (see QP_Process). The
+ * output of every tool is described by a grammar, a table of rules in
+ * qp_toolparser.cpp: to follow a new tool (or a new version of its output)
+ * just add a table there.
+ *
+ * A rule is tried only if the line contain its "key", a plain string looked
+ * for with strstr: most of the lines (the progress redraws above all) are
+ * discarded without running any regexp. The patterns are compiled once, the
+ * first time a parser is made, and they are shared by all the threads.
+ *
+ * A parser has a "phase" (mke2fs print "3/40" both for the group tables
+ * and for the inode tables): a rule can be limited to a phase, and can
+ * move the parser to another one.
+ */
+
+#ifndef QP_TOOLPARSER_H
+#define QP_TOOLPARSER_H
+
+#include <QString>
+
+/*---what a line of a tool mean---*/
+enum QP_ToolEvent {
+	ToolProgress,	/*---percent and state for the progress bar---*/
+	ToolSuccess,	/*---the tool did its work---*/
+	ToolFailure,	/*---text is the error---*/
+	ToolValue	/*---text is a value asked to the tool---*/
+};
+
+struct QP_ToolRule {
+	int phase;		/*---tried only in this phase, -1 always                 ---*/
+	const char *key;	/*---the line must contain it; without a pattern
+				 *   it must start with it (blanks skipped)             ---*/
+	const char *pattern;	/*---a regexp for the captures, or NULL                 ---*/
+	QP_ToolEvent event;
+	int from;		/*---progress: cap(1)/cap(2), or cap(1) percent, or just
+				 *   "from" without captures, scaled in from..to         ---*/
+	int to;
+	int next;		/*---the phase after this line, -1 the same             ---*/
+	const char *text;	/*---state or message, "%1" is cap(1)                   ---*/
+};
+
+struct QP_ToolMatch {
+	QP_ToolEvent event;
+	int percent;
+	QString text;
+};
+
+class QP_ToolParser {
+public:
+	QP_ToolParser(const char *tool);	/*---"mke2fs", "ntfsresize"...---*/
+	~QP_ToolParser();
+	bool parse(const char *, QP_ToolMatch *);	/*---false if the line mean nothing---*/
+
+private:
+	const QP_ToolRule *_rules;
+	int _phase;
+
+	/*---statistics, logged at the end: how many lines needed a regexp---*/
+	long _lines;
+	long _regexps;
+	long _matches;
+};
+
+#endif
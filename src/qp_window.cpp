@@ -35,6 +35,7 @@
 #include "qp_window.h"
 #include "qp_filesystem.h"
 #include "qp_fswrap.h"
+#include "qp_debug.h"
 
 #include "xpm/tool_disk.xpm"
 #include "xpm/tool_property.xpm"
@@ -43,6 +44,7 @@
 #include "xpm/tool_move.xpm"
 #include "xpm/tool_quit.xpm"
 #include "xpm/tool_undo.xpm"
+#include "xpm/tool_redo.xpm"
 #include "xpm/tool_save.xpm"
 #include "xpm/tool_new.xpm"
 #include "xpm/tool_format.xpm"
@@ -57,6 +59,9 @@ QP_MainWindow::QP_MainWindow(QP_Settings *qpsettings, QWidget *parent)
     /*---load the setting from disk---*/
     settings = qpsettings;
 
+    /*---nothing copied yet---*/
+    _copyDevice = NULL;
+
     createAction();
     setupToolBar();
     setupMenuBar();
@@ -115,6 +120,8 @@ QP_MainWindow::QP_MainWindow(QP_Settings *qpsettings, QWidget *parent)
 	navSplit->setStretchFactor(navSplit->indexOf(navview), 0);
 	/*---connect the selected signal (when user, for example, select /dev/hda)---*/
 	connect(navview, &QP_NavView::deviceSelected, this, &QP_MainWindow::slotSelectDevice);
+	/*---the disks are probed in background: the menu grow with the list---*/
+	connect(navview, &QP_NavView::devicesChanged, this, &QP_MainWindow::buildDisksMenu);
 
 	/*---add the DiskView widget---*/
 	diskview = new QP_DiskView(navSplit);
@@ -124,10 +131,12 @@ QP_MainWindow::QP_MainWindow(QP_Settings *qpsettings, QWidget *parent)
 	/*---emit when the user want to popup the context menu---*/
 	connect(diskview, &QP_DiskView::sigPopup, this, &QP_MainWindow::slotPopup);
 	connect(diskview, &QP_DiskView::sigDevicePopup, this, &QP_MainWindow::slotDevicePopup);
-	/*---connect the sigTimer used for dlgprogress during "update progressbar"---*/
-	connect(diskview, &QP_DiskView::sigTimer, dlgprogress, &QDialog::slotTimer);
+	/*---the updates of dlgprogress during "update progressbar", at most every PROGRESS_FRAME msecs---*/
+	connect(diskview->libparted->progress(), &QP_Progress::sigProgress, dlgprogress, &QP_dlgProgress::slotProgress);
 	/*---connect the sigTimer used for dlgprogress during "commit operations"---*/
-	connect(diskview, &QP_DiskView::sigOperations, dlgprogress, &QDialog::slotOperations);
+	connect(diskview, &QP_DiskView::sigOperations, dlgprogress, &QP_dlgProgress::slotOperations);
+	/*---the "Cancel" button of dlgprogress stop the commit---*/
+	connect(dlgprogress, &QP_dlgProgress::sigCancel, diskview, &QP_DiskView::cancel);
 	/*---connect the sigDiskChanged used for undo/commit---*/
 	connect(diskview, &QP_DiskView::sigDiskChanged, this, &QP_MainWindow::slotDiskChanged);
 }
@@ -136,10 +145,10 @@ QP_MainWindow::~QP_MainWindow()
 {
 }
 
-void QP_MainWindow::init()
+void QP_MainWindow::init(bool fast)
 {
     emit sigSplashInfo(tr("Getting devices"));
-    navview->init();
+    navview->init(fast);
 
     /*---now populate the disks menu---*/
     buildDisksMenu();
@@ -149,6 +158,7 @@ void QP_MainWindow::init()
     loadSettings();
 
     emit sigSplashInfo(tr("Ready"));
+    showTrace("%s", "window::init\n");
 }
 
 void QP_MainWindow::refreshDiskView()
@@ -186,6 +196,14 @@ void QP_MainWindow::createAction()
     actUndo->setEnabled(false);
     connect(actUndo, &QAction::activated, this, &QP_MainWindow::slotUndo);
 
+    // Redo button (used in File menu)
+    actRedo = new QAction(tr("&Redo"), this);
+    actRedo->setIcon(QIcon(QStringLiteral(":/xpm/tool_redo.xpm")));
+    actRedo->setToolTip(tr("Redo"));
+    actRedo->setWhatsThis(tr("Redo last undone operation"));
+    actRedo->setEnabled(false);
+    connect(actRedo, &QAction::activated, this, &QP_MainWindow::slotRedo);
+
     // Commit button (used in File menu)
     actCommit = new QAction(tr("&Commit"), this);
     actCommit->setIcon(QIcon(QStringLiteral(":/xpm/tool_save.xpm")));
@@ -245,6 +263,22 @@ void QP_MainWindow::createAction()
 	connect ( actMove, &QAction::triggered,
 			  this, &QP_MainWindow::slotMove );
 
+	/*---Copy button (used in operations menu)---*/
+	actCopy = new QAction ( tr ( "&Copy" ), this );
+	actCopy->setToolTip ( tr ( "Copy" ) );
+	actCopy->setWhatsThis ( tr ( "Copy a partition, then paste it in a free space of the same disk" ) );
+	actCopy->setEnabled ( false );
+	connect ( actCopy, &QAction::triggered,
+			  this, &QP_MainWindow::slotCopy );
+
+	/*---Paste button (used in operations menu)---*/
+	actPaste = new QAction ( tr ( "&Paste" ), this );
+	actPaste->setToolTip ( tr ( "Paste" ) );
+	actPaste->setWhatsThis ( tr ( "Make a copy of the partition copied in the selected free space" ) );
+	actPaste->setEnabled ( false );
+	connect ( actPaste, &QAction::triggered,
+			  this, &QP_MainWindow::slotPaste );
+
 	/*---Delete button (used in operations menu)---*/
 	actDelete = new QAction ( tr ( "&Delete" ), this );
 	actDelete->setIcon ( QIcon ( QStringLiteral(":/xpm/tool_delete.xpm") ) );
@@ -313,6 +347,7 @@ void QP_MainWindow::setupMenuBar()
     /*---File menu---*/
     QMenu *mnuFile = menuBar()->addMenu(tr("&File"));
     mnuFile->addAction(actUndo);
+    mnuFile->addAction(actRedo);
     mnuFile->addAction(actCommit);
     //
     mnuFile->addSeparator();
@@ -326,6 +361,8 @@ void QP_MainWindow::setupMenuBar()
     mnuOperations->addAction(actFormat);
     mnuOperations->addAction(actResize);
     mnuOperations->addAction(actMove);
+    mnuOperations->addAction(actCopy);
+    mnuOperations->addAction(actPaste);
     mnuOperations->addAction(actDelete);
     //
     mnuOperations->addSeparator();
@@ -350,6 +387,7 @@ void QP_MainWindow::setupMenuBar()
     mnuDevice = menuBar()->addMenu(tr("&Device"));
     mnuDevice->setEnabled(false);
     mnuDevice->addAction(actUndo);
+    mnuDevice->addAction(actRedo);
     mnuDevice->addAction(actCommit);
 
     /*---Options menu---*/
@@ -432,6 +470,7 @@ void QP_MainWindow::setupToolBar()
     /*---Operations toolbar---*/
     QToolBar *toolUndoCommit = new QToolBar(this);
     toolUndoCommit->addAction(actUndo);
+    toolUndoCommit->addAction(actRedo);
     toolUndoCommit->addAction(actCommit);
 
     /*---Operations toolbar---*/
@@ -454,7 +493,8 @@ void QP_MainWindow::setupToolBar()
 
 void QP_MainWindow::buildDisksMenu()
 {
-    mnuDisks->addActions(navview->agDevices()->actions());
+    mnuDisks->clear();
+    mnuDisks->addActions(navview->deviceActions());
     navview->setPopup(_navpopupmenu);
 }
 
@@ -596,6 +636,48 @@ void QP_MainWindow::slotMove()
     ShowMoveResizeDialog(QTParted::move);
 }
 
+void QP_MainWindow::slotCopy()
+{
+    /*---there are no selected partitions!---*/
+    if (!diskview->selPartInfo())
+        return;
+
+    /*---remember where it is: the partinfo is rebuilt at every change---*/
+    _copyDevice = navview->selDevice();
+    _copyNum = diskview->selPartInfo()->num;
+    _copyStart = diskview->selPartInfo()->start;
+    _copyLength = diskview->selPartInfo()->end - diskview->selPartInfo()->start + 1;
+}
+
+void QP_MainWindow::slotPaste()
+{
+    /*---there are not selected partitions!---*/
+    if (!diskview->selPartInfo() || (_copyDevice != navview->selDevice()))
+        return;
+
+    /*---the partition copied could be moved or removed in the meantime---*/
+    QP_PartInfo *source = diskview->libparted->numToPartInfo(_copyNum);
+
+    if (!source || (source->start != _copyStart)
+        || (source->end - source->start + 1 != _copyLength)) {
+        QString label = tr("The partition copied has been changed: copy it again.");
+        QMessageBox::information(this, "QParted", label);
+        _copyDevice = NULL;
+        return;
+    }
+
+    QTParted::partType type = (diskview->selPartInfo()->type == QTParted::logical)
+                              ? QTParted::logical : QTParted::primary;
+
+    if (!source->copy(type, diskview->selPartInfo()->start)) {
+        QMessageBox::information(this, "QParted", diskview->libparted->message());
+        return;
+    }
+
+    /*---refresh diskview widget!---*/
+    refreshDiskView();
+}
+
 void QP_MainWindow::ShowMoveResizeDialog(QTParted::actType moveresize)
 {
     //FIXME: extended partition can be resized also on the "left"
@@ -675,6 +757,8 @@ void QP_MainWindow::InitMenu()
     actFormat->setEnabled(false);
     actResize->setEnabled(false);
     actMove->setEnabled(false);
+    actCopy->setEnabled(false);
+    actPaste->setEnabled(false);
     actDelete->setEnabled(false);
     actSetActive->setEnabled(false);
     actHide->setEnabled(false);
@@ -902,6 +986,8 @@ void QP_MainWindow::slotSelectPart(QP_PartInfo* partinfo) {
         actFormat->setEnabled(false);
         actResize->setEnabled(false);
         actMove->setEnabled(false);
+        actCopy->setEnabled(false);
+        actPaste->setEnabled(false);
         actDelete->setEnabled(false);
 
         return;
@@ -928,13 +1014,23 @@ void QP_MainWindow::slotSelectPart(QP_PartInfo* partinfo) {
 
         actResize->setEnabled(false);
         actMove->setEnabled(false);
+        actCopy->setEnabled(false);
         actDelete->setEnabled(false);
+
+        /*---paste: a partition of the same disk was copied, and it fit here---*/
+        actPaste->setEnabled(actCreate->isEnabled()
+                             && (_copyDevice == selDevice)
+                             && (partinfo->end - partinfo->start + 1 >= _copyLength));
     } else {
         bool resize = partinfo->fsspec->resize();
         bool move = partinfo->fsspec->move();
         actCreate->setEnabled(false);
         actDelete->setEnabled(true);
         actMove->setEnabled(move);
+        actPaste->setEnabled(false);
+
+        /*---the copy is made sector by sector: any filesystem can be copied---*/
+        actCopy->setEnabled((partinfo->type != QTParted::extended) && !partinfo->isVirtual());
 
         if (partinfo->type == QTParted::extended) {
             actResize->setEnabled(true);
@@ -1036,6 +1132,11 @@ void QP_MainWindow::slotUndo()
     diskview->undo();
 }
 
+void QP_MainWindow::slotRedo()
+{
+    diskview->redo();
+}
+
 void QP_MainWindow::slotCommit()
 {
 	QString label = QString ( tr ( "You're committing all changes. Warning, you can lose data!\n"
@@ -1053,6 +1154,7 @@ void QP_MainWindow::slotCommit()
 
 	/*---show a progress dialog for long operation---*/
 	InitProgressDialog();
+	dlgprogress->setCancelable(true);
 
 	diskview->commit();
 
@@ -1069,4 +1171,6 @@ void QP_MainWindow::slotDiskChanged()
 		actUndo->setEnabled(false);
 		actCommit->setEnabled(false);
 	}
+
+	actRedo->setEnabled(diskview->canRedo());
 }
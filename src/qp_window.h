@@ -52,7 +52,7 @@ class QP_MainWindow : public QMainWindow {
 public:
     QP_MainWindow(QP_Settings *, QWidget *parent);
     ~QP_MainWindow();
-    void init();           /*---init the mainwindow    ---*/
+    void init(bool fast = false); /*---init the mainwindow (fast: scan the disks later)---*/
     void refreshDiskView();
     void setpopupmenu(QMenu *);
 
@@ -61,6 +61,7 @@ protected:
     QMenu *mnuDisks;
     QMenu *mnuDevice;
     QAction *actUndo;
+    QAction *actRedo;
     QAction *actCommit;
     QAction *actQuit;
     QAction *actProperty;
@@ -68,6 +69,8 @@ protected:
     QAction *actFormat;
     QAction *actResize;
     QAction *actMove;
+    QAction *actCopy;
+    QAction *actPaste;
     QAction *actDelete;
     QAction *actConfig;
     QAction *actWhatThis;
@@ -106,12 +109,18 @@ private:
     QMenu *mnuOperations;
     int mnuSetActiveID;
     int mnuSetHiddenID;
+    QP_Device *_copyDevice;     /*---the partition copied: device...---*/
+    int _copyNum;               /*---...number...                   ---*/
+    PedSector _copyStart;       /*---...start and length            ---*/
+    PedSector _copyLength;
 
 protected slots:
     void slotCreate();
     void slotFormat();
     void slotResize();
     void slotMove();
+    void slotCopy();
+    void slotPaste();
     void slotDelete();
     void slotConfig();
     void slotProperty();
@@ -127,6 +136,7 @@ protected slots:
     void slotSetActive();
     void slotSetHidden();
     void slotUndo();
+    void slotRedo();
     void slotCommit();
     void slotDiskChanged();
 
@@ -49,7 +49,8 @@ public:
         create,
         active,
         hidden,
-        format
+        format,
+        copy
     };
 };
 
@@ -26,22 +26,30 @@
 #include <fcntl.h>
 #include <stdlib.h>
 #include <sys/vfs.h>
-#include <mntent.h>
 #include <sys/mount.h>
 #include <sys/param.h>  // MAXPATHLEN
 
-#include <qmessagebox.h>
 #include "statistics.h"
 #include "qp_filesystem.h"
 #include "qp_common.h"
+#include "qp_fsstats.h"
+#include "qp_mounttable.h"
 
 #define TMP_MOUNTPOINT "/tmp/mntqp"
+#define TMP_MOUNTPOINT_TEMPLATE TMP_MOUNTPOINT "-XXXXXX"
 #define KBYTE_SECTORS 2
 
 //------------------------------------------------
-PedSector space_stats(QP_PartInfo *partinfo) {
-	unsigned long a;
-	a = getFsUsedKiloBytes(partinfo);
+PedSector space_stats(QP_PartInfo *partinfo, QString *error) {
+	unsigned long a = 0;
+
+	/*---not mounted: read the used space from the filesystem metadata, no mount needed---*/
+	if (!isMounted(partinfo))
+		a = QP_FSStats::usedKiloBytes(partinfo);
+
+	/*---mounted, or a filesystem QP_FSStats doesn't know: use statfs---*/
+	if (a == 0)
+		a = getFsUsedKiloBytes(partinfo, error);
 
 	/*printf ("device(%s)=%lu KB used\n", partinfo->partname().toLatin1(), a);*/
 	if (a == 0) return -1;
@@ -67,30 +75,32 @@ int my_mount(QP_PartInfo *partinfo, const char *szMountPoint) {
 
 //---------------------------------------
 QString mountPoint(QP_PartInfo *partinfo) {
-	FILE *f;
-	struct mntent *mnt;
+	// the table is read again only if something was mounted or unmounted
+	QString mnt = QP_MountTable::mountPoint(partinfo->shortname());
 
-	if ((f = setmntent (MOUNTED, "r")) == 0)
-		return QString::null;
+	if (mnt.isEmpty() && isDevfsEnabled())
+		mnt = QP_MountTable::mountPoint(partinfo->longname());
+	return mnt;
+}
 
-	// loop: compare device with each mounted device
-	while (((mnt = getmntent (f)) != 0)) {
-		if ((partinfo->shortname().compare(mnt->mnt_fsname) == 0) || (isDevfsEnabled() && (partinfo->longname().compare(mnt->mnt_fsname) == 0))) {
-			endmntent(f);
-			return mnt->mnt_dir;
-		}
-	}
-	endmntent(f);
-	return QString::null;
+//---------------------------------------
+bool isMounted(QP_PartInfo *partinfo) {
+	if (QP_MountTable::busy(partinfo->shortname()))
+		return true;
+	return isDevfsEnabled() && QP_MountTable::busy(partinfo->longname());
 }
 
 //------------------------------------------------
-unsigned long getFsUsedKiloBytes(QP_PartInfo *partinfo) {
+// every partition get its own mountpoint: more partitions can be probed at
+// the same time (see QP_ScanPool). If error is not NULL the caller is not
+// the GUI thread, so the umount failure is returned instead of displayed.
+unsigned long getFsUsedKiloBytes(QP_PartInfo *partinfo, QString *error) {
 	struct statfs sfs;
 	unsigned long long a, b, c;
 	bool bToBeUnmounted;
 	unsigned long lResult = 0; // to be returned
 	QString mnt;
+	char szMountPoint[] = TMP_MOUNTPOINT_TEMPLATE;
 
 	// init
 	bToBeUnmounted = false;
@@ -99,12 +109,15 @@ unsigned long getFsUsedKiloBytes(QP_PartInfo *partinfo) {
 	
 	/*---if not mounted -> mount it---*/
 	if (mnt.isEmpty()) {
-		mkdir (TMP_MOUNTPOINT, 755);
-		int nRes = my_mount(partinfo, TMP_MOUNTPOINT);
-		if(nRes != 0) // Can't mount --> can't get statistics
+		if (!mkdtemp(szMountPoint))
 			return 0L;
+		int nRes = my_mount(partinfo, szMountPoint);
+		if(nRes != 0) { // Can't mount --> can't get statistics
+			rmdir(szMountPoint);
+			return 0L;
+		}
 		bToBeUnmounted = (nRes == 0);
-		mnt = TMP_MOUNTPOINT;
+		mnt = szMountPoint;
 	}
 
 	if (statfs(mnt.toLatin1(), &sfs) != -1) {
@@ -120,7 +133,12 @@ unsigned long getFsUsedKiloBytes(QP_PartInfo *partinfo) {
 			QString label = QObject::tr("Cannot umount partition device: %1."
 			                "Please do it by hand first to commit the changes!")
 			                .arg(partinfo->partname());
-			QMessageBox::information(NULL, "QtParted", label);
+			if (error)
+				*error = label;
+			else
+				showMessage(label);
+		} else {
+			rmdir(szMountPoint);
 		}
 	}
 
@@ -20,7 +20,8 @@
 #include "qp_libparted.h"
 
 QString mountPoint(QP_PartInfo *);
-unsigned long getFsUsedKiloBytes(QP_PartInfo *);
-int my_mount(QP_PartInfo *, char *szMountPoint);
-PedSector space_stats(QP_PartInfo *);
+bool isMounted(QP_PartInfo *);
+unsigned long getFsUsedKiloBytes(QP_PartInfo *, QString *error = NULL);
+int my_mount(QP_PartInfo *, const char *szMountPoint);
+PedSector space_stats(QP_PartInfo *, QString *error = NULL);
 
@@ -0,0 +1,130 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+/* About tst_hotplug:
+ *
+ * Attach a loop device on a small file with losetup, check that QP_HotPlug
+ * emit sigAdded for it, then detach it and check sigRemoved. It works with
+ * the uevent socket and with the sysfs polling as well (the timeout is more
+ * than HOTPLUG_POLL).
+ *
+ * losetup need root: without it (or without losetup and sysfs) the test is
+ * skipped.
+ */
+
+#include <unistd.h>
+#include <QDir>
+#include <QProcess>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryFile>
+#include <QtTest>
+#include "qp_hotplug.h"
+#include "qp_devlist.h"
+
+#define LOOP_BYTES   (8 * 1024 * 1024)
+#define LOOP_TIMEOUT (HOTPLUG_POLL + 3000)	/*---msecs for a signal---*/
+
+class TestHotPlug : public QObject {
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void attachDetach();
+	void cleanup();
+
+private:
+	static bool losetup(QStringList, QString *output = NULL);
+	static int count(const QSignalSpy &, QString);
+	QString _loop;		/*---attached by the test, detached by cleanup---*/
+};
+
+void TestHotPlug::initTestCase() {
+	if (geteuid() != 0)
+		QSKIP("losetup needs root");
+	if (QStandardPaths::findExecutable("losetup").isEmpty())
+		QSKIP("losetup not found");
+	if (!QDir(SYSBLOCK_DIR).exists())
+		QSKIP("no sysfs");
+}
+
+void TestHotPlug::attachDetach() {
+	QTemporaryFile file;
+	QVERIFY(file.open());
+	QVERIFY(file.resize(LOOP_BYTES));
+
+	QP_HotPlug hotplug;
+	QSignalSpy added(&hotplug, SIGNAL(sigAdded(QString)));
+	QSignalSpy removed(&hotplug, SIGNAL(sigRemoved(QString)));
+	hotplug.start(QP_DevList::discover());
+
+	/*---attach: the loop device go from 0 sectors to LOOP_BYTES---*/
+	QVERIFY(losetup(QStringList() << "--find" << "--show" << file.fileName(), &_loop));
+	QVERIFY(_loop.startsWith("/dev/loop"));
+
+	QTRY_VERIFY_WITH_TIMEOUT(count(added, _loop) > 0, LOOP_TIMEOUT);
+	QCOMPARE(count(added, _loop), 1);
+	QCOMPARE(count(removed, _loop), 0);
+
+	/*---detach: back to 0 sectors, the node in /dev stay---*/
+	QString loop = _loop;
+	QVERIFY(losetup(QStringList() << "--detach" << loop));
+	_loop.clear();
+
+	QTRY_VERIFY_WITH_TIMEOUT(count(removed, loop) > 0, LOOP_TIMEOUT);
+	QCOMPARE(count(removed, loop), 1);
+	QCOMPARE(count(added, loop), 1);
+}
+
+void TestHotPlug::cleanup() {
+	if (!_loop.isEmpty())
+		losetup(QStringList() << "--detach" << _loop);
+	_loop.clear();
+}
+
+/*---run losetup, with its stdout in output---*/
+bool TestHotPlug::losetup(QStringList args, QString *output) {
+	QProcess process;
+
+	process.start("losetup", args);
+	if (!process.waitForFinished())
+		return false;
+
+	if (output)
+		*output = QString(process.readAllStandardOutput()).trimmed();
+
+	return (process.exitStatus() == QProcess::NormalExit) && (process.exitCode() == 0);
+}
+
+/*---how many times the signal was emitted for this path---*/
+int TestHotPlug::count(const QSignalSpy &spy, QString path) {
+	int n = 0;
+
+	for (const QList<QVariant> &args : spy)
+		if (args.value(0).toString() == path)
+			n++;
+
+	return n;
+}
+
+QTEST_GUILESS_MAIN(TestHotPlug)
+#include "tst_hotplug.moc"
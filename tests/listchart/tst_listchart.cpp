@@ -0,0 +1,169 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+
+/* About tst_listchart:
+ *
+ * QP_ListChart::proportional is checked on LISTCHART_TABLES random tables
+ * (up to 128 partitions, some of them empty or tiny, widths from none to a
+ * 4K screen) and on a few corner cases. For every table:
+ *
+ *   - every partition is at least its minimum
+ *   - if the width is more than the minimums, the widths sum to it exactly
+ *   - a bigger partition is never narrower than a smaller one (same minimum)
+ *   - the partitions over their minimum are in proportion, to a pixel
+ *
+ * The seed is fixed, so a failure can be repeated.
+ */
+
+#include <math.h>
+#include <QtTest>
+#include "qp_listchart.h"
+
+#define LISTCHART_TABLES 2000
+#define LISTCHART_MAXPART 128
+#define LISTCHART_MINWIDTH 16
+
+class TestListChart : public QObject {
+	Q_OBJECT
+
+private slots:
+	void randomTables();
+	void cornerCases();
+
+private:
+	static QString check(const QVector<double> &, const QVector<int> &, int);
+	uint32_t random();
+	uint32_t _seed;
+};
+
+void TestListChart::randomTables() {
+	_seed = 1;
+
+	for (int table = 0; table < LISTCHART_TABLES; table++) {
+		int n = 1 + random() % LISTCHART_MAXPART;
+		QVector<double> sizes;
+		QVector<int> minimum;
+
+		for (int i = 0; i < n; i++) {
+			/*---sectors: mostly big, some tiny (a bios boot), some empty---*/
+			switch (random() % 10) {
+			case 0:
+				sizes.append(0);
+				break;
+			case 1:
+				sizes.append(random() % 4096);
+				break;
+			default:
+				sizes.append((double)random() * (1 + random() % 64));
+			}
+
+			/*---an extended ask more, for the minimum of its logicals---*/
+			minimum.append((random() % 20 == 0) ? LISTCHART_MINWIDTH * (2 + random() % 8) + 12
+							    : LISTCHART_MINWIDTH);
+		}
+
+		int width = random() % 4000;
+		QString error = check(sizes, minimum, width);
+		QVERIFY2(error.isEmpty(), qPrintable(QString("table %1, %2 partitions, width %3: %4")
+						     .arg(table).arg(n).arg(width).arg(error)));
+	}
+}
+
+void TestListChart::cornerCases() {
+	QVector<double> sizes;
+	QVector<int> minimum;
+
+	/*---no partitions---*/
+	QVERIFY(QP_ListChart::proportional(sizes, minimum, 100).isEmpty());
+
+	/*---one partition take everything---*/
+	sizes << 1;
+	minimum << LISTCHART_MINWIDTH;
+	QCOMPARE(QP_ListChart::proportional(sizes, minimum, 1000), QVector<int>() << 1000);
+
+	/*---all empty: the minimums, and the rest to the last---*/
+	sizes = QVector<double>() << 0 << 0 << 0;
+	minimum = QVector<int>() << 16 << 16 << 16;
+	QCOMPARE(QP_ListChart::proportional(sizes, minimum, 100), QVector<int>() << 16 << 16 << 68);
+	QCOMPARE(check(sizes, minimum, 100), QString());
+
+	/*---too narrow: the minimums, the chart has to grow---*/
+	sizes = QVector<double>() << 10 << 20 << 30;
+	QCOMPARE(QP_ListChart::proportional(sizes, minimum, 40), minimum);
+
+	/*---the pixel left by the rounding go to the largest remainder---*/
+	QCOMPARE(QP_ListChart::proportional(QVector<double>() << 5 << 3 << 2, minimum, 101),
+		 QVector<int>() << 51 << 30 << 20);
+}
+
+/*---the properties of a layout, an empty string if they hold---*/
+QString TestListChart::check(const QVector<double> &sizes, const QVector<int> &minimum, int width) {
+	QVector<int> widths = QP_ListChart::proportional(sizes, minimum, width);
+	int n = sizes.count();
+
+	if (widths.count() != n)
+		return QString("%1 widths for %2 partitions").arg(widths.count()).arg(n);
+
+	int sum = 0;
+	int mintotal = 0;
+	for (int i = 0; i < n; i++) {
+		if (widths.at(i) < minimum.at(i))
+			return QString("partition %1 is %2, under its minimum %3").arg(i).arg(widths.at(i)).arg(minimum.at(i));
+		sum += widths.at(i);
+		mintotal += minimum.at(i);
+	}
+
+	if (width <= mintotal)
+		return (widths == minimum) ? QString() : QString("not the minimums");
+
+	if (sum != width)
+		return QString("the widths sum to %1").arg(sum);
+
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < n; j++)
+			if ((minimum.at(i) == minimum.at(j)) && (sizes.at(i) > sizes.at(j)) && (widths.at(i) < widths.at(j)))
+				return QString("partition %1 is bigger than %2 but narrower").arg(i).arg(j);
+
+	/*---the partitions over the minimum got size * k pixels, for one k, less
+	 *   than a pixel away: so there is a k in all their ranges---*/
+	double low = 0;
+	double high = HUGE_VAL;
+	for (int i = 0; i < n; i++) {
+		if ((widths.at(i) <= minimum.at(i)) || (sizes.at(i) <= 0))
+			continue;
+		low = qMax(low, (widths.at(i) - 1) / sizes.at(i));
+		high = qMin(high, (widths.at(i) + 1) / sizes.at(i));
+	}
+	if (low >= high)
+		return QString("the widths are not in proportion to the sizes");
+
+	return QString();
+}
+
+uint32_t TestListChart::random() {
+	_seed = _seed * 1103515245 + 12345;
+	return _seed >> 8;
+}
+
+QTEST_GUILESS_MAIN(TestListChart)
+#include "tst_listchart.moc"
@@ -0,0 +1,109 @@
+/*
+	qparted - a frontend to libparted for manipulating disk partitions
+	Copyright (C) 2002-2003 Vanni Brutto; 2015 ZZYZX; 2021-2022 StarterX4
+
+	Vanni Brutto <zanac (-at-) libero dot it>
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+
+/* About tst_toolparser:
+ *
+ * Every file in transcripts/ is what a tool printed: it is given to "cat"
+ * through QP_Process (so the lines are cut by the real splitter, \r and \b
+ * included) and every line to a QP_ToolParser for the grammar in the name
+ * of the file. The events found must be the ones in the .events file near
+ * it, in the same order.
+ *
+ * To follow a new version of a tool, add its output and the events it must
+ * give: see transcripts/README.
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtTest>
+#include "qp_process.h"
+#include "qp_toolparser.h"
+
+class TestToolParser : public QObject {
+	Q_OBJECT
+
+private slots:
+	void transcript_data();
+	void transcript();
+
+private:
+	static QString format(const QP_ToolMatch &);
+};
+
+void TestToolParser::transcript_data() {
+	QTest::addColumn<QString>("grammar");
+	QTest::addColumn<QString>("path");
+
+	QDir dir(TRANSCRIPTS);
+	QStringList files = dir.entryList(QStringList() << "*.txt", QDir::Files, QDir::Name);
+	QVERIFY(!files.isEmpty());
+
+	for (const QString &file : files) {
+		/*---"ntfsresize.shrink.txt" is for the "ntfsresize" grammar---*/
+		QString grammar = file.section('.', 0, 0);
+		QTest::newRow(file.toLatin1().data()) << grammar << dir.filePath(file);
+	}
+}
+
+void TestToolParser::transcript() {
+	QFETCH(QString, grammar);
+	QFETCH(QString, path);
+
+	QFile expected(QFileInfo(path).path() + "/" + QFileInfo(path).completeBaseName() + ".events");
+	QVERIFY2(expected.open(QIODevice::ReadOnly), qPrintable(expected.fileName()));
+	QStringList want = QString(expected.readAll()).split('\n', QString::SkipEmptyParts);
+
+	QP_Process process;
+	QVERIFY(process.start(QStringList() << "cat" << path));
+
+	QP_ToolParser parser(grammar.toLatin1().data());
+	QStringList got;
+	QByteArray line;
+	QP_ToolMatch match;
+	while (process.getLine(&line))
+		if (parser.parse(line.data(), &match))
+			got << format(match);
+	QCOMPARE(process.wait(), 0);
+
+	QCOMPARE(got, want);
+}
+
+/*---an event as written in the .events files---*/
+QString TestToolParser::format(const QP_ToolMatch &match) {
+	switch (match.event) {
+	case ToolProgress:
+		return QString("progress %1 %2").arg(match.percent).arg(match.text);
+	case ToolSuccess:
+		return match.text.isEmpty() ? QString("success") : QString("success %1").arg(match.text);
+	case ToolFailure:
+		return QString("failure %1").arg(match.text);
+	case ToolValue:
+		return QString("value %1").arg(match.text);
+	}
+
+	return QString();
+}
+
+QTEST_GUILESS_MAIN(TestToolParser)
+#include "tst_toolparser.moc"